@@ -25,13 +25,9 @@ Document::Document(
     : table_(table),
       id_(id),
       kv_(nullptr),
-      value_(0),
       tokenOffset_(tokenOffset) {
   kv_ = table_->table()->getKVById(id);
   validator_.checkValid(id_, kv_);
-  if (validator_.isValid) {
-    value_ = uintptr_t(kv_->getRecordPtr(id_));
-  }
 }
 
 Document::Document(
@@ -43,14 +39,12 @@ Document::Document(
     : table_(table),
       id_(0),
       kv_(nullptr),
-      value_(0),
       tokenOffset_(tokenOffset) {
   const uint64_t* p = reinterpret_cast<const uint64_t*>(payload);
   id_ = *p;
   kv_ = table_->table()->getKVById(id_);
   validator_.checkValid(id_, kv_);
   if (validator_.isValid) {
-    value_ = uintptr_t(kv_->getRecordPtr(id_));
     index_.index = index;
     index_.indexNo = indexNo;
     index_.payload = uintptr_t(p + 1);
@@ -79,7 +79,6 @@ class Document {
   const ExtendedTable* table_;
   uint64_t id_;
   KV* kv_;
-  uintptr_t value_ : 48;
   uint16_t tokenOffset_;
   IndexAddr index_;
 };
@@ -132,8 +131,12 @@ inline std::optional<T> Document::get(size_t i) const {
       }
     }
     case FieldInfo::kValue: {
-      Record record = kv_->createRecord(reinterpret_cast<void*>(value_));
-      return record.get<T>(fi.meta);
+      // read under the version of the record, not torn by an update
+      std::optional<T> value;
+      kv_->read(id_, [&](const Record& record) {
+        value = record.get<T>(fi.meta);
+      });
+      return value;
     }
     case FieldInfo::kRelated: {
       uint64_t rid = *get<uint64_t>(fi.related.ref);
@@ -144,9 +147,11 @@ inline std::optional<T> Document::get(size_t i) const {
             << "rid=" << rid << "@" << rtable->config().name() << " get failed";
         break;
       }
-      Record record = rtable->getKVById(rid)->createRecord();
-      rtable->getKVById(rid)->get(rid, record);
-      return record.get<T>(fi.meta);
+      std::optional<T> value;
+      rtable->getKVById(rid)->read(rid, [&](const Record& record) {
+        value = record.get<T>(fi.meta);
+      });
+      return value;
     }
     case FieldInfo::kUnUsed:
       CRYSTAL_LOG(ERROR) << "get unused field: " << fi.meta.name();
@@ -68,6 +68,7 @@ void DocumentArray::copyTo(DynamicTable& table,
         COPY(uint64_t, UINT64)
         COPY(float, FLOAT)
         COPY(double, DOUBLE)
+        COPY(float16, FLOAT16)
         COPY(std::string_view, STRING)
 
 #undef COPY
@@ -49,7 +49,7 @@ class DocumentArray {
   size_t getFieldCount() const;
   size_t getTokenCount() const;
 
-  void incrementTokenCount();
+  void incrementTokenCount(size_t n = 1);
 
   const std::vector<std::string>& getFields() const;
   const FieldIndex& getFieldIndex() const;
@@ -100,8 +100,8 @@ inline size_t DocumentArray::getTokenCount() const {
   return tokenCount_;
 }
 
-inline void DocumentArray::incrementTokenCount() {
-  ++tokenCount_;
+inline void DocumentArray::incrementTokenCount(size_t n) {
+  tokenCount_ += n;
 }
 
 inline const std::vector<std::string>& DocumentArray::getFields() const {
@@ -124,6 +124,102 @@ std::string stringVPrintf(const char* format, va_list ap) {
   return ret;
 }
 
+namespace {
+
+const char* kBase64Chars =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// 64 on a non-base64 char
+struct Base64Table {
+  uint8_t value[256];
+
+  Base64Table() {
+    memset(value, 64, sizeof(value));
+    for (uint8_t i = 0; i < 64; ++i) {
+      value[uint8_t(kBase64Chars[i])] = i;
+    }
+  }
+};
+
+const Base64Table kBase64Table;
+
+} // namespace
+
+std::string base64Encode(std::string_view input) {
+  std::string output;
+  output.reserve((input.size() + 2) / 3 * 4);
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(input.data());
+  size_t n = input.size();
+  size_t i = 0;
+  for (; i + 3 <= n; i += 3) {
+    uint32_t v = (p[i] << 16) | (p[i + 1] << 8) | p[i + 2];
+    output.push_back(kBase64Chars[v >> 18]);
+    output.push_back(kBase64Chars[(v >> 12) & 0x3f]);
+    output.push_back(kBase64Chars[(v >> 6) & 0x3f]);
+    output.push_back(kBase64Chars[v & 0x3f]);
+  }
+  if (i < n) {
+    uint32_t v = p[i] << 16;
+    if (i + 1 < n) {
+      v |= p[i + 1] << 8;
+    }
+    output.push_back(kBase64Chars[v >> 18]);
+    output.push_back(kBase64Chars[(v >> 12) & 0x3f]);
+    output.push_back(i + 1 < n ? kBase64Chars[(v >> 6) & 0x3f] : '=');
+    output.push_back('=');
+  }
+  return output;
+}
+
+size_t base64DecodedSize(std::string_view input) {
+  if (input.size() % 4 != 0) {
+    return std::string_view::npos;
+  }
+  size_t size = input.size() / 4 * 3;
+  if (endsWith(input, "==")) {
+    size -= 2;
+  } else if (endsWith(input, '=')) {
+    size -= 1;
+  }
+  return size;
+}
+
+bool base64Decode(std::string_view input, void* out) {
+  size_t size = base64DecodedSize(input);
+  if (size == std::string_view::npos) {
+    return false;
+  }
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(input.data());
+  uint8_t* q = reinterpret_cast<uint8_t*>(out);
+  const uint8_t* table = kBase64Table.value;
+  size_t full = size / 3 * 4;
+  for (size_t i = 0; i < full; i += 4) {
+    uint8_t a = table[p[i]], b = table[p[i + 1]],
+            c = table[p[i + 2]], d = table[p[i + 3]];
+    if ((a | b | c | d) & 64) {
+      return false;
+    }
+    uint32_t v = (a << 18) | (b << 12) | (c << 6) | d;
+    *q++ = v >> 16;
+    *q++ = (v >> 8) & 0xff;
+    *q++ = v & 0xff;
+  }
+  size_t rest = size - size / 3 * 3;
+  if (rest > 0) {
+    uint8_t a = table[p[full]], b = table[p[full + 1]];
+    uint8_t c = rest == 2 ? table[p[full + 2]] : 0;
+    if ((a | b | c) & 64) {
+      return false;
+    }
+    uint32_t v = (a << 18) | (b << 12) | (c << 6);
+    *q++ = v >> 16;
+    if (rest == 2) {
+      *q++ = (v >> 8) & 0xff;
+    }
+  }
+  return true;
+}
+
 std::string errnoStr(int err) {
   int savedErrno = errno;
 
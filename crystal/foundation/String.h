@@ -61,6 +61,15 @@ inline std::string unhexlify(std::string_view input) {
   return output;
 }
 
+// standard alphabet, padded
+std::string base64Encode(std::string_view input);
+
+// size of the decoded bytes, npos if not a padded base64
+size_t base64DecodedSize(std::string_view input);
+
+// decode into out of base64DecodedSize(input) bytes, false on bad input
+bool base64Decode(std::string_view input, void* out);
+
 std::string errnoStr(int err);
 
 template <class Delim, class String, class OutputType>
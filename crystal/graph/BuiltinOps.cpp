@@ -15,7 +15,12 @@
  */
 
 #include "crystal/graph/OpRegistry.h"
+#include "crystal/graph/VectorParam.h"
+#include "crystal/operator/search/BooleanSearch.h"
+#include "crystal/operator/search/RangeSearch.h"
+#include "crystal/operator/search/Rerank.h"
 #include "crystal/operator/search/Search.h"
+#include "crystal/operator/search/TopKSearch.h"
 #include "crystal/operator/search/VectorSearch.h"
 
 namespace crystal {
@@ -28,21 +33,68 @@ static OpRegistryReceiver<QueryOp> searchQueryOp(
       auto limit = ctx.param.getDefault("payloadLimit", -1).asInt();
       auto mergeType = op::stringToMergeType(
           ctx.param.getDefault("mergeType", "Append").asString().c_str());
-      *ctx.view | search(tokens, key, limit, mergeType);
+      auto parallel = ctx.param.getDefault("parallel", 1).asInt();
+      *ctx.view | search(tokens, key, limit, mergeType, parallel, ctx.subflow);
+    });
+
+static OpRegistryReceiver<QueryOp> booleanSearchQueryOp(
+    "BooleanSearch",
+    [](OpContext& ctx) {
+      auto limit = ctx.param.getDefault("payloadLimit", -1).asInt();
+      *ctx.view | op::booleanSearch(ctx.param["expr"], limit);
+    });
+
+static OpRegistryReceiver<QueryOp> rangeSearchQueryOp(
+    "RangeSearch",
+    [](OpContext& ctx) {
+      auto key = ctx.param["key"].asString();
+      auto lo = ctx.param.getDefault("lo", "").asString();
+      auto hi = ctx.param.getDefault("hi", "").asString();
+      auto prefix = ctx.param.getDefault("prefix", "").asString();
+      auto limit = ctx.param.getDefault("payloadLimit", -1).asInt();
+      *ctx.view | op::RangeSearch(key, lo, hi, prefix, limit);
+    });
+
+static OpRegistryReceiver<QueryOp> topKSearchQueryOp(
+    "TopKSearch",
+    [](OpContext& ctx) {
+      auto tokens = ctx.param["tokens"].asString();
+      auto key = ctx.param["key"].asString();
+      auto k = ctx.param["k"].asInt();
+      auto appendScoreField =
+          ctx.param.getDefault("appendScoreField", "").asString();
+      *ctx.view | op::topKSearch(tokens, key, k, appendScoreField);
     });
 
 static OpRegistryReceiver<QueryOp> vSearchQueryOp(
     "VectorSearch",
     [](OpContext& ctx) {
       auto n = ctx.param["n"].asInt();
-      auto x = ctx.param["x"].asString();
+      // shared with the segment tasks on the subflow
+      auto x = std::make_shared<VectorParam>();
+      if (!x->parse(ctx.param["x"], ctx.attachments)) {
+        return;
+      }
       auto key = ctx.param["key"].asString();
       auto appendDistanceField = ctx.param["appendDistanceField"].asString();
-      auto segment = ctx.param["segment"].asInt();
+      auto segment = ctx.param.getDefault("segment", -1).asInt();
       auto k = ctx.param["k"].asInt();
-      auto xVector = toVector<float>(x);
-      Span<float> xSpan(xVector.data(), xVector.size());
-      *ctx.view | op::vSearch(n, xSpan, key, appendDistanceField, segment, k);
+      auto filter = ctx.param.getDefault("filter", false).asBool();
+      *ctx.view | op::vSearch(n, x->span(), key, appendDistanceField,
+                              segment, k, filter, ctx.subflow, x);
+    });
+
+static OpRegistryReceiver<QueryOp> rerankQueryOp(
+    "Rerank",
+    [](OpContext& ctx) {
+      auto n = ctx.param["n"].asInt();
+      VectorParam x;
+      if (!x.parse(ctx.param["x"], ctx.attachments)) {
+        return;
+      }
+      auto key = ctx.param["key"].asString();
+      auto appendDistanceField = ctx.param["appendDistanceField"].asString();
+      *ctx.view | op::rerank(n, x.span(), key, appendDistanceField);
     });
 
 }  // namespace crystal
@@ -39,7 +39,12 @@ class QueryOpVarTfVisitor {
 
   template <class T>
   tf::Task operator()(T& func) const {
-    return taskflow_->emplace([&]() { func(*ctx_); });
+    OpContext* ctx = ctx_;
+    return taskflow_->emplace([&func, ctx](tf::Subflow& subflow) {
+      ctx->subflow = &subflow;
+      func(*ctx);
+      ctx->subflow = nullptr;
+    });
   }
 
  private:
@@ -54,6 +59,7 @@ bool Graph::gen(const dynamic& graph) {
     OpContext ctx;
     ctx.view = nullptr;
     ctx.param = param;
+    ctx.attachments = attachments_;
     contexts_.emplace(nodeKey, ctx);
   }
   for (auto& node : graph.items()) {
@@ -109,6 +115,7 @@ bool Graph::genPipeline(const dynamic& pipeline) {
       OpContext ctx;
       ctx.view = pipelineCtx.view;
       ctx.param = param;
+      ctx.attachments = attachments_;
       QueryOpVarVisitor visitor(&ctx);
       std::visit(visitor, *func);
     }
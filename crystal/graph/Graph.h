@@ -25,7 +25,8 @@ class Graph {
  public:
   typedef tf::Executor Executor;
 
-  Graph(Executor* executor) : executor_(executor) {}
+  Graph(Executor* executor, const Attachments* attachments = nullptr)
+      : executor_(executor), attachments_(attachments) {}
 
   bool gen(const dynamic& graph);
   bool genPipeline(const dynamic& pipeline);
@@ -34,6 +35,7 @@ class Graph {
 
  private:
   Executor* executor_;
+  const Attachments* attachments_;
   tf::Taskflow taskflow_;
   std::unordered_map<std::string, OpContext> contexts_;
   std::unordered_map<std::string, tf::Task> tasks_;
@@ -18,15 +18,28 @@
 
 #include <functional>
 #include <map>
+#include <string>
+#include <string_view>
 #include <variant>
 
 #include "crystal/dataframe/DataView.h"
 
+namespace tf {
+class Subflow;
+}
+
 namespace crystal {
 
+// binary attachments of a query by name, viewed in place
+typedef std::map<std::string, std::string_view> Attachments;
+
 struct OpContext {
   DataView* view;
   dynamic param;
+  // of the query, ops resolve {attachment="name"} params with them
+  const Attachments* attachments{nullptr};
+  // set while the op runs as a graph task, for spawning subtasks
+  tf::Subflow* subflow{nullptr};
 };
 
 typedef std::function<void(OpContext&)> QueryOp;
@@ -0,0 +1,127 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/graph/VectorParam.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "crystal/foundation/Bits.h"
+#include "crystal/foundation/Conv.h"
+#include "crystal/foundation/Logging.h"
+#include "crystal/foundation/String.h"
+#include "crystal/foundation/json.h"
+
+namespace crystal {
+
+bool VectorParam::parse(const dynamic& param,
+                        const Attachments* attachments) {
+  if (param.isString()) {
+    return parseDecimals(param.getString());
+  }
+  if (param.isObject()) {
+    if (auto* p = param.get_ptr("base64")) {
+      return parseBase64(p->getString());
+    }
+    if (auto* p = param.get_ptr("raw")) {
+      return parseRaw(p->getString());
+    }
+    if (auto* p = param.get_ptr("attachment")) {
+      auto it = attachments ? attachments->find(p->asString())
+                            : Attachments::const_iterator();
+      if (!attachments || it == attachments->end()) {
+        CRYSTAL_LOG(ERROR) << "attachment '" << p->asString()
+            << "' not found";
+        return false;
+      }
+      return parseRaw(it->second);
+    }
+  }
+  CRYSTAL_LOG(ERROR) << "invalid vector param: " << toCson(param);
+  return false;
+}
+
+bool VectorParam::allocate(size_t n) {
+  size_t bytes = std::max(n * sizeof(float), kAlignment);
+  bytes = (bytes + kAlignment - 1) / kAlignment * kAlignment;
+  data_.reset(reinterpret_cast<float*>(aligned_alloc(kAlignment, bytes)));
+  if (!data_) {
+    CRYSTAL_LOG(ERROR) << "allocate " << n << " floats failed";
+    return false;
+  }
+  size_ = n;
+  return true;
+}
+
+bool VectorParam::parseDecimals(std::string_view sv) {
+  if (!allocate(std::count(sv.begin(), sv.end(), ',') + 1)) {
+    return false;
+  }
+  // empty ones are skipped
+  float* p = data_.get();
+  size_t n = 0;
+  while (!sv.empty()) {
+    size_t end = std::min(sv.find(','), sv.size());
+    auto item = trimWhitespace(sv.substr(0, end));
+    if (!item.empty()) {
+      p[n++] = to<float>(item);
+    }
+    sv.remove_prefix(std::min(end + 1, sv.size()));
+  }
+  size_ = n;
+  return true;
+}
+
+bool VectorParam::parseBase64(std::string_view sv) {
+  size_t bytes = base64DecodedSize(sv);
+  if (bytes == std::string_view::npos || bytes % sizeof(float) != 0) {
+    CRYSTAL_LOG(ERROR) << "invalid base64 size of floats: " << sv.size();
+    return false;
+  }
+  if (!allocate(bytes / sizeof(float))) {
+    return false;
+  }
+  if (!base64Decode(sv, data_.get())) {
+    CRYSTAL_LOG(ERROR) << "invalid base64 of floats";
+    return false;
+  }
+  toNative();
+  return true;
+}
+
+bool VectorParam::parseRaw(std::string_view sv) {
+  if (sv.size() % sizeof(float) != 0) {
+    CRYSTAL_LOG(ERROR) << "invalid raw size of floats: " << sv.size();
+    return false;
+  }
+  if (!allocate(sv.size() / sizeof(float))) {
+    return false;
+  }
+  memcpy(data_.get(), sv.data(), sv.size());
+  toNative();
+  return true;
+}
+
+void VectorParam::toNative() {
+  if (kIsBigEndian) {
+    float* p = data_.get();
+    for (size_t i = 0; i < size_; ++i) {
+      p[i] = Endian::little(p[i]);
+    }
+  }
+}
+
+}  // namespace crystal
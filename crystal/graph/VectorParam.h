@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdlib>
+#include <memory>
+
+#include "crystal/foundation/dynamic.h"
+#include "crystal/graph/OpRegistry.h"
+#include "crystal/math/Span.h"
+
+namespace crystal {
+
+/*
+ * Query vectors of an op param, decoded straight into a 64-byte
+ * aligned buffer. The param is one of
+ *
+ *   "1,0.5,..."       decimals, slow to parse on large batches
+ *   {base64="..."}    little-endian float32s in base64
+ *   {raw="..."}       little-endian float32s as a binary string
+ *   {attachment="x"}  little-endian float32s of a query attachment, read
+ *                     in place from the request body
+ */
+class VectorParam {
+ public:
+  static constexpr size_t kAlignment = 64;
+
+  VectorParam() {}
+
+  bool parse(const dynamic& param,
+             const Attachments* attachments = nullptr);
+
+  Span<float> span() const;
+
+ private:
+  struct Free {
+    void operator()(float* p) const { free(p); }
+  };
+
+  bool allocate(size_t n);
+  bool parseDecimals(std::string_view sv);
+  bool parseBase64(std::string_view sv);
+  bool parseRaw(std::string_view sv);
+  // the payload is little-endian
+  void toNative();
+
+  std::unique_ptr<float, Free> data_;
+  size_t size_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline Span<float> VectorParam::span() const {
+  return Span<float>(data_.get(), size_);
+}
+
+}  // namespace crystal
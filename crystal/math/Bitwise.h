@@ -0,0 +1,131 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace crystal {
+
+/*
+ * Word-wise bitmap kernels, dst may alias a or b.
+ * Buffers need not be aligned.
+ */
+
+// dst = a & b
+inline void bitwiseAnd(uint64_t* dst,
+                       const uint64_t* a,
+                       const uint64_t* b,
+                       size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 8 <= n; i += 8) {
+    __m512i x = _mm512_loadu_si512(a + i);
+    __m512i y = _mm512_loadu_si512(b + i);
+    _mm512_storeu_si512(dst + i, _mm512_and_si512(x, y));
+  }
+#elif defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_and_si256(x, y));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] = a[i] & b[i];
+  }
+}
+
+// dst = a | b
+inline void bitwiseOr(uint64_t* dst,
+                      const uint64_t* a,
+                      const uint64_t* b,
+                      size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 8 <= n; i += 8) {
+    __m512i x = _mm512_loadu_si512(a + i);
+    __m512i y = _mm512_loadu_si512(b + i);
+    _mm512_storeu_si512(dst + i, _mm512_or_si512(x, y));
+  }
+#elif defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_or_si256(x, y));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] = a[i] | b[i];
+  }
+}
+
+// dst = a & ~b
+inline void bitwiseAndNot(uint64_t* dst,
+                          const uint64_t* a,
+                          const uint64_t* b,
+                          size_t n) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 8 <= n; i += 8) {
+    __m512i x = _mm512_loadu_si512(a + i);
+    __m512i y = _mm512_loadu_si512(b + i);
+    _mm512_storeu_si512(dst + i, _mm512_andnot_si512(y, x));
+  }
+#elif defined(__AVX2__)
+  for (; i + 4 <= n; i += 4) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i),
+                        _mm256_andnot_si256(y, x));
+  }
+#endif
+  for (; i < n; ++i) {
+    dst[i] = a[i] & ~b[i];
+  }
+}
+
+inline size_t bitwiseCount(const uint64_t* a, size_t n) {
+  size_t i = 0;
+  size_t count = 0;
+#if defined(__AVX512VPOPCNTDQ__)
+  __m512i sum = _mm512_setzero_si512();
+  for (; i + 8 <= n; i += 8) {
+    sum = _mm512_add_epi64(
+        sum, _mm512_popcnt_epi64(_mm512_loadu_si512(a + i)));
+  }
+  count = _mm512_reduce_add_epi64(sum);
+#endif
+  for (; i + 4 <= n; i += 4) {
+    count += __builtin_popcountll(a[i])
+           + __builtin_popcountll(a[i + 1])
+           + __builtin_popcountll(a[i + 2])
+           + __builtin_popcountll(a[i + 3]);
+  }
+  for (; i < n; ++i) {
+    count += __builtin_popcountll(a[i]);
+  }
+  return count;
+}
+
+}  // namespace crystal
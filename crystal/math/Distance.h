@@ -0,0 +1,344 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__AVX512F__) || defined(__F16C__)
+#include <immintrin.h>
+#endif
+
+namespace crystal {
+
+/*
+ * Vector distance kernels of float32, float16 and int8, buffers need
+ * not be aligned. Half vectors are compared to float queries, int8
+ * vectors to int8 ones and summed in int32.
+ */
+
+// IEEE 754 half precision bits
+typedef uint16_t Half;
+
+inline float halfToFloat(Half h) {
+#if defined(__F16C__)
+  return _cvtsh_ss(h);
+#else
+  uint32_t sign = uint32_t(h & 0x8000) << 16;
+  uint32_t exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t bits;
+  if (exp == 0x1f) {
+    bits = sign | 0x7f800000 | (mant << 13);
+  } else if (exp != 0) {
+    bits = sign | ((exp + 112) << 23) | (mant << 13);
+  } else if (mant == 0) {
+    bits = sign;
+  } else {
+    // subnormal
+    exp = 113;
+    while (!(mant & 0x400)) {
+      mant <<= 1;
+      --exp;
+    }
+    bits = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+  }
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+#endif
+}
+
+// rounded to nearest even
+inline Half floatToHalf(float f) {
+#if defined(__F16C__)
+  return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+#else
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  Half sign = (bits >> 16) & 0x8000;
+  uint32_t abs = bits & 0x7fffffff;
+  if (abs >= 0x7f800000) {
+    return sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0);
+  }
+  if (abs >= 0x477ff000) {
+    // rounds over 65504
+    return sign | 0x7c00;
+  }
+  if (abs < 0x38800000) {
+    // subnormal, in units of 2^-24
+    float v;
+    memcpy(&v, &abs, sizeof(v));
+    return sign | Half(std::nearbyint(v * 16777216.0f));
+  }
+  uint32_t h = (((abs >> 23) - 112) << 10) | ((abs >> 13) & 0x3ff);
+  uint32_t rest = abs & 0x1fff;
+  if (rest > 0x1000 || (rest == 0x1000 && (h & 1))) {
+    ++h;
+  }
+  return sign | Half(h);
+#endif
+}
+
+#if defined(__AVX2__) && !defined(__AVX512F__)
+inline float horizontalSum(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v),
+                        _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+#endif
+
+#if defined(__AVX2__) && !defined(__AVX512BW__)
+inline int32_t horizontalSum(__m256i v) {
+  __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v),
+                            _mm256_extracti128_si256(v, 1));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+  s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+  return _mm_cvtsi128_si32(s);
+}
+#endif
+
+namespace detail {
+
+inline float toFloat(float v) {
+  return v;
+}
+
+inline float toFloat(Half v) {
+  return halfToFloat(v);
+}
+
+// float lanes loaded from float or half
+#if defined(__AVX512F__)
+#define CRYSTAL_DISTANCE_SIMD 1
+typedef __m512 FloatLane;
+constexpr size_t kFloatLanes = 16;
+
+inline FloatLane loadLane(const float* p) {
+  return _mm512_loadu_ps(p);
+}
+
+inline FloatLane loadLane(const Half* p) {
+  return _mm512_cvtph_ps(
+      _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+}
+
+inline FloatLane zeroLane() {
+  return _mm512_setzero_ps();
+}
+
+inline FloatLane subLane(FloatLane a, FloatLane b) {
+  return _mm512_sub_ps(a, b);
+}
+
+inline FloatLane fmaddLane(FloatLane a, FloatLane b, FloatLane acc) {
+  return _mm512_fmadd_ps(a, b, acc);
+}
+
+inline float sumLane(FloatLane v) {
+  return _mm512_reduce_add_ps(v);
+}
+#elif defined(__AVX2__)
+#define CRYSTAL_DISTANCE_SIMD 1
+typedef __m256 FloatLane;
+constexpr size_t kFloatLanes = 8;
+
+inline FloatLane loadLane(const float* p) {
+  return _mm256_loadu_ps(p);
+}
+
+inline FloatLane loadLane(const Half* p) {
+#if defined(__F16C__)
+  return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+#else
+  float f[kFloatLanes];
+  for (size_t i = 0; i < kFloatLanes; ++i) {
+    f[i] = halfToFloat(p[i]);
+  }
+  return _mm256_loadu_ps(f);
+#endif
+}
+
+inline FloatLane zeroLane() {
+  return _mm256_setzero_ps();
+}
+
+inline FloatLane subLane(FloatLane a, FloatLane b) {
+  return _mm256_sub_ps(a, b);
+}
+
+inline FloatLane fmaddLane(FloatLane a, FloatLane b, FloatLane acc) {
+#if defined(__FMA__)
+  return _mm256_fmadd_ps(a, b, acc);
+#else
+  return _mm256_add_ps(acc, _mm256_mul_ps(a, b));
+#endif
+}
+
+inline float sumLane(FloatLane v) {
+  return horizontalSum(v);
+}
+#endif
+
+} // namespace detail
+
+// squared L2 distance, b is float or half
+template <class T>
+inline float l2Sqr(const float* a, const T* b, size_t n) {
+  size_t i = 0;
+  float sum = 0;
+#if CRYSTAL_DISTANCE_SIMD
+  auto acc = detail::zeroLane();
+  for (; i + detail::kFloatLanes <= n; i += detail::kFloatLanes) {
+    auto d = detail::subLane(detail::loadLane(a + i), detail::loadLane(b + i));
+    acc = detail::fmaddLane(d, d, acc);
+  }
+  sum = detail::sumLane(acc);
+#endif
+  for (; i < n; ++i) {
+    float d = a[i] - detail::toFloat(b[i]);
+    sum += d * d;
+  }
+  return sum;
+}
+
+// inner product, b is float or half
+template <class T>
+inline float innerProduct(const float* a, const T* b, size_t n) {
+  size_t i = 0;
+  float sum = 0;
+#if CRYSTAL_DISTANCE_SIMD
+  auto acc = detail::zeroLane();
+  for (; i + detail::kFloatLanes <= n; i += detail::kFloatLanes) {
+    acc = detail::fmaddLane(
+        detail::loadLane(a + i), detail::loadLane(b + i), acc);
+  }
+  sum = detail::sumLane(acc);
+#endif
+  for (; i < n; ++i) {
+    sum += a[i] * detail::toFloat(b[i]);
+  }
+  return sum;
+}
+
+// cosine similarity, 0 if either is zero, b is float or half
+template <class T>
+inline float cosineSimilarity(const float* a, const T* b, size_t n) {
+  size_t i = 0;
+  float ab = 0, aa = 0, bb = 0;
+#if CRYSTAL_DISTANCE_SIMD
+  auto accAB = detail::zeroLane();
+  auto accAA = detail::zeroLane();
+  auto accBB = detail::zeroLane();
+  for (; i + detail::kFloatLanes <= n; i += detail::kFloatLanes) {
+    auto va = detail::loadLane(a + i);
+    auto vb = detail::loadLane(b + i);
+    accAB = detail::fmaddLane(va, vb, accAB);
+    accAA = detail::fmaddLane(va, va, accAA);
+    accBB = detail::fmaddLane(vb, vb, accBB);
+  }
+  ab = detail::sumLane(accAB);
+  aa = detail::sumLane(accAA);
+  bb = detail::sumLane(accBB);
+#endif
+  for (; i < n; ++i) {
+    float vb = detail::toFloat(b[i]);
+    ab += a[i] * vb;
+    aa += a[i] * a[i];
+    bb += vb * vb;
+  }
+  float norm = std::sqrt(aa) * std::sqrt(bb);
+  return norm > 0 ? ab / norm : 0;
+}
+
+// squared L2 distance of int8 vectors
+inline int32_t l2Sqr(const int8_t* a, const int8_t* b, size_t n) {
+  size_t i = 0;
+  int32_t sum = 0;
+#if defined(__AVX512BW__)
+  __m512i acc = _mm512_setzero_si512();
+  for (; i + 32 <= n; i += 32) {
+    __m512i d = _mm512_sub_epi16(
+        _mm512_cvtepi8_epi16(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i))),
+        _mm512_cvtepi8_epi16(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i))));
+    acc = _mm512_add_epi32(acc, _mm512_madd_epi16(d, d));
+  }
+  sum = _mm512_reduce_add_epi32(acc);
+#elif defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 16 <= n; i += 16) {
+    __m256i d = _mm256_sub_epi16(
+        _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))),
+        _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, d));
+  }
+  sum = horizontalSum(acc);
+#endif
+  for (; i < n; ++i) {
+    int32_t d = int32_t(a[i]) - b[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+// inner product of int8 vectors
+inline int32_t innerProduct(const int8_t* a, const int8_t* b, size_t n) {
+  size_t i = 0;
+  int32_t sum = 0;
+#if defined(__AVX512BW__)
+  __m512i acc = _mm512_setzero_si512();
+  for (; i + 32 <= n; i += 32) {
+    acc = _mm512_add_epi32(acc, _mm512_madd_epi16(
+        _mm512_cvtepi8_epi16(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i))),
+        _mm512_cvtepi8_epi16(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)))));
+  }
+  sum = _mm512_reduce_add_epi32(acc);
+#elif defined(__AVX2__)
+  __m256i acc = _mm256_setzero_si256();
+  for (; i + 16 <= n; i += 16) {
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(
+        _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i))),
+        _mm256_cvtepi8_epi16(
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)))));
+  }
+  sum = horizontalSum(acc);
+#endif
+  for (; i < n; ++i) {
+    sum += int32_t(a[i]) * b[i];
+  }
+  return sum;
+}
+
+// cosine similarity of int8 vectors, 0 if either is zero
+inline float cosineSimilarity(const int8_t* a, const int8_t* b, size_t n) {
+  float norm = std::sqrt(float(innerProduct(a, a, n))) *
+               std::sqrt(float(innerProduct(b, b, n)));
+  return norm > 0 ? innerProduct(a, b, n) / norm : 0;
+}
+
+}  // namespace crystal
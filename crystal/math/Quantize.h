@@ -0,0 +1,145 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#include "crystal/math/Distance.h"
+
+namespace crystal {
+
+/*
+ * Scalar quantization codecs of float vectors. Int8 codes are
+ * round(x / scale) clamped to [-127, 127] (0 for NaN), so the code space is
+ * symmetric and products of two codes fit int16 pairs summed in int32.
+ * Half codes are IEEE 754 half precision, rounded to nearest even.
+ */
+
+// NaN gives 0
+inline int8_t quantizeInt8(float x, float scale) {
+  float v = std::nearbyint(x / scale);
+  return v > 127 ? 127 : v < -127 ? -127 : v == v ? int8_t(v) : 0;
+}
+
+inline void quantizeInt8(const float* x, size_t n, float scale, int8_t* codes);
+
+inline void dequantizeInt8(
+    const int8_t* codes, size_t n, float scale, float* x);
+
+inline void quantizeHalf(const float* x, size_t n, Half* codes);
+
+inline void dequantizeHalf(const Half* codes, size_t n, float* x);
+
+//////////////////////////////////////////////////////////////////////
+
+inline void quantizeInt8(const float* x, size_t n, float scale, int8_t* codes) {
+  size_t i = 0;
+  // clamped as floats: the conversion gives INT_MIN for out of range and
+  // NaN, which are zeroed first
+#if defined(__AVX512F__)
+  __m512 r = _mm512_set1_ps(1 / scale);
+  __m512 lo = _mm512_set1_ps(-127);
+  __m512 hi = _mm512_set1_ps(127);
+  for (; i + 16 <= n; i += 16) {
+    __m512 f = _mm512_mul_ps(_mm512_loadu_ps(x + i), r);
+    f = _mm512_maskz_mov_ps(_mm512_cmp_ps_mask(f, f, _CMP_ORD_Q), f);
+    f = _mm512_min_ps(_mm512_max_ps(f, lo), hi);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(codes + i),
+                     _mm512_cvtepi32_epi8(_mm512_cvtps_epi32(f)));
+  }
+#elif defined(__AVX2__)
+  __m256 r = _mm256_set1_ps(1 / scale);
+  __m256 lo = _mm256_set1_ps(-127);
+  __m256 hi = _mm256_set1_ps(127);
+  for (; i + 8 <= n; i += 8) {
+    __m256 f = _mm256_mul_ps(_mm256_loadu_ps(x + i), r);
+    f = _mm256_and_ps(f, _mm256_cmp_ps(f, f, _CMP_ORD_Q));
+    f = _mm256_min_ps(_mm256_max_ps(f, lo), hi);
+    __m256i v = _mm256_cvtps_epi32(f);
+    __m128i w = _mm_packs_epi32(_mm256_castsi256_si128(v),
+                                _mm256_extracti128_si256(v, 1));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(codes + i),
+                     _mm_packs_epi16(w, w));
+  }
+#endif
+  for (; i < n; ++i) {
+    codes[i] = quantizeInt8(x[i], scale);
+  }
+}
+
+inline void dequantizeInt8(
+    const int8_t* codes, size_t n, float scale, float* x) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  __m512 s = _mm512_set1_ps(scale);
+  for (; i + 16 <= n; i += 16) {
+    __m512i v = _mm512_cvtepi8_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(codes + i)));
+    _mm512_storeu_ps(x + i, _mm512_mul_ps(_mm512_cvtepi32_ps(v), s));
+  }
+#elif defined(__AVX2__)
+  __m256 s = _mm256_set1_ps(scale);
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_cvtepi8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(codes + i)));
+    _mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_cvtepi32_ps(v), s));
+  }
+#endif
+  for (; i < n; ++i) {
+    x[i] = codes[i] * scale;
+  }
+}
+
+inline void quantizeHalf(const float* x, size_t n, Half* codes) {
+  size_t i = 0;
+#if defined(__AVX512F__)
+  for (; i + 16 <= n; i += 16) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(codes + i),
+        _mm512_cvtps_ph(_mm512_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+  }
+#elif defined(__AVX2__) && defined(__F16C__)
+  for (; i + 8 <= n; i += 8) {
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(codes + i),
+        _mm256_cvtps_ph(_mm256_loadu_ps(x + i), _MM_FROUND_TO_NEAREST_INT));
+  }
+#endif
+  for (; i < n; ++i) {
+    codes[i] = floatToHalf(x[i]);
+  }
+}
+
+inline void dequantizeHalf(const Half* codes, size_t n, float* x) {
+  size_t i = 0;
+#if CRYSTAL_DISTANCE_SIMD
+  for (; i + detail::kFloatLanes <= n; i += detail::kFloatLanes) {
+#if defined(__AVX512F__)
+    _mm512_storeu_ps(x + i, detail::loadLane(codes + i));
+#else
+    _mm256_storeu_ps(x + i, detail::loadLane(codes + i));
+#endif
+  }
+#endif
+  for (; i < n; ++i) {
+    x[i] = halfToFloat(codes[i]);
+  }
+}
+
+}  // namespace crystal
@@ -19,6 +19,7 @@
 #include <filesystem>
 
 #include <faiss/Index.h>
+#include <faiss/IndexIVF.h>
 #include <faiss/index_factory.h>
 #include <faiss/index_io.h>
 
@@ -93,7 +94,26 @@ bool FaissMemory::load() {
   if (meta_.type != j["type"].asString()) {
     return false;
   }
-  base_ = faiss::read_index(name_.c_str());
+  // read-only indexes are shared with other processes by page cache:
+  // the inverted lists of IVF are mapped rather than read into heap, its
+  // quantizer and codebooks are still read. Faiss io has no mapped form
+  // of Flat and HNSW, their codes and graph are read into heap always
+  int ioFlags = 0;
+  if (readOnly()) {
+    ioFlags = faiss::IO_FLAG_MMAP | faiss::IO_FLAG_READ_ONLY;
+  }
+  base_ = faiss::read_index(name_.c_str(), ioFlags);
+  if (!base_) {
+    return false;
+  }
+  auto ivf = dynamic_cast<faiss::IndexIVF*>(base_);
+  if (readOnly() && ivf && ivf->invlists) {
+    const faiss::InvertedLists* lists = ivf->invlists;
+    for (size_t i = 0; i < lists->nlist; ++i) {
+      mappedSize_ += lists->list_size(i)
+        * (lists->code_size + sizeof(faiss::idx_t));
+    }
+  }
   return true;
 }
 
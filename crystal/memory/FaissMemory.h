@@ -42,9 +42,13 @@ class FaissMemory : public Memory {
 
   int64_t allocate(size_t size) override;
   size_t getAllocatedSize() const override;
+  size_t getMappedSize() const override;
 
   void* address(int64_t offset) const override;
 
+  // replace the index, return the old one
+  faiss::Index* exchange(faiss::Index* index);
+
  private:
   bool load();
 
@@ -55,6 +59,7 @@ class FaissMemory : public Memory {
   int64_t dimension_;
   int metric_;
   Meta meta_;
+  size_t mappedSize_{0};
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -63,6 +68,15 @@ inline bool FaissMemory::readOnly() const {
   return flags_ == O_RDONLY;
 }
 
+inline size_t FaissMemory::getMappedSize() const {
+  return mappedSize_;
+}
+
+inline faiss::Index* FaissMemory::exchange(faiss::Index* index) {
+  std::swap(base_, index);
+  return index;
+}
+
 inline void* FaissMemory::address(int64_t offset) const {
   assert(offset == kMemStart);
   return base_;
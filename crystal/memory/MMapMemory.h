@@ -41,6 +41,7 @@ class MMapMemory : public Memory {
 
   int64_t allocate(size_t size) override;
   size_t getAllocatedSize() const override;
+  size_t getMappedSize() const override;
 
   void* address(int64_t offset) const override;
 
@@ -68,6 +69,10 @@ inline size_t MMapMemory::getAllocatedSize() const {
   return meta_.allocated;
 }
 
+inline size_t MMapMemory::getMappedSize() const {
+  return meta_.allocated;
+}
+
 inline void* MMapMemory::address(int64_t offset) const {
   assert(offset >= kMemStart);
   return base_ + offset - kMemStart;
@@ -44,6 +44,8 @@ class Memory {
 
   virtual int64_t allocate(size_t size) = 0;
   virtual size_t getAllocatedSize() const = 0;
+  // size of file data mapped instead of loaded into private memory
+  virtual size_t getMappedSize() const { return 0; }
 
   virtual void* address(int64_t offset) const = 0;
 };
@@ -16,6 +16,8 @@
 
 #include "crystal/memory/MemoryManager.h"
 
+#include <filesystem>
+
 #include "crystal/foundation/Logging.h"
 #include "crystal/foundation/String.h"
 #include "crystal/memory/FaissMemory.h"
@@ -60,6 +62,24 @@ void MemoryManager::dump() {
   }
 }
 
+bool MemoryManager::exists(int type) const {
+  if (type < 0 || type >= kMemMax) {
+    return false;
+  }
+  return memArray_[type] ||
+    std::filesystem::exists(toMemPath(path_, type));
+}
+
+size_t MemoryManager::getMappedSize() const {
+  size_t size = 0;
+  for (int i = 0; i < kMemMax; ++i) {
+    if (memArray_[i]) {
+      size += memArray_[i]->getMappedSize();
+    }
+  }
+  return size;
+}
+
 void MemoryManager::createMemory(int type, const void* extra) {
   auto path = toMemPath(path_, type);
   int flags = readOnly_ ? O_RDONLY : O_RDWR | O_CREAT;
@@ -69,6 +89,10 @@ void MemoryManager::createMemory(int type, const void* extra) {
     case kMemRecyc:
     case kMemHash:
     case kMemBit:
+    case kMemVector:
+    case kMemLookup:
+    case kMemPerfect:
+    case kMemVersion:
       mem = std::make_unique<MMapMemory>(path.c_str(), flags);
       break;
     case kMemFaiss:
@@ -29,6 +29,10 @@ namespace crystal {
   x(MemHash),                       \
   x(MemBit),                        \
   x(MemFaiss),                      \
+  x(MemVector),                     \
+  x(MemLookup),                     \
+  x(MemPerfect),                    \
+  x(MemVersion),                    \
   x(MemMax)
 
 #define CRYSTAL_MEMORY_TYPE_ENUM(type) k##type
@@ -50,6 +54,12 @@ class MemoryManager {
 
   Memory* getMemory(int type, const void* extra = nullptr);
 
+  // true if the memory was created, in this or a former run
+  bool exists(int type) const;
+
+  // total size of file data mapped by the memories
+  size_t getMappedSize() const;
+
   void dump();
 
  private:
@@ -36,6 +36,7 @@ TEST_F(MemoryManagerTest, write) {
 TEST_F(MemoryManagerTest, read) {
   MemoryManager manager(path.c_str(), true);
 
+  size_t mapped = 0;
   for (int i = 0; i < kMemMax; ++i) {
     if (i != kMemFaiss) {
       Memory* memory = manager.getMemory(i);
@@ -43,6 +44,9 @@ TEST_F(MemoryManagerTest, read) {
       EXPECT_NE(nullptr, p);
       EXPECT_EQ(100, *p);
       EXPECT_EQ(sizeof(int), memory->getAllocatedSize());
+      EXPECT_EQ(sizeof(int), memory->getMappedSize());
+      mapped += sizeof(int);
     }
   }
+  EXPECT_EQ(mapped, manager.getMappedSize());
 }
@@ -52,6 +52,7 @@ dynamic serializeItemToDynamic(
     ENCODE(uint64_t, UINT64)
     ENCODE(float, FLOAT)
     ENCODE(double, DOUBLE)
+    ENCODE(float16, FLOAT16)
     ENCODE(std::string_view, STRING)
 
 #undef ENCODE
@@ -0,0 +1,179 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/operator/search/BooleanSearch.h"
+
+#include <memory>
+
+#include "crystal/foundation/Conv.h"
+#include "crystal/operator/search/detail/Boolean.h"
+#include "crystal/strategy/Hash.h"
+
+namespace crystal {
+namespace op {
+
+namespace {
+
+using detail::Node;
+
+bool hashTermToken(DataType type, const dynamic& token, uint64_t& out) {
+  std::string s = token.asString();
+  switch (type) {
+#define HASH(type, enum_type)                   \
+    case DataType::enum_type:                   \
+      out = hashToken(to<type>(s));             \
+      return true;
+
+    HASH(int8_t, INT8)
+    HASH(int16_t, INT16)
+    HASH(int32_t, INT32)
+    HASH(int64_t, INT64)
+    HASH(uint8_t, UINT8)
+    HASH(uint16_t, UINT16)
+    HASH(uint32_t, UINT32)
+    HASH(uint64_t, UINT64)
+
+#undef HASH
+
+    case DataType::STRING:
+      out = hashToken(std::string_view(s));
+      return true;
+    default:
+      break;
+  }
+  CRYSTAL_LOG(ERROR) << "unsupport key type: " << dataTypeToString(type);
+  return false;
+}
+
+std::unique_ptr<Node> buildNode(const ExtendedTable* table,
+                                const dynamic& expr);
+
+bool buildChildren(const ExtendedTable* table,
+                   const dynamic& exprs,
+                   std::vector<std::unique_ptr<Node>>& nodes,
+                   std::vector<std::unique_ptr<Node>>* excludes = nullptr) {
+  if (!exprs.isArray()) {
+    CRYSTAL_LOG(ERROR) << "need array of expressions";
+    return false;
+  }
+  for (auto& expr : exprs) {
+    auto* p = expr.get_ptr("not");
+    if (p && !excludes) {
+      CRYSTAL_LOG(ERROR) << "'not' is only supported under 'and'";
+      return false;
+    }
+    auto node = buildNode(table, p ? *p : expr);
+    if (!node) {
+      return false;
+    }
+    (p ? *excludes : nodes).push_back(std::move(node));
+  }
+  return true;
+}
+
+// nullptr on an invalid expression, the error is logged
+std::unique_ptr<Node> buildNode(const ExtendedTable* table,
+                                const dynamic& expr) {
+  if (!expr.isObject()) {
+    CRYSTAL_LOG(ERROR) << "need object expression";
+    return nullptr;
+  }
+  if (auto* p = expr.get_ptr("and")) {
+    std::vector<std::unique_ptr<Node>> children;
+    std::vector<std::unique_ptr<Node>> excludes;
+    if (!buildChildren(table, *p, children, &excludes)) {
+      return nullptr;
+    }
+    if (children.empty()) {
+      CRYSTAL_LOG(ERROR) << "'and' needs at least one positive term";
+      return nullptr;
+    }
+    return std::make_unique<detail::AndNode>(std::move(children),
+                                             std::move(excludes));
+  }
+  if (auto* p = expr.get_ptr("or")) {
+    std::vector<std::unique_ptr<Node>> children;
+    if (!buildChildren(table, *p, children)) {
+      return nullptr;
+    }
+    return std::make_unique<detail::OrNode>(std::move(children));
+  }
+  if (expr.get_ptr("not")) {
+    CRYSTAL_LOG(ERROR) << "'not' is only supported under 'and'";
+    return nullptr;
+  }
+  auto* key = expr.get_ptr("key");
+  auto* token = expr.get_ptr("token");
+  if (!key || !key->isString() || !token) {
+    CRYSTAL_LOG(ERROR) << "need 'key' and 'token' in term: " << toJson(expr);
+    return nullptr;
+  }
+  std::string name = key->getString();
+  if (table->table()->getNoOfIndex(name) == size_t(-1)) {
+    CRYSTAL_LOG(ERROR) << "field '" << name << "' is not index name";
+    return nullptr;
+  }
+  uint64_t hash;
+  if (!hashTermToken(table->getFieldType(name), *token, hash)) {
+    return nullptr;
+  }
+  auto postingList = table->table()->getPostingList(name, hash);
+  if (!isBlank(postingList) &&
+      std::holds_alternative<VectorPostingList>(postingList)) {
+    CRYSTAL_LOG(ERROR) << "index '" << name << "' is not ordered by id";
+    return nullptr;
+  }
+  return std::make_unique<detail::TermNode>(std::move(postingList));
+}
+
+} // namespace
+
+DataView& BooleanSearch::compose(DataView& view) const {
+  if (!view.getBaseTable()) {
+    CRYSTAL_LOG(ERROR) << "no base table";
+    return view;
+  }
+  DocumentArray* index = view.getBaseTable();
+  std::unique_ptr<Node> root;
+  try {
+    // token conversion may still throw
+    root = buildNode(view.getObject(), expr_);
+  } catch (const std::exception& e) {
+    CRYSTAL_LOG(ERROR) << "build boolean expression failed: " << e.what();
+    return view;
+  }
+  if (!root) {
+    CRYSTAL_LOG(ERROR) << "invalid boolean expression: " << toJson(expr_);
+    return view;
+  }
+  CRYSTAL_LOG(DEBUG) << "boolean search with cost: " << root->cost();
+
+  detail::materialize(*index, *root, payloadLimit_);
+  view.docIndex().resize(index->getDocCount());
+  CRYSTAL_LOG(DEBUG) << "boolean search got "
+      << view.getRowCount() << " docs";
+  return view;
+}
+
+dynamic BooleanSearch::toDynamic() const {
+  return dynamic::object
+    ("BooleanSearch", dynamic::object
+     ("expr", expr_)
+     ("payloadLimit", payloadLimit_));
+}
+
+} // namespace op
+} // namespace crystal
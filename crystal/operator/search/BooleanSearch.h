@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/operator/Operator.h"
+#include "crystal/serializer/DynamicEncoding.h"
+
+namespace crystal {
+namespace op {
+
+/*
+ * Expression tree, each node is one of:
+ *   { key="color", token="red" }
+ *   { and=[node, ...] }
+ *   { or=[node, ...] }
+ *   { not=node }           only as a child of 'and'
+ *
+ * Terms are evaluated through posting list iterators, 'and' children
+ * are leapfrogged from the smallest posting list, only the final ids
+ * are materialized.
+ */
+class BooleanSearch : public Operator<BooleanSearch> {
+  dynamic expr_;
+  size_t payloadLimit_;
+
+ public:
+  BooleanSearch(const dynamic& expr, size_t payloadLimit)
+      : expr_(expr),
+        payloadLimit_(payloadLimit) {}
+
+  DataView& compose(DataView& view) const;
+
+  dynamic toDynamic() const;
+};
+
+inline BooleanSearch booleanSearch(const dynamic& expr,
+                                   size_t payloadLimit = -1) {
+  return BooleanSearch(expr, payloadLimit);
+}
+
+} // namespace op
+} // namespace crystal
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/operator/search/RangeSearch.h"
+
+#include <memory>
+
+#include "crystal/foundation/Conv.h"
+#include "crystal/operator/search/detail/Boolean.h"
+#include "crystal/strategy/Range.h"
+
+namespace crystal {
+namespace op {
+
+namespace {
+
+bool toRangeCode(DataType type, const std::string& s, uint64_t& code) {
+  switch (type) {
+#define CODE(type, enum_type)                   \
+    case DataType::enum_type:                   \
+      return rangeCode(to<type>(s), code);
+
+    CODE(int8_t, INT8)
+    CODE(int16_t, INT16)
+    CODE(int32_t, INT32)
+    CODE(int64_t, INT64)
+    CODE(uint8_t, UINT8)
+    CODE(uint16_t, UINT16)
+    CODE(uint32_t, UINT32)
+    CODE(uint64_t, UINT64)
+
+#undef CODE
+
+    case DataType::STRING:
+      return rangeCode(std::string_view(s), code);
+    default:
+      break;
+  }
+  return false;
+}
+
+} // namespace
+
+DataView& RangeSearch::compose(DataView& view) const {
+  if (!view.getBaseTable()) {
+    CRYSTAL_LOG(ERROR) << "no base table";
+    return view;
+  }
+  DocumentArray* index = view.getBaseTable();
+  const Table* table = index->object()->table();
+  if (table->getNoOfIndex(key_) == size_t(-1)) {
+    CRYSTAL_LOG(ERROR) << "field '" << key_ << "' is not index name";
+    return view;
+  }
+  if (table->config().indexConfig(key_).strategy() != StrategyType::kRange) {
+    CRYSTAL_LOG(ERROR) << "index '" << key_ << "' is not range strategy";
+    return view;
+  }
+  DataType type = index->object()->getFieldType(key_);
+  uint64_t lo = 0;
+  uint64_t hi = kRangeMax;
+  try {
+    bool ok = true;
+    if (!prefix_.empty()) {
+      ok = type == DataType::STRING && rangePrefix(prefix_, lo, hi);
+    } else {
+      ok = (lo_.empty() || toRangeCode(type, lo_, lo)) &&
+           (hi_.empty() || toRangeCode(type, hi_, hi));
+    }
+    if (!ok) {
+      CRYSTAL_LOG(ERROR) << "invalid range: " << toJson(*this);
+      return view;
+    }
+  } catch (const std::exception& e) {
+    CRYSTAL_LOG(ERROR) << "invalid range: " << e.what();
+    return view;
+  }
+
+  auto tokens = rangeTokens(lo, hi);
+  std::vector<std::unique_ptr<detail::Node>> children;
+  for (uint64_t token : tokens) {
+    auto postingList = table->getPostingList(key_, token);
+    if (isBlank(postingList)) {
+      continue;
+    }
+    if (std::holds_alternative<VectorPostingList>(postingList)) {
+      CRYSTAL_LOG(ERROR) << "index '" << key_ << "' is not ordered by id";
+      return view;
+    }
+    children.push_back(
+        std::make_unique<detail::TermNode>(std::move(postingList)));
+  }
+  CRYSTAL_LOG(DEBUG) << "range search with " << children.size()
+      << "/" << tokens.size() << " posting lists";
+
+  detail::OrNode root(std::move(children));
+  detail::materialize(*index, root, payloadLimit_);
+  view.docIndex().resize(index->getDocCount());
+  CRYSTAL_LOG(DEBUG) << "range search got "
+      << view.getRowCount() << " docs";
+  return view;
+}
+
+dynamic RangeSearch::toDynamic() const {
+  return dynamic::object
+    ("RangeSearch", dynamic::object
+     ("key", key_)
+     ("lo", lo_)
+     ("hi", hi_)
+     ("prefix", prefix_)
+     ("payloadLimit", payloadLimit_));
+}
+
+} // namespace op
+} // namespace crystal
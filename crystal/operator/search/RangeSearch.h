@@ -0,0 +1,68 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/operator/Operator.h"
+
+namespace crystal {
+namespace op {
+
+/*
+ * Search index built with range strategy by [lo, hi), or by prefix for
+ * string keys.  Empty lo or hi means unbounded.  The predicate is
+ * decomposed into a bounded number of range keys whose posting lists
+ * are ORed, the result is appended as one token.
+ */
+class RangeSearch : public Operator<RangeSearch> {
+  std::string key_;
+  std::string lo_;
+  std::string hi_;
+  std::string prefix_;
+  size_t payloadLimit_;
+
+ public:
+  RangeSearch(const std::string& key,
+              const std::string& lo,
+              const std::string& hi,
+              const std::string& prefix,
+              size_t payloadLimit)
+      : key_(key),
+        lo_(lo),
+        hi_(hi),
+        prefix_(prefix),
+        payloadLimit_(payloadLimit) {}
+
+  DataView& compose(DataView& view) const;
+
+  dynamic toDynamic() const;
+};
+
+inline RangeSearch rangeSearch(const std::string& key,
+                               const std::string& lo,
+                               const std::string& hi,
+                               size_t payloadLimit = -1) {
+  return RangeSearch(key, lo, hi, "", payloadLimit);
+}
+
+inline RangeSearch prefixSearch(const std::string& key,
+                                const std::string& prefix,
+                                size_t payloadLimit = -1) {
+  return RangeSearch(key, "", "", prefix, payloadLimit);
+}
+
+} // namespace op
+} // namespace crystal
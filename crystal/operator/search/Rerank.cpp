@@ -0,0 +1,167 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/operator/search/Rerank.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+#include "crystal/math/Quantize.h"
+#include "crystal/serializer/DynamicEncoding.h"
+#include "crystal/storage/index/Index.h"
+#include "crystal/storage/index/vector/VectorScan.h"
+
+namespace crystal {
+namespace op {
+
+DataView& Rerank::compose(DataView& view) const {
+  if (!view.getBaseTable()) {
+    CRYSTAL_LOG(ERROR) << "no base table";
+    return view;
+  }
+  const FieldMeta* fieldMeta = view.getObject()->getFieldMeta(key_);
+  if (!fieldMeta) {
+    CRYSTAL_LOG(ERROR) << "table not have field: " << key_;
+    return view;
+  }
+  DataType type = fieldMeta->type();
+  if (type != DataType::FLOAT &&
+      type != DataType::FLOAT16 &&
+      type != DataType::INT8) {
+    CRYSTAL_LOG(ERROR) << "unsupport vector type: " << dataTypeToString(type);
+    return view;
+  }
+  Index* index = view.getObject()->table()->getIndex(key_, 0);
+  if (!index || !index->config().isVector()) {
+    CRYSTAL_LOG(ERROR) << "field '" << key_ << "' is not vector index name";
+    return view;
+  }
+  auto& meta = index->config().vectorMeta();
+  int64_t d = meta.dimension;
+  if (n_ <= 0 || int64_t(x_.size()) != n_ * d) {
+    CRYSTAL_LOG(ERROR) << "unmatch dimension: " << x_.size() << "!="
+        << n_ << "*" << d;
+    return view;
+  }
+  int64_t firstToken = int64_t(view.getTokenCount()) - n_;
+  if (firstToken < 0) {
+    CRYSTAL_LOG(ERROR) << "less tokens than queries: "
+        << view.getTokenCount() << "<" << n_;
+    return view;
+  }
+  size_t keyCol = view.getIndexOfField(key_);
+  size_t distanceCol = view.getIndexOfField(appendDistanceField_);
+  if (distanceCol == npos) {
+    view.appendField(appendDistanceField_, true);
+    distanceCol = view.getIndexOfField(appendDistanceField_);
+  }
+
+  // queries of int8 fields are quantized once, and compared to the
+  // codes directly
+  std::vector<int8_t> codes;
+  float scale = fieldMeta->isQuantized() ? fieldMeta->scale() : 1;
+  if (type == DataType::INT8) {
+    codes.resize(x_.size());
+    quantizeInt8(x_.data(), x_.size(), scale, codes.data());
+  }
+  auto score = [&](uint32_t row, int64_t q, float* distance) {
+    switch (type) {
+      case DataType::FLOAT: {
+        auto v = view.get<Array<float>>(row, keyCol);
+        if (!v || int64_t(v->size()) != d) {
+          return false;
+        }
+        *distance = vectorDistance(
+            meta.metric, x_.data() + q * d, v->data(), d);
+        return true;
+      }
+      case DataType::FLOAT16: {
+        auto v = view.get<Array<float16>>(row, keyCol);
+        if (!v || int64_t(v->size()) != d) {
+          return false;
+        }
+        *distance = vectorDistance(
+            meta.metric, x_.data() + q * d,
+            reinterpret_cast<const Half*>(v->data()), d);
+        return true;
+      }
+      default: {
+        auto v = view.get<Array<int8_t>>(row, keyCol);
+        if (!v || int64_t(v->size()) != d) {
+          return false;
+        }
+        *distance = vectorDistance(
+            meta.metric, codes.data() + q * d, v->data(), d, scale);
+        return true;
+      }
+    }
+  };
+
+  bool similarity = isSimilarity(meta.metric);
+  float farthest = farthestDistance(meta.metric);
+  // (token, key, position) of candidates, key is the distance or negated
+  // similarity
+  typedef std::tuple<uint16_t, float, size_t> Rank;
+  std::vector<Rank> ranks;
+  ranks.reserve(view.getRowCount());
+  std::vector<bool> candidates(view.getRowCount(), false);
+  size_t ranked = 0;
+  for (size_t i = 0; i < view.getRowCount(); ++i) {
+    uint32_t row = view.getIndexOfDoc(i);
+    uint16_t token = view.getDoc(row)->tokenOffset();
+    int64_t q = int64_t(token) - firstToken;
+    if (q < 0) {
+      // not a candidate of the queries, kept in place
+      continue;
+    }
+    float distance = farthest;
+    if (score(row, q, &distance)) {
+      ++ranked;
+    }
+    view.set(row, distanceCol, distance);
+    ranks.emplace_back(token, similarity ? -distance : distance, i);
+    candidates[i] = true;
+  }
+  std::stable_sort(ranks.begin(), ranks.end(),
+                   [](const Rank& a, const Rank& b) {
+    return std::get<0>(a) != std::get<0>(b)
+      ? std::get<0>(a) < std::get<0>(b)
+      : std::get<1>(a) < std::get<1>(b);
+  });
+  // candidates take the positions of candidates in rank order
+  U32IndexArray docIndex;
+  size_t j = 0;
+  for (size_t i = 0; i < view.getRowCount(); ++i) {
+    docIndex.push_back(view.getIndexOfDoc(
+            candidates[i] ? std::get<2>(ranks[j++]) : i));
+  }
+  view.docIndex().swap(docIndex);
+  CRYSTAL_LOG(DEBUG) << "rerank '" << key_ << "' of " << ranked << " docs";
+  return view;
+}
+
+dynamic Rerank::toDynamic() const {
+  return dynamic::object
+    ("Rerank", dynamic::object
+     ("n", n_)
+     ("x", x_.toString())
+     ("key", key_)
+     ("appendDistanceField", appendDistanceField_));
+}
+
+} // namespace op
+} // namespace crystal
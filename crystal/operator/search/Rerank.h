@@ -0,0 +1,64 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/math/Span.h"
+#include "crystal/operator/Operator.h"
+
+namespace crystal {
+namespace op {
+
+/*
+ * Recompute the exact distances of the candidate docs to their queries
+ * by the metric of the vector index key, e.g. to re-rank the approximate
+ * results of a VectorSearch. The docs of the last n tokens are ranked,
+ * token i against query i, the distance is set to appendDistanceField
+ * and the docs of each token are reordered nearest first. Float16 and
+ * quantized int8 keys are compared as stored, int8 keys against the
+ * queries quantized by the same scale.
+ */
+class Rerank : public Operator<Rerank> {
+  int64_t n_;
+  Span<float> x_;
+  std::string key_;
+  std::string appendDistanceField_;
+
+ public:
+  Rerank(int64_t n,
+         Span<float> x,
+         const std::string& key,
+         const std::string& appendDistanceField)
+      : n_(n),
+        x_(x),
+        key_(key),
+        appendDistanceField_(appendDistanceField) {}
+
+  DataView& compose(DataView& view) const;
+
+  dynamic toDynamic() const;
+};
+
+inline Rerank rerank(
+    int64_t n,
+    Span<float> x,
+    const std::string& key,
+    const std::string& appendDistanceField) {
+  return Rerank(n, x, key, appendDistanceField);
+}
+
+} // namespace op
+} // namespace crystal
@@ -29,16 +29,22 @@ class Search : public Operator<Search<Container>> {
   std::string key_;
   size_t payloadLimit_;
   MergeType mergeType_;
+  size_t parallel_;
+  tf::Subflow* subflow_;
 
  public:
   Search(const Container& tokens,
          const std::string& key,
          size_t payloadLimit,
-         MergeType mergeType)
+         MergeType mergeType,
+         size_t parallel,
+         tf::Subflow* subflow)
       : tokens_(tokens),
         key_(key),
         payloadLimit_(payloadLimit),
-        mergeType_(mergeType) {}
+        mergeType_(mergeType),
+        parallel_(parallel),
+        subflow_(subflow) {}
 
   DataView& compose(DataView& view) const;
 
@@ -50,8 +56,11 @@ inline Search<Container> search(
     const Container& tokens,
     const std::string& key = "",
     size_t payloadLimit = -1,
-    MergeType mergeType = MergeType::kAppend) {
-  return Search<Container>(tokens, key, payloadLimit, mergeType);
+    MergeType mergeType = MergeType::kAppend,
+    size_t parallel = 1,
+    tf::Subflow* subflow = nullptr) {
+  return Search<Container>(
+      tokens, key, payloadLimit, mergeType, parallel, subflow);
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -74,11 +83,11 @@ DataView& Search<Container>::compose(DataView& view) const {
   size_t indexNo = view.getObject()->table()->getNoOfIndex(key);
   if (indexNo != size_t(-1)) {
     DocumentArray* index = view.getBaseTable();
+    std::vector<uint64_t> tokens;
     switch (type) {
 #define SEARCH(type, enum_type)                                       \
       case DataType::enum_type:                                       \
-        msearchIndex<type>(                                           \
-            *index, key, indexNo, tokens_, payloadLimit_, mergeType_);\
+        tokens = hashTokens<type>(tokens_);                           \
         break;
 
       SEARCH(int8_t, INT8)
@@ -97,6 +106,18 @@ DataView& Search<Container>::compose(DataView& view) const {
         CRYSTAL_LOG(ERROR) << "unsupport key type: " << dataTypeToString(type);
         break;
     }
+    if (subflow_ && parallel_ > 1) {
+      // merged later on the subflow, before successors of this op
+      DataView* v = &view;
+      detail::msearchIndex(
+          *index, key, indexNo, tokens, payloadLimit_, mergeType_,
+          parallel_, *subflow_, [v, index]() {
+            v->docIndex().resize(index->getDocCount());
+          });
+      return view;
+    }
+    detail::msearchIndex(
+        *index, key, indexNo, tokens, payloadLimit_, mergeType_);
     view.docIndex().resize(index->getDocCount());
   }
   else if (view.getObject()->hasKV()) {
@@ -145,7 +166,8 @@ dynamic Search<Container>::toDynamic() const {
      ("tokens", encode(tokens_))
      ("key", key_)
      ("payloadLimit", payloadLimit_)
-     ("mergeType", mergeTypeToString(mergeType_)));
+     ("mergeType", mergeTypeToString(mergeType_))
+     ("parallel", parallel_));
 }
 
 } // namespace op
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/operator/Operator.h"
+#include "crystal/operator/search/detail/Search.h"
+#include "crystal/operator/search/detail/TopK.h"
+#include "crystal/serializer/DynamicEncoding.h"
+
+namespace crystal {
+namespace op {
+
+/*
+ * Search the K best docs of the tokens on a scored index, the score of
+ * a doc is the sum of its posting scores.  Docs are appended as one
+ * token in descending score order, the score is set to
+ * appendScoreField if given.
+ */
+template <class Container>
+class TopKSearch : public Operator<TopKSearch<Container>> {
+  Container tokens_;
+  std::string key_;
+  size_t k_;
+  std::string appendScoreField_;
+
+ public:
+  TopKSearch(const Container& tokens,
+             const std::string& key,
+             size_t k,
+             const std::string& appendScoreField)
+      : tokens_(tokens),
+        key_(key),
+        k_(k),
+        appendScoreField_(appendScoreField) {}
+
+  DataView& compose(DataView& view) const;
+
+  dynamic toDynamic() const;
+};
+
+template <class Container>
+inline TopKSearch<Container> topKSearch(
+    const Container& tokens,
+    const std::string& key,
+    size_t k,
+    const std::string& appendScoreField = "") {
+  return TopKSearch<Container>(tokens, key, k, appendScoreField);
+}
+
+//////////////////////////////////////////////////////////////////////
+
+template <class Container>
+DataView& TopKSearch<Container>::compose(DataView& view) const {
+  if (!view.getBaseTable()) {
+    CRYSTAL_LOG(ERROR) << "no base table";
+    return view;
+  }
+  DataType type = view.getObject()->getFieldType(key_);
+  if (type == DataType::UNKNOWN) {
+    CRYSTAL_LOG(ERROR) << "table not have field: " << key_;
+    return view;
+  }
+  if (view.getObject()->table()->getNoOfIndex(key_) == size_t(-1)) {
+    CRYSTAL_LOG(ERROR) << "field '" << key_ << "' is not index name";
+    return view;
+  }
+  std::vector<uint64_t> tokens;
+  switch (type) {
+#define HASH(type, enum_type)                                         \
+    case DataType::enum_type:                                         \
+      tokens = hashTokens<type>(tokens_);                             \
+      break;
+
+    HASH(int8_t, INT8)
+    HASH(int16_t, INT16)
+    HASH(int32_t, INT32)
+    HASH(int64_t, INT64)
+    HASH(uint8_t, UINT8)
+    HASH(uint16_t, UINT16)
+    HASH(uint32_t, UINT32)
+    HASH(uint64_t, UINT64)
+    HASH(std::string_view, STRING)
+
+#undef HASH
+
+    default:
+      CRYSTAL_LOG(ERROR) << "unsupport key type: " << dataTypeToString(type);
+      return view;
+  }
+  DocumentArray* index = view.getBaseTable();
+  std::vector<std::pair<uint64_t, float>> results;
+  if (!detail::topKSearchIndex(*index, key_, tokens, k_, results)) {
+    return view;
+  }
+
+  size_t scoreCol = size_t(-1);
+  if (!appendScoreField_.empty()) {
+    view.appendField(appendScoreField_, true);
+    scoreCol = view.getIndexOfField(appendScoreField_);
+  }
+  size_t row = index->docs().size();
+  uint16_t offset = index->getTokenCount();
+  for (auto& r : results) {
+    auto& doc = index->docs().emplaceTemp(index->object(), offset, r.first);
+#if CRYSTAL_CHECK_DELETE
+    if (doc.isValid()) {
+#endif
+      index->docs().increment();
+      if (scoreCol != size_t(-1)) {
+        view.set(row, scoreCol, r.second);
+      }
+      ++row;
+#if CRYSTAL_CHECK_DELETE
+    }
+#endif
+  }
+  index->incrementTokenCount();
+  view.docIndex().resize(index->getDocCount());
+  CRYSTAL_LOG(DEBUG) << "top-k search '" << key_ << "' got "
+      << view.getRowCount() << " docs";
+  return view;
+}
+
+template <class Container>
+dynamic TopKSearch<Container>::toDynamic() const {
+  return dynamic::object
+    ("TopKSearch", dynamic::object
+     ("tokens", encode(tokens_))
+     ("key", key_)
+     ("k", k_)
+     ("appendScoreField", appendScoreField_));
+}
+
+} // namespace op
+} // namespace crystal
@@ -16,59 +16,192 @@
 
 #include "crystal/operator/search/VectorSearch.h"
 
-#include "crystal/math/Matrix.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <tuple>
+
+#include "crystal/graph/taskflow/executor.hpp"
 #include "crystal/storage/index/vector/VectorIndex.h"
+#include "crystal/storage/index/vector/VectorResults.h"
 
 namespace crystal {
 namespace op {
 
+namespace {
+
+struct SegmentResult {
+  const VectorIndex* index;
+  VectorResults::Ptr results;
+};
+
+// filter is the ids to search among, or null for all
+void searchSegment(SegmentResult& r, int64_t n, const float* x, int64_t k,
+                   const std::vector<uint64_t>* filter) {
+  r.results = VectorResults::acquire(n * k);
+  if (!filter) {
+    r.index->vsearch(
+        n, x, k, r.results->distances(), r.results->ids());
+  } else {
+    r.index->vsearch(
+        n, x, k, r.results->distances(), r.results->ids(), *filter);
+  }
+}
+
+// take the ids of the docs as filter, the docs are cleared
+std::vector<uint64_t> takeFilter(DocumentArray& vec) {
+  std::vector<uint64_t> ids;
+  ids.reserve(vec.docs().size());
+  for (size_t i = 0; i < vec.docs().size(); ++i) {
+    ids.push_back(vec.docs()[i].id());
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+  DocStorageArray empty;
+  vec.docs().swap(empty);
+  return ids;
+}
+
+// merge the results of segments (each sorted by distance) into the
+// global top k of every query
+void appendTopK(DataView& view,
+                size_t distanceCol,
+                std::vector<SegmentResult>& results,
+                int64_t n,
+                int64_t k) {
+  DocumentArray& vec = *view.getBaseTable();
+  bool ascending = results[0].index->ascending();
+  // (distance, segment, position), the nearest on top
+  typedef std::tuple<float, size_t, int64_t> Head;
+  auto farther = [ascending](const Head& a, const Head& b) {
+    if (std::get<0>(a) != std::get<0>(b)) {
+      return ascending ? std::get<0>(a) > std::get<0>(b)
+                       : std::get<0>(a) < std::get<0>(b);
+    }
+    return std::get<1>(a) > std::get<1>(b);
+  };
+  size_t row = vec.docs().size();
+  std::vector<Head> heap;
+  for (int64_t i = 0; i < n; ++i) {
+    uint16_t offset = vec.getTokenCount();
+    heap.clear();
+    for (size_t s = 0; s < results.size(); ++s) {
+      auto& r = *results[s].results;
+      if (r.ids()[i * k] != -1) {
+        heap.emplace_back(r.distances()[i * k], s, i * k);
+      }
+    }
+    std::make_heap(heap.begin(), heap.end(), farther);
+    for (int64_t j = 0; j < k && !heap.empty(); ++j) {
+      std::pop_heap(heap.begin(), heap.end(), farther);
+      auto [distance, s, pos] = heap.back();
+      heap.pop_back();
+      auto& r = *results[s].results;
+      uint64_t id = r.ids()[pos];
+      if (++pos < (i + 1) * k && r.ids()[pos] != -1) {
+        heap.emplace_back(r.distances()[pos], s, pos);
+        std::push_heap(heap.begin(), heap.end(), farther);
+      }
+      auto& doc = vec.docs().emplaceTemp(vec.object(), offset, id);
+#if CRYSTAL_CHECK_DELETE
+      if (doc.isValid()) {
+#endif
+        vec.docs().increment();
+        view.set(row++, distanceCol, distance);
+#if CRYSTAL_CHECK_DELETE
+      }
+#endif
+    }
+    vec.incrementTokenCount();
+  }
+}
+
+} // namespace
+
 void searchVectorIndex(DataView& view,
                        const std::string& indexName,
                        const std::string& appendDistanceField,
                        uint16_t segment,
                        int64_t n,
                        Span<float> x,
-                       int64_t k) {
+                       int64_t k,
+                       bool filter,
+                       tf::Subflow* subflow,
+                       std::shared_ptr<const void> owner,
+                       std::function<void()> done) {
   DocumentArray& vec = *view.getBaseTable();
-  auto vIndex = reinterpret_cast<VectorIndex*>(
-      vec.object()->table()->getIndex(indexName, segment)->index());
-  if (!vIndex) {
-    CRYSTAL_LOG(ERROR) << "index '" << indexName << "[" << segment << "]' not found";
+  const Table* table = vec.object()->table();
+  std::vector<uint16_t> segments;
+  if (segment == uint16_t(-1)) {
+    for (size_t i = 0; i < table->getIndexSegmentCount(indexName); ++i) {
+      segments.push_back(i);
+    }
+  } else {
+    segments.push_back(segment);
+  }
+  auto results = std::make_shared<std::vector<SegmentResult>>();
+  for (uint16_t seg : segments) {
+    Index* index = table->getIndex(indexName, seg);
+    if (!index) {
+      CRYSTAL_LOG(ERROR) << "index '" << indexName << "[" << seg
+          << "]' not found";
+      done();
+      return;
+    }
+    auto vIndex = reinterpret_cast<const VectorIndex*>(index->index());
+    results->push_back({vIndex, nullptr});
+  }
+  if (results->empty()) {
+    CRYSTAL_LOG(ERROR) << "index '" << indexName << "' not found";
+    done();
     return;
   }
-  int64_t dim = vIndex->config()->vectorMeta().dimension;
+  int64_t dim = results->front().index->config()->vectorMeta().dimension;
   int64_t querydim = x.size() / n;
   if (querydim != dim) {
     CRYSTAL_LOG(ERROR) << "unmatch dimension: " << querydim << "!=" << dim;
+    done();
     return;
   }
-  CRYSTAL_LOG(DEBUG) << "search vector index with " << n << " vector(s): "
-      << Matrix<float>(x, querydim) << ", k: " << k;
+  // queries are not logged, too large on batches
+  CRYSTAL_LOG(DEBUG) << "search vector index with " << n << "x" << querydim
+      << " vector(s), k: " << k << ", segments: " << results->size();
+
+  std::shared_ptr<std::vector<uint64_t>> ids;
+  if (filter) {
+    ids = std::make_shared<std::vector<uint64_t>>(takeFilter(vec));
+    CRYSTAL_LOG(DEBUG) << "filter vector search by " << ids->size() << " ids";
+  }
 
   view.appendField(appendDistanceField, true);
   size_t distanceCol = view.getIndexOfField(appendDistanceField);
 
-  float distances[n * k];
-  int64_t labels[n * k];
-  vIndex->vsearch(n, x.data(), k, distances, labels);
-  size_t row = vec.docs().size();
-  for (int64_t i = 0; i < n; ++i) {
-    uint16_t offset = vec.getTokenCount();
-    for (int64_t j = 0; j < k; ++j) {
-      int64_t id = labels[i * k + j];
-      if (id != -1) {
-        auto& doc = vec.docs().emplaceTemp(vec.object(), offset, id);
-#if CRYSTAL_CHECK_DELETE
-        if (doc.isValid()) {
-#endif
-          vec.docs().increment();
-          view.set(row++, distanceCol, distances[i * k + j]);
-#if CRYSTAL_CHECK_DELETE
-        }
-#endif
-      }
+  if (!subflow || results->size() < 2) {
+    for (auto& r : *results) {
+      searchSegment(r, n, x.data(), k, ids.get());
     }
-    vec.incrementTokenCount();
+    appendTopK(view, distanceCol, *results, n, k);
+    done();
+    return;
+  }
+  // merged later on the subflow, the tasks may outlive the queries: they
+  // hold the owner of the buffer, or a copy if none
+  const float* queries = x.data();
+  if (!owner) {
+    auto copy = std::make_shared<std::vector<float>>(x.begin(), x.end());
+    queries = copy->data();
+    owner = std::move(copy);
+  }
+  DataView* v = &view;
+  auto merge = subflow->emplace([v, distanceCol, results, n, k, done]() {
+    appendTopK(*v, distanceCol, *results, n, k);
+    results->clear();
+    done();
+  });
+  for (size_t s = 0; s < results->size(); ++s) {
+    subflow->emplace([results, owner, queries, ids, s, n, k]() {
+      searchSegment((*results)[s], n, queries, k, ids.get());
+    }).precede(merge);
   }
 }
 
@@ -83,10 +216,15 @@ DataView& VectorSearch::compose(DataView& view) const {
     CRYSTAL_LOG(ERROR) << "table not have field: " << key;
     return view;
   }
-  searchVectorIndex(view, key, appendDistanceField_, segment_, n_, x_, k_);
-  view.docIndex().resize(view.getBaseTable()->getDocCount());
-  CRYSTAL_LOG(DEBUG) << "vsearch '" << key << "' got "
-      << view.getRowCount() << " docs";
+  DataView* v = &view;
+  searchVectorIndex(
+      view, key, appendDistanceField_, segment_, n_, x_, k_, filter_,
+      subflow_, owner_,
+      [v, key]() {
+        v->docIndex().resize(v->getBaseTable()->getDocCount());
+        CRYSTAL_LOG(DEBUG) << "vsearch '" << key << "' got "
+            << v->getRowCount() << " docs";
+      });
   return view;
 }
 
@@ -98,7 +236,8 @@ dynamic VectorSearch::toDynamic() const {
      ("key", key_)
      ("appendDistanceField", appendDistanceField_)
      ("segment", segment_)
-     ("k", k_));
+     ("k", k_)
+     ("filter", filter_));
 }
 
 } // namespace op
@@ -16,13 +16,28 @@
 
 #pragma once
 
+#include <memory>
+
 #include "crystal/math/Span.h"
 #include "crystal/operator/Operator.h"
 #include "crystal/serializer/DynamicEncoding.h"
 
+namespace tf {
+class Subflow;
+}
+
 namespace crystal {
 namespace op {
 
+/*
+ * Search the k nearest vectors of each of the n queries. All segments
+ * of the index are searched if segment is -1, concurrently when a
+ * subflow is given, and merged into a global top-k of each query.
+ * If filter is set, the search is restricted to the docs of the base
+ * table (e.g. from a preceding search), which are replaced by results.
+ * The subflow tasks hold owner to keep the queries alive, or a copy of
+ * the queries if no owner is given.
+ */
 class VectorSearch : public Operator<VectorSearch> {
   int64_t n_;
   Span<float> x_;
@@ -30,6 +45,9 @@ class VectorSearch : public Operator<VectorSearch> {
   std::string appendDistanceField_;
   uint16_t segment_;
   int64_t k_;
+  bool filter_;
+  tf::Subflow* subflow_;
+  std::shared_ptr<const void> owner_;
 
  public:
   VectorSearch(int64_t n,
@@ -37,13 +55,19 @@ class VectorSearch : public Operator<VectorSearch> {
                const std::string& key,
                const std::string& appendDistanceField,
                uint16_t segment,
-               int64_t k)
+               int64_t k,
+               bool filter,
+               tf::Subflow* subflow,
+               std::shared_ptr<const void> owner = nullptr)
       : n_(n),
         x_(x),
         key_(key),
         appendDistanceField_(appendDistanceField),
         segment_(segment),
-        k_(k) {}
+        k_(k),
+        filter_(filter),
+        subflow_(subflow),
+        owner_(std::move(owner)) {}
 
   DataView& compose(DataView& view) const;
 
@@ -56,8 +80,12 @@ inline VectorSearch vSearch(
     const std::string& key,
     const std::string& appendDistanceField,
     uint16_t segment,
-    int64_t k) {
-  return VectorSearch(n, x, key, appendDistanceField, segment, k);
+    int64_t k,
+    bool filter = false,
+    tf::Subflow* subflow = nullptr,
+    std::shared_ptr<const void> owner = nullptr) {
+  return VectorSearch(n, x, key, appendDistanceField, segment, k, filter,
+                      subflow, std::move(owner));
 }
 
 } // namespace op
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/operator/search/detail/Boolean.h"
+
+#include <algorithm>
+
+#include "crystal/math/Bitwise.h"
+
+namespace crystal {
+namespace op {
+namespace detail {
+
+TermNode::TermNode(AnyPostingList&& postingList)
+    : postingList_(std::move(postingList)),
+      it_(std::monostate()) {
+  if (!isBlank(postingList_)) {
+    it_ = get(postingList_)->iterator();
+  }
+}
+
+size_t TermNode::cost() const {
+  return isBlank(it_) ? 0 : get(postingList_)->size();
+}
+
+uint64_t TermNode::id() const {
+  if (isBlank(it_)) {
+    return kEnd;
+  }
+  auto* it = get(it_);
+  return it->isValid() ? it->value()->id : kEnd;
+}
+
+void TermNode::seek(uint64_t target) {
+  if (id() < target) {
+    get(it_)->seekTo(target);
+  }
+}
+
+const BitmapPostingList* TermNode::bitmap() const {
+  return std::get_if<BitmapPostingList>(&postingList_);
+}
+
+AndNode::AndNode(std::vector<std::unique_ptr<Node>>&& children,
+                 std::vector<std::unique_ptr<Node>>&& excludes)
+    : children_(std::move(children)),
+      excludes_(std::move(excludes)) {
+  std::sort(children_.begin(), children_.end(),
+            [](const auto& a, const auto& b) {
+              return a->cost() < b->cost();
+            });
+  advance(0);
+}
+
+size_t AndNode::cost() const {
+  return children_.empty() ? 0 : children_[0]->cost();
+}
+
+uint64_t AndNode::id() const {
+  return id_;
+}
+
+void AndNode::seek(uint64_t target) {
+  if (id_ < target) {
+    advance(target);
+  }
+}
+
+void AndNode::advance(uint64_t target) {
+  while (true) {
+    children_[0]->seek(target);
+    target = children_[0]->id();
+    if (target == kEnd) {
+      break;
+    }
+    size_t i = 1;
+    for (; i < children_.size(); ++i) {
+      children_[i]->seek(target);
+      if (children_[i]->id() != target) {
+        break;
+      }
+    }
+    if (i < children_.size()) {
+      target = children_[i]->id();
+      if (target == kEnd) {
+        break;
+      }
+      continue;
+    }
+    if (excluded(target)) {
+      ++target;
+      continue;
+    }
+    break;
+  }
+  id_ = target;
+}
+
+bool AndNode::excluded(uint64_t id) const {
+  for (auto& node : excludes_) {
+    node->seek(id);
+    if (node->id() == id) {
+      return true;
+    }
+  }
+  return false;
+}
+
+WordsNode::WordsNode(const std::vector<const BitmapPostingList*>& lists) {
+  for (auto* list : lists) {
+    const uint64_t* src = list->words();
+    size_t n = src ? list->wordCount() : 0;
+    if (n > words_.size()) {
+      words_.resize(n, 0);
+    }
+    bitwiseOr(words_.data(), words_.data(), src, n);
+  }
+  count_ = bitwiseCount(words_.data(), words_.size());
+  find(0);
+}
+
+size_t WordsNode::cost() const {
+  return count_;
+}
+
+uint64_t WordsNode::id() const {
+  return id_;
+}
+
+void WordsNode::seek(uint64_t target) {
+  if (id_ < target) {
+    find(target);
+  }
+}
+
+void WordsNode::find(uint64_t target) {
+  size_t w = target / 64;
+  if (w >= words_.size()) {
+    id_ = kEnd;
+    return;
+  }
+  uint64_t word = words_[w] & (~uint64_t(0) << (target % 64));
+  while (word == 0) {
+    if (++w == words_.size()) {
+      id_ = kEnd;
+      return;
+    }
+    word = words_[w];
+  }
+  id_ = w * 64 + __builtin_ctzll(word);
+}
+
+namespace {
+
+bool laterId(const std::unique_ptr<Node>& a, const std::unique_ptr<Node>& b) {
+  return a->id() > b->id();
+}
+
+} // namespace
+
+OrNode::OrNode(std::vector<std::unique_ptr<Node>>&& children) {
+  std::vector<const BitmapPostingList*> lists;
+  for (auto& node : children) {
+    auto* term = dynamic_cast<TermNode*>(node.get());
+    if (term && term->bitmap()) {
+      lists.push_back(term->bitmap());
+    }
+  }
+  for (auto& node : children) {
+    auto* term = dynamic_cast<TermNode*>(node.get());
+    if (lists.size() < 2 || !term || !term->bitmap()) {
+      children_.push_back(std::move(node));
+    }
+  }
+  if (lists.size() >= 2) {
+    // the terms are dropped after, the words are copied
+    children_.push_back(std::make_unique<WordsNode>(lists));
+  }
+  std::make_heap(children_.begin(), children_.end(), laterId);
+  seek(0);
+}
+
+size_t OrNode::cost() const {
+  size_t n = 0;
+  for (auto& node : children_) {
+    n += node->cost();
+  }
+  return n;
+}
+
+uint64_t OrNode::id() const {
+  return id_;
+}
+
+void OrNode::seek(uint64_t target) {
+  while (!children_.empty() && children_.front()->id() < target) {
+    std::pop_heap(children_.begin(), children_.end(), laterId);
+    children_.back()->seek(target);
+    std::push_heap(children_.begin(), children_.end(), laterId);
+  }
+  id_ = children_.empty() ? kEnd : children_.front()->id();
+}
+
+size_t materialize(DocumentArray& index, Node& root, size_t limit) {
+  uint16_t offset = index.getTokenCount();
+  size_t n = 0;
+  for (uint64_t id = root.id(); id != kEnd && n < limit;
+       root.seek(id + 1), id = root.id()) {
+    auto& doc = index.docs().emplaceTemp(index.object(), offset, id);
+#if CRYSTAL_CHECK_DELETE
+    if (doc.isValid()) {
+#endif
+      index.docs().increment();
+      ++n;
+#if CRYSTAL_CHECK_DELETE
+    }
+#endif
+  }
+  index.incrementTokenCount();
+  return n;
+}
+
+} // namespace detail
+} // namespace op
+} // namespace crystal
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "crystal/dataframe/DocumentArray.h"
+
+namespace crystal {
+namespace op {
+namespace detail {
+
+constexpr uint64_t kEnd = uint64_t(-1);
+
+/*
+ * Id ordered cursor over posting lists, used to evaluate boolean and
+ * range expressions without materializing intermediate results.
+ */
+class Node {
+ public:
+  virtual ~Node() {}
+
+  // upper bound of matched ids
+  virtual size_t cost() const = 0;
+
+  // current id, kEnd if exhausted
+  virtual uint64_t id() const = 0;
+
+  // move to the first id >= target
+  virtual void seek(uint64_t target) = 0;
+};
+
+class TermNode : public Node {
+ public:
+  explicit TermNode(AnyPostingList&& postingList);
+
+  size_t cost() const override;
+  uint64_t id() const override;
+  void seek(uint64_t target) override;
+
+  // the list if it is a bitmap, nullptr otherwise
+  const BitmapPostingList* bitmap() const;
+
+ private:
+  mutable AnyPostingList postingList_;
+  mutable AnyPostingListIterator it_;
+};
+
+class AndNode : public Node {
+ public:
+  AndNode(std::vector<std::unique_ptr<Node>>&& children,
+          std::vector<std::unique_ptr<Node>>&& excludes);
+
+  size_t cost() const override;
+  uint64_t id() const override;
+  void seek(uint64_t target) override;
+
+ private:
+  void advance(uint64_t target);
+  bool excluded(uint64_t id) const;
+
+  std::vector<std::unique_ptr<Node>> children_;
+  std::vector<std::unique_ptr<Node>> excludes_;
+  uint64_t id_{0};
+};
+
+/*
+ * Union of bitmap words, built once from several bitmap terms.
+ */
+class WordsNode : public Node {
+ public:
+  explicit WordsNode(const std::vector<const BitmapPostingList*>& lists);
+
+  size_t cost() const override;
+  uint64_t id() const override;
+  void seek(uint64_t target) override;
+
+ private:
+  void find(uint64_t target);
+
+  std::vector<uint64_t> words_;
+  size_t count_{0};
+  uint64_t id_{kEnd};
+};
+
+/*
+ * Bitmap term children are merged into a WordsNode, the others are kept
+ * in a min heap by current id.
+ */
+class OrNode : public Node {
+ public:
+  explicit OrNode(std::vector<std::unique_ptr<Node>>&& children);
+
+  size_t cost() const override;
+  uint64_t id() const override;
+  void seek(uint64_t target) override;
+
+ private:
+  std::vector<std::unique_ptr<Node>> children_;
+  uint64_t id_{kEnd};
+};
+
+// append the ids of root as one token, return the number of added docs
+size_t materialize(DocumentArray& index, Node& root, size_t limit);
+
+} // namespace detail
+} // namespace op
+} // namespace crystal
@@ -16,6 +16,13 @@
 
 #include "crystal/operator/search/detail/Search.h"
 
+#include <algorithm>
+#include <memory>
+#include <queue>
+
+#include "crystal/graph/taskflow/executor.hpp"
+#include "crystal/math/Bitwise.h"
+
 namespace crystal {
 namespace op {
 
@@ -43,66 +50,168 @@ MergeType stringToMergeType(const char* str) {
   return MergeType::kAppend;
 }
 
+void searchKVBatch(DocumentArray& kv, const std::vector<uint64_t>& keys) {
+  std::vector<uint64_t> ids(keys.size());
+  kv.object()->table()->findBatch(keys.data(), keys.size(), ids.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    if (ids[i] == uint64_t(-1)) {
+      CRYSTAL_LOG(DEBUG) << "key '" << keys[i] << "' not found";
+    }
+    uint16_t offset = kv.getTokenCount();
+    auto& doc = kv.docs().emplaceTemp(kv.object(), offset, ids[i]);
+#if CRYSTAL_CHECK_DELETE
+    if (doc.isValid()) {
+#endif
+      kv.docs().increment();
+#if CRYSTAL_CHECK_DELETE
+    }
+#endif
+    kv.incrementTokenCount();
+  }
+}
+
 namespace detail {
 
-void searchIndex(DocumentArray& index,
-                 const std::string& indexName,
-                 size_t indexNo,
-                 uint64_t token,
-                 uint16_t offset,
-                 size_t limit,
-                 MergeType mergeType) {
-  auto postingList = index.object()->table()->getPostingList(indexName, token);
-  if (isBlank(postingList)) {
-    CRYSTAL_LOG(DEBUG) << "token '" << token << "' not found";
-    return;
+namespace {
+
+// exist() probes are cheap on id-addressed lists, only walk postings
+// when docs outnumber them by this ratio, see AndCrossover in SearchTest
+constexpr size_t kGallopRatio = 8;
+// probe docs instead of the word-wise path when bitmap words outnumber
+// docs by this ratio
+constexpr size_t kBitmapProbeRatio = 16;
+
+// first position >= k with id >= target, docs.size() if none
+size_t gallop(const DocStorageArray& docs, size_t k, uint64_t target) {
+  size_t n = docs.size();
+  if (k >= n || docs[k].id() >= target) {
+    return k;
   }
+  // docs[lo] < target
+  size_t lo = k;
+  size_t step = 1;
+  size_t hi = k + 1;
+  while (hi < n && docs[hi].id() < target) {
+    lo = hi;
+    step <<= 1;
+    hi = lo + step;
+  }
+  if (hi > n) {
+    hi = n;
+  }
+  while (lo + 1 < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (docs[mid].id() < target) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  return hi;
+}
+
+// postings walked by searchSource, from a posting list or cached ids
+class ListSource {
+ public:
+  explicit ListSource(AnyPostingList& postingList)
+      : postingList_(postingList),
+        it_(get(postingList)->iterator()) {}
+
+  size_t size() const { return get(postingList_)->size(); }
+  IndexBase* owner() const { return get(postingList_)->index(); }
+  bool exist(uint64_t id) const { return get(postingList_)->exist(id); }
+
+  uint64_t id() const { return get(it_)->value()->id; }
+  const char* data() const { return get(it_)->value()->data(); }
+  void next() { get(it_)->next(); }
+
+ private:
+  AnyPostingList& postingList_;
+  mutable AnyPostingListIterator it_;
+};
+
+class CachedSource {
+ public:
+  explicit CachedSource(const PostingIds* ids) : ids_(ids) {}
+
+  size_t size() const { return ids_->ids.size(); }
+  IndexBase* owner() const { return ids_->index; }
+  bool exist(uint64_t id) const {
+    return std::binary_search(ids_->ids.begin(), ids_->ids.end(), id);
+  }
+
+  uint64_t id() const { return ids_->ids[i_]; }
+  const char* data() const {
+    return reinterpret_cast<const char*>(&ids_->ids[i_]);
+  }
+  void next() { ++i_; }
+
+ private:
+  const PostingIds* ids_;
+  size_t i_{0};
+};
+
+template <class Source>
+void intersectByProbe(DocumentArray& index, const Source& src) {
+  DocStorageArray mergedDocs;
+  for (size_t k = 0; k < index.docs().size(); ++k) {
+    if (src.exist(index.docs()[k].id())) {
+      mergedDocs.emplace(std::move(index.docs()[k]));
+    }
+  }
+  index.docs().swap(mergedDocs);
+}
 
-  size_t n = get(postingList)->size();
-  AnyPostingListIterator it = get(postingList)->iterator();
-  if (n > limit) {
-    n = limit;
+template <class Source>
+void intersectByGallop(DocumentArray& index, Source& src, size_t n) {
+  DocStorageArray mergedDocs;
+  size_t k = 0;
+  for (size_t i = 0; i < n; ++i) {
+    uint64_t id = src.id();
+    src.next();
+    k = gallop(index.docs(), k, id);
+    if (k == index.docs().size()) {
+      break;
+    }
+    if (index.docs()[k].id() == id) {
+      mergedDocs.emplace(std::move(index.docs()[k++]));
+    }
   }
-  CRYSTAL_LOG(DEBUG) << "token '" << token << "' got " << n << " docs";
+  index.docs().swap(mergedDocs);
+}
+
+template <class Source>
+void searchSource(DocumentArray& index,
+                  size_t indexNo,
+                  Source& src,
+                  uint16_t offset,
+                  size_t limit,
+                  MergeType mergeType) {
+  size_t n = std::min(src.size(), limit);
 
   switch (mergeType) {
     case MergeType::kAnd: {
+      if (!index.docs().empty()) {
+        if (n == src.size() &&
+            index.docs().size() <= n * kGallopRatio) {
+          intersectByProbe(index, src);
+        } else {
+          intersectByGallop(index, src, n);
+        }
+      }
+      // else: for empty, just break
+      break;
+    }
+    case MergeType::kNot: {
       if (!index.docs().empty()) {
         DocStorageArray mergedDocs;
-        size_t k = 0;
-        uint64_t id = index.docs()[k].id();
-
-        for (size_t i = 0; i < n; ++i) {
-          Document doc(index.object(),
-                       offset,
-                       get(it)->value()->data(),
-                       get(postingList)->index(),
-                       indexNo);
-          get(it)->next();
-#if CRYSTAL_CHECK_DELETE
-          if (doc.isValid()) {
-#endif
-            while (id < doc.id()) {
-              if (++k == index.docs().size()) {
-                goto outOfAndLoop;
-              }
-              id = index.docs()[k].id();
-            }
-            if (id == doc.id()) {
-              mergedDocs.emplace(std::move(index.docs()[k]));
-              if (++k == index.docs().size()) {
-                goto outOfAndLoop;
-              }
-              id = index.docs()[k].id();
-            }
-#if CRYSTAL_CHECK_DELETE
+        for (size_t k = 0; k < index.docs().size(); ++k) {
+          if (!src.exist(index.docs()[k].id())) {
+            mergedDocs.emplace(std::move(index.docs()[k]));
           }
-#endif
         }
-outOfAndLoop:
         index.docs().swap(mergedDocs);
       }
-      // else: for empty, just break
       break;
     }
     case MergeType::kOr: {
@@ -115,10 +224,10 @@ outOfAndLoop:
         for (; i < n; ++i) {
           Document doc(index.object(),
                        offset,
-                       get(it)->value()->data(),
-                       get(postingList)->index(),
+                       src.data(),
+                       src.owner(),
                        indexNo);
-          get(it)->next();
+          src.next();
 #if CRYSTAL_CHECK_DELETE
           if (doc.isValid()) {
 #endif
@@ -147,10 +256,10 @@ outOfAndLoop:
         for (++i; i < n; ++i) {
           auto& doc = mergedDocs.emplaceTemp(index.object(),
                                              offset,
-                                             get(it)->value()->data(),
-                                             get(postingList)->index(),
+                                             src.data(),
+                                             src.owner(),
                                              indexNo);
-          get(it)->next();
+          src.next();
 #if CRYSTAL_CHECK_DELETE
           if (doc.isValid()) {
 #endif
@@ -171,10 +280,10 @@ outOfAndLoop:
       for (size_t i = 0; i < n; ++i) {
         auto& doc = index.docs().emplaceTemp(index.object(),
                                              offset,
-                                             get(it)->value()->data(),
-                                             get(postingList)->index(),
+                                             src.data(),
+                                             src.owner(),
                                              indexNo);
-        get(it)->next();
+        src.next();
 #if CRYSTAL_CHECK_DELETE
         if (doc.isValid()) {
 #endif
@@ -188,6 +297,420 @@ outOfAndLoop:
   }
 }
 
+} // namespace
+
+void intersectByProbe(DocumentArray& index, AnyPostingList& postingList) {
+  intersectByProbe(index, ListSource(postingList));
+}
+
+void intersectByGallop(DocumentArray& index,
+                       AnyPostingList& postingList,
+                       size_t n) {
+  ListSource src(postingList);
+  intersectByGallop(index, src, std::min(n, src.size()));
+}
+
+namespace {
+
+// ids of the first n postings of the list are below the returned id
+uint64_t bitmapCutoff(const BitmapPostingList* list, size_t n) {
+  if (n >= list->size()) {
+    return uint64_t(-1);
+  }
+  const uint64_t* words = list->words();
+  size_t m = words ? list->wordCount() : 0;
+  size_t count = 0;
+  size_t i = 0;
+  // skip by blocks of words first
+  constexpr size_t kBlock = 64;
+  for (; i + kBlock <= m; i += kBlock) {
+    size_t c = bitwiseCount(words + i, kBlock);
+    if (count + c >= n) {
+      break;
+    }
+    count += c;
+  }
+  for (; i < m; ++i) {
+    uint64_t word = words[i];
+    size_t c = __builtin_popcountll(word);
+    if (count + c >= n) {
+      for (; count + 1 < n; ++count) {
+        word &= word - 1;
+      }
+      return i * 64 + __builtin_ctzll(word) + 1;
+    }
+    count += c;
+  }
+  return uint64_t(-1);
+}
+
+}  // namespace
+
+bool searchBitmapIndex(DocumentArray& index,
+                       const std::string& indexName,
+                       size_t indexNo,
+                       const std::vector<uint64_t>& tokens,
+                       size_t limit,
+                       MergeType mergeType) {
+  if (mergeType == MergeType::kAppend) {
+    return false;
+  }
+  // posting lists by token position, nullptr if token not found
+  std::vector<AnyPostingList> postingLists;
+  std::vector<const BitmapPostingList*> lists(tokens.size(), nullptr);
+  postingLists.reserve(tokens.size());
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    postingLists.push_back(
+        index.object()->table()->getPostingList(indexName, tokens[i]));
+    auto& postingList = postingLists.back();
+    if (isBlank(postingList)) {
+      CRYSTAL_LOG(DEBUG) << "token '" << tokens[i] << "' not found";
+      continue;
+    }
+    lists[i] = std::get_if<BitmapPostingList>(&postingList);
+    if (lists[i] == nullptr) {
+      return false;
+    }
+  }
+
+  // a single list is walked by its iterator, which skips empty words
+  size_t found = 0;
+  for (auto* list : lists) {
+    found += list != nullptr;
+  }
+  if (found < 2) {
+    return false;
+  }
+
+  DocStorageArray& docs = index.docs();
+  DocStorageArray mergedDocs;
+
+  if (mergeType != MergeType::kOr) {
+    if (docs.empty()) {
+      // for empty, kAnd just breaks and kNot has nothing to exclude
+      return true;
+    }
+    bool keep = mergeType == MergeType::kAnd;
+    // as the per-token path, kAnd takes the first limit postings of lists
+    uint64_t cutoff = uint64_t(-1);
+    if (keep) {
+      for (auto* list : lists) {
+        if (list != nullptr) {
+          cutoff = std::min(cutoff, bitmapCutoff(list, limit));
+        }
+      }
+    }
+    uint64_t maxId = 0;
+    for (size_t k = 0; k < docs.size(); ++k) {
+      maxId = std::max(maxId, docs[k].id());
+    }
+    size_t n = maxId / 64 + 1;
+
+    // few docs against large bitmaps, probing beats word-wise evaluation
+    if (docs.size() * kBitmapProbeRatio <= n) {
+      for (size_t k = 0; k < docs.size(); ++k) {
+        uint64_t id = docs[k].id();
+        bool matched = keep && id < cutoff;
+        for (auto* list : lists) {
+          if (matched != keep) {
+            break;
+          }
+          if (list != nullptr && list->exist(id) != keep) {
+            matched = !keep;
+          }
+        }
+        if (matched == keep) {
+          mergedDocs.emplace(std::move(docs[k]));
+        }
+      }
+      docs.swap(mergedDocs);
+      return true;
+    }
+
+    // a bitmap of the docs, and-ed (kAnd) or and-not-ed (kNot) with lists
+    std::vector<uint64_t> words(n, 0);
+    for (size_t k = 0; k < docs.size(); ++k) {
+      uint64_t id = docs[k].id();
+      words[id / 64] |= uint64_t(1) << (id % 64);
+    }
+    for (auto* list : lists) {
+      if (list == nullptr) {
+        continue;
+      }
+      const uint64_t* src = list->words();
+      size_t m = src ? std::min(n, list->wordCount()) : 0;
+      if (keep) {
+        bitwiseAnd(words.data(), words.data(), src, m);
+        std::fill(words.begin() + m, words.end(), 0);
+      } else {
+        bitwiseAndNot(words.data(), words.data(), src, m);
+      }
+    }
+    for (size_t k = 0; k < docs.size(); ++k) {
+      uint64_t id = docs[k].id();
+      if (id < cutoff && (words[id / 64] & (uint64_t(1) << (id % 64)))) {
+        mergedDocs.emplace(std::move(docs[k]));
+      }
+    }
+    docs.swap(mergedDocs);
+    return true;
+  }
+
+  // kOr of the lists word-wise, blank tokens are skipped as in the
+  // per-token path
+  std::vector<uint64_t> words;
+  for (auto* list : lists) {
+    if (list == nullptr) {
+      continue;
+    }
+    const uint64_t* src = list->words();
+    size_t n = src ? list->wordCount() : 0;
+    if (n > words.size()) {
+      words.resize(n, 0);
+    }
+    bitwiseOr(words.data(), words.data(), src, n);
+  }
+
+  uint16_t offset = index.getTokenCount();
+  size_t k = 0;
+  size_t added = 0;
+  for (size_t w = 0; w < words.size() && added < limit; ++w) {
+    uint64_t word = words[w];
+    while (word != 0 && added < limit) {
+      uint64_t id = w * 64 + __builtin_ctzll(word);
+      word &= word - 1;
+      while (k < docs.size() && docs[k].id() < id) {
+        mergedDocs.emplace(std::move(docs[k++]));
+      }
+      if (k < docs.size() && docs[k].id() == id) {
+        mergedDocs.emplace(std::move(docs[k++]));
+        continue;
+      }
+      size_t t = 0;
+      while (lists[t] == nullptr || !lists[t]->exist(id)) {
+        ++t;
+      }
+      auto& doc = mergedDocs.emplaceTemp(
+          index.object(),
+          offset + t,
+          reinterpret_cast<const char*>(&id),
+          lists[t]->index(),
+          indexNo);
+#if CRYSTAL_CHECK_DELETE
+      if (doc.isValid()) {
+#endif
+        mergedDocs.increment();
+        ++added;
+#if CRYSTAL_CHECK_DELETE
+      }
+#endif
+    }
+  }
+  for (; k < docs.size(); ++k) {
+    mergedDocs.emplace(std::move(docs[k]));
+  }
+  docs.swap(mergedDocs);
+  index.incrementTokenCount(tokens.size());
+  return true;
+}
+
+void msearchIndex(DocumentArray& index,
+                  const std::string& indexName,
+                  size_t indexNo,
+                  const std::vector<uint64_t>& tokens,
+                  size_t limit,
+                  MergeType mergeType) {
+  CRYSTAL_LOG(DEBUG) << "search index with " << tokens.size() << " tokens"
+      << ", merge type: " << mergeTypeToString(mergeType);
+  if (mergeType != MergeType::kAppend &&
+      searchBitmapIndex(index, indexName, indexNo, tokens, limit, mergeType)) {
+    return;
+  }
+  if (mergeType == MergeType::kAnd && tokens.size() > 1) {
+    // intersect from the smallest posting list, docs shrink fastest
+    std::vector<std::pair<size_t, uint64_t>> sized;
+    for (auto token : tokens) {
+      auto postingList =
+        index.object()->table()->getPostingList(indexName, token);
+      sized.emplace_back(
+          isBlank(postingList) ? 0 : get(postingList)->size(), token);
+    }
+    std::sort(sized.begin(), sized.end());
+    for (auto& p : sized) {
+      searchIndex(index,
+                  indexName,
+                  indexNo,
+                  p.second,
+                  index.getTokenCount(),
+                  limit,
+                  mergeType);
+    }
+    return;
+  }
+  for (auto token : tokens) {
+    searchIndex(index,
+                indexName,
+                indexNo,
+                token,
+                index.getTokenCount(),
+                limit,
+                mergeType);
+    if (mergeType != MergeType::kAnd && mergeType != MergeType::kNot) {
+      index.incrementTokenCount();
+    }
+  }
+}
+
+void msearchIndex(DocumentArray& index,
+                  const std::string& indexName,
+                  size_t indexNo,
+                  const std::vector<uint64_t>& tokens,
+                  size_t limit,
+                  MergeType mergeType,
+                  size_t parallel,
+                  tf::Subflow& subflow,
+                  std::function<void()> done) {
+  size_t m = tokens.size();
+  size_t n = std::min(parallel, m);
+  if (n < 2 ||
+      mergeType == MergeType::kAnd ||
+      mergeType == MergeType::kNot ||
+      (mergeType == MergeType::kOr &&
+       searchBitmapIndex(index, indexName, indexNo, tokens, limit,
+                         mergeType))) {
+    if (n < 2 || mergeType != MergeType::kOr) {
+      msearchIndex(index, indexName, indexNo, tokens, limit, mergeType);
+    }
+    done();
+    return;
+  }
+  CRYSTAL_LOG(DEBUG) << "search index with " << m << " tokens"
+      << ", merge type: " << mergeTypeToString(mergeType)
+      << ", parallel: " << n;
+
+  // group i holds sorted (kOr) or appended (kAppend) docs of its tokens,
+  // token offsets are the same as serial
+  auto groups = std::make_shared<std::vector<DocStorageArray>>(n);
+  uint16_t base = index.getTokenCount();
+  size_t segments = index.object()->table()->getIndexSegmentCount(indexName);
+
+  auto merge = subflow.emplace([&index, groups, m, mergeType, done]() {
+    if (mergeType == MergeType::kAppend) {
+      for (auto& docs : *groups) {
+        for (size_t k = 0; k < docs.size(); ++k) {
+          index.docs().emplace(std::move(docs[k]));
+        }
+      }
+    } else {
+      // k-way merge by (id, token offset), existing docs come first as
+      // their offsets are less than base, duplicated ids are dropped
+      std::vector<DocStorageArray*> sources = { &index.docs() };
+      for (auto& docs : *groups) {
+        sources.push_back(&docs);
+      }
+      typedef std::tuple<uint64_t, uint16_t, size_t> Head;
+      std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heap;
+      std::vector<size_t> pos(sources.size(), 0);
+      for (size_t i = 0; i < sources.size(); ++i) {
+        if (!sources[i]->empty()) {
+          auto& doc = (*sources[i])[0];
+          heap.emplace(doc.id(), doc.tokenOffset(), i);
+        }
+      }
+      DocStorageArray mergedDocs;
+      uint64_t last = uint64_t(-1);
+      while (!heap.empty()) {
+        size_t i = std::get<2>(heap.top());
+        heap.pop();
+        auto& doc = (*sources[i])[pos[i]];
+        if (mergedDocs.empty() || doc.id() != last) {
+          last = doc.id();
+          mergedDocs.emplace(std::move(doc));
+        }
+        if (++pos[i] < sources[i]->size()) {
+          auto& next = (*sources[i])[pos[i]];
+          heap.emplace(next.id(), next.tokenOffset(), i);
+        }
+      }
+      index.docs().swap(mergedDocs);
+    }
+    index.incrementTokenCount(m);
+    done();
+  });
+
+  // append keeps token order by contiguous groups, or groups tokens
+  // of the same index segment
+  std::vector<std::vector<std::pair<uint64_t, uint16_t>>> groupTokens(n);
+  for (size_t i = 0; i < m; ++i) {
+    size_t g = mergeType == MergeType::kAppend ? i * n / m
+      : (segments >= n ? tokens[i] % segments % n : i % n);
+    groupTokens[g].emplace_back(tokens[i], base + i);
+  }
+  for (size_t g = 0; g < n; ++g) {
+    subflow.emplace([&index, indexName, indexNo, limit, mergeType, groups, g,
+                     group = std::move(groupTokens[g])]() {
+      DocumentArray part(index.object());
+      for (auto& p : group) {
+        searchIndex(part,
+                    indexName,
+                    indexNo,
+                    p.first,
+                    p.second,
+                    limit,
+                    mergeType);
+      }
+      (*groups)[g].swap(part.docs());
+    }).precede(merge);
+  }
+}
+
+void searchIndex(DocumentArray& index,
+                 const std::string& indexName,
+                 size_t indexNo,
+                 uint64_t token,
+                 uint16_t offset,
+                 size_t limit,
+                 MergeType mergeType) {
+  const Table* table = index.object()->table();
+  PostingCache& cache = table->postingCache();
+  if (const PostingIds* ids = cache.get(indexNo, token)) {
+    CRYSTAL_LOG(DEBUG) << "token '" << token << "' got "
+        << ids->ids.size() << " cached ids";
+    CachedSource src(ids);
+    searchSource(index, indexNo, src, offset, limit, mergeType);
+    return;
+  }
+  auto postingList = table->getPostingList(indexName, token);
+  if (isBlank(postingList)) {
+    CRYSTAL_LOG(DEBUG) << "token '" << token << "' not found";
+    return;
+  }
+  CRYSTAL_LOG(DEBUG) << "token '" << token << "' got "
+      << get(postingList)->size() << " docs";
+  // lists of id payloads are cached, vector lists are not searched by
+  // token. Lists cut by limit are not decoded whole
+  size_t size = get(postingList)->size();
+  if (size >= cache.minSize() && size <= limit &&
+      !std::holds_alternative<VectorPostingList>(postingList)) {
+    const PostingIds* ids = cache.put(
+        indexNo, token, get(postingList)->index(),
+        [&](std::vector<uint64_t>& out) {
+          out.reserve(size);
+          auto it = get(postingList)->iterator();
+          for (; get(it)->isValid(); get(it)->next()) {
+            out.push_back(get(it)->value()->id);
+          }
+        });
+    if (ids) {
+      CachedSource src(ids);
+      searchSource(index, indexNo, src, offset, limit, mergeType);
+      return;
+    }
+  }
+  ListSource src(postingList);
+  searchSource(index, indexNo, src, offset, limit, mergeType);
+}
+
 } // namespace detail
 
 } // namespace op
@@ -16,17 +16,24 @@
 
 #pragma once
 
+#include <functional>
+
 #include "crystal/dataframe/DocumentArray.h"
 #include "crystal/strategy/Hash.h"
 #include "crystal/type/Utility.h"
 
+namespace tf {
+class Subflow;
+}
+
 namespace crystal {
 namespace op {
 
 #define CRYSTAL_MERGE_TYPE_GEN(x) \
   x(Append),                      \
   x(And),                         \
-  x(Or)
+  x(Or),                          \
+  x(Not)
 
 #define CRYSTAL_MERGE_TYPE_ENUM(type) k##type
 
@@ -61,13 +68,19 @@ inline void searchKV(DocumentArray& kv, const T& token) {
   kv.incrementTokenCount();
 }
 
+// same as searchKV on each hashed token, keys are found in one batch
+void searchKVBatch(DocumentArray& kv, const std::vector<uint64_t>& keys);
+
 template <class T, class Container>
 inline typename std::enable_if<
   IsContainer<Container>::value && std::is_arithmetic<T>::value>::type
 msearchKV(DocumentArray& kv, const Container& tokens) {
+  std::vector<uint64_t> keys;
+  keys.reserve(tokens.size());
   for (const auto& token : tokens) {
-    searchKV(kv, to<T>(token));
+    keys.push_back(hashToken(to<T>(token)));
   }
+  searchKVBatch(kv, keys);
 }
 
 template <class T, class Container>
@@ -75,9 +88,12 @@ inline typename std::enable_if<
   IsContainer<Container>::value && IsString<T>::value &&
   IsString<typename ContainerValueType<Container>::type>::value>::type
 msearchKV(DocumentArray& kv, const Container& tokens) {
+  std::vector<uint64_t> keys;
+  keys.reserve(tokens.size());
   for (const auto& token : tokens) {
-    searchKV(kv, token);
+    keys.push_back(hashToken(token));
   }
+  searchKVBatch(kv, keys);
 }
 
 template <class T, class Container>
@@ -91,16 +107,59 @@ msearchKV(DocumentArray&, const Container&) {
 template <class T>
 inline void
 msearchKV(DocumentArray& kv, std::string_view tokens) {
-  auto convTokens = toVector<T>(tokens);
-  for (const auto& token : convTokens) {
-    searchKV(kv, token);
-  }
+  msearchKV<T>(kv, toVector<T>(tokens));
 }
 
 //////////////////////////////////////////////////////////////////////
 
 namespace detail {
 
+/*
+ * Keep docs (sorted by id) which are in the posting list.
+ * Probe checks each doc by exist(), for postings far outnumbering docs.
+ * Gallop walks the first n postings and gallops over docs.
+ */
+void intersectByProbe(DocumentArray& index, AnyPostingList& postingList);
+
+void intersectByGallop(DocumentArray& index,
+                       AnyPostingList& postingList,
+                       size_t n);
+
+/*
+ * Evaluate all tokens word-wise on bitmap posting lists, only docs
+ * surviving the whole expression are materialized.
+ * Return false if some posting list is not a bitmap, nothing is changed.
+ */
+bool searchBitmapIndex(DocumentArray& index,
+                       const std::string& indexName,
+                       size_t indexNo,
+                       const std::vector<uint64_t>& tokens,
+                       size_t limit,
+                       MergeType mergeType);
+
+void msearchIndex(DocumentArray& index,
+                  const std::string& indexName,
+                  size_t indexNo,
+                  const std::vector<uint64_t>& tokens,
+                  size_t limit,
+                  MergeType mergeType);
+
+/*
+ * Resolve tokens by up to `parallel` groups on the subflow, then k-way
+ * merge the sorted partial results in a final subflow task which calls
+ * `done`. The result is the same as the serial msearchIndex.
+ * kAnd/kNot and word-wise bitmap kOr run inline and call `done` directly.
+ */
+void msearchIndex(DocumentArray& index,
+                  const std::string& indexName,
+                  size_t indexNo,
+                  const std::vector<uint64_t>& tokens,
+                  size_t limit,
+                  MergeType mergeType,
+                  size_t parallel,
+                  tf::Subflow& subflow,
+                  std::function<void()> done);
+
 void searchIndex(DocumentArray& index,
                  const std::string& indexName,
                  size_t indexNo,
@@ -128,65 +187,65 @@ inline void searchIndex(DocumentArray& index,
                       offset,
                       limit,
                       mergeType);
-  if (mergeType != MergeType::kAnd) {
+  if (mergeType != MergeType::kAnd && mergeType != MergeType::kNot) {
     index.incrementTokenCount();
   }
 }
 
 template <class T, class Container>
 inline typename std::enable_if<
-  IsContainer<Container>::value && std::is_arithmetic<T>::value>::type
-msearchIndex(DocumentArray& index,
-             const std::string& indexName,
-             size_t indexNo,
-             const Container& tokens,
-             size_t limit,
-             MergeType mergeType) {
+  IsContainer<Container>::value && std::is_arithmetic<T>::value,
+  std::vector<uint64_t>>::type
+hashTokens(const Container& tokens) {
+  std::vector<uint64_t> hashedTokens;
   for (const auto& token : tokens) {
-    searchIndex(index, indexName, indexNo, to<T>(token), limit, mergeType);
+    hashedTokens.push_back(hashToken(to<T>(token)));
   }
+  return hashedTokens;
 }
 
 template <class T, class Container>
 inline typename std::enable_if<
   IsContainer<Container>::value && IsString<T>::value &&
-  IsString<typename ContainerValueType<Container>::type>::value>::type
-msearchIndex(DocumentArray& index,
-             const std::string& indexName,
-             size_t indexNo,
-             const Container& tokens,
-             size_t limit,
-             MergeType mergeType) {
+  IsString<typename ContainerValueType<Container>::type>::value,
+  std::vector<uint64_t>>::type
+hashTokens(const Container& tokens) {
+  std::vector<uint64_t> hashedTokens;
   for (const auto& token : tokens) {
-    searchIndex(index, indexName, indexNo, token, limit, mergeType);
+    hashedTokens.push_back(hashToken(token));
   }
+  return hashedTokens;
 }
 
 template <class T, class Container>
 inline typename std::enable_if<
   IsContainer<Container>::value && IsString<T>::value &&
-  !IsString<typename ContainerValueType<Container>::type>::value>::type
-msearchIndex(DocumentArray&,
-             const std::string&,
-             size_t,
-             const Container&,
-             size_t,
-             MergeType) {
+  !IsString<typename ContainerValueType<Container>::type>::value,
+  std::vector<uint64_t>>::type
+hashTokens(const Container&) {
   CRYSTAL_LOG(ERROR) << "need string-like type";
+  return {};
 }
 
 template <class T>
-inline void
-msearchIndex(DocumentArray& index,
-             const std::string& indexName,
-             size_t indexNo,
-             std::string_view tokens,
-             size_t limit,
-             MergeType mergeType) {
+inline std::vector<uint64_t> hashTokens(std::string_view tokens) {
   auto convTokens = toVector<T>(tokens);
+  std::vector<uint64_t> hashedTokens;
   for (const auto& token : convTokens) {
-    searchIndex(index, indexName, indexNo, token, limit, mergeType);
+    hashedTokens.push_back(hashToken(token));
   }
+  return hashedTokens;
+}
+
+template <class T, class Tokens>
+inline void msearchIndex(DocumentArray& index,
+                         const std::string& indexName,
+                         size_t indexNo,
+                         const Tokens& tokens,
+                         size_t limit,
+                         MergeType mergeType) {
+  detail::msearchIndex(
+      index, indexName, indexNo, hashTokens<T>(tokens), limit, mergeType);
 }
 
 } // namespace op
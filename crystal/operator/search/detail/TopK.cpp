@@ -0,0 +1,165 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/operator/search/detail/TopK.h"
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <queue>
+
+#include "crystal/operator/search/detail/Boolean.h"
+
+namespace crystal {
+namespace op {
+namespace detail {
+
+namespace {
+
+struct Cursor {
+  explicit Cursor(AnyPostingList&& pl)
+      : postingList(std::move(pl)),
+        iterator(get(postingList)->iterator()),
+        it(&std::get<ScoredPostingListIterator>(iterator)),
+        maxScore(std::get<ScoredPostingList>(postingList).maxScore()) {}
+
+  uint64_t id() const {
+    return it->isValid() ? it->value()->id : kEnd;
+  }
+
+  AnyPostingList postingList;
+  AnyPostingListIterator iterator;
+  ScoredPostingListIterator* it;
+  float maxScore;
+};
+
+typedef std::pair<float, uint64_t> Entry;
+
+// min heap on score, smaller id wins on ties
+struct EntryGreater {
+  bool operator()(const Entry& a, const Entry& b) const {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+  }
+};
+
+} // namespace
+
+bool topKSearchIndex(DocumentArray& index,
+                     const std::string& indexName,
+                     const std::vector<uint64_t>& tokens,
+                     size_t k,
+                     std::vector<std::pair<uint64_t, float>>& results) {
+  results.clear();
+  const Table* table = index.object()->table();
+  std::vector<std::unique_ptr<Cursor>> cursors;
+  for (uint64_t token : tokens) {
+    auto postingList = table->getPostingList(indexName, token);
+    if (isBlank(postingList)) {
+      continue;
+    }
+    if (!std::holds_alternative<ScoredPostingList>(postingList)) {
+      CRYSTAL_LOG(ERROR) << "index '" << indexName << "' is not scored";
+      return false;
+    }
+    auto cursor = std::make_unique<Cursor>(std::move(postingList));
+    if (cursor->id() != kEnd) {
+      cursors.push_back(std::move(cursor));
+    }
+  }
+  if (k == 0 || cursors.empty()) {
+    return true;
+  }
+
+  std::priority_queue<Entry, std::vector<Entry>, EntryGreater> heap;
+  auto threshold = [&]() {
+    return heap.size() < k
+        ? -std::numeric_limits<float>::infinity() : heap.top().first;
+  };
+  std::vector<Cursor*> cs;
+  for (auto& cursor : cursors) {
+    cs.push_back(cursor.get());
+  }
+  size_t evaluated = 0;
+  while (true) {
+    std::sort(cs.begin(), cs.end(), [](const Cursor* a, const Cursor* b) {
+      return a->id() < b->id();
+    });
+    // find pivot by list max scores
+    float th = threshold();
+    float bound = 0;
+    size_t p = 0;
+    for (; p < cs.size() && cs[p]->id() != kEnd; ++p) {
+      bound += cs[p]->maxScore;
+      if (bound > th) {
+        break;
+      }
+    }
+    if (p == cs.size() || cs[p]->id() == kEnd) {
+      break;
+    }
+    uint64_t pivot = cs[p]->id();
+    while (p + 1 < cs.size() && cs[p + 1]->id() == pivot) {
+      ++p;
+    }
+    // check pivot by block max scores
+    float blockBound = 0;
+    uint64_t next = p + 1 < cs.size() ? cs[p + 1]->id() : kEnd;
+    for (size_t i = 0; i <= p; ++i) {
+      const ScoredBlock* b = cs[i]->it->shallowSeek(pivot);
+      if (b) {
+        blockBound += b->maxScore;
+        next = std::min(next, b->lastId + 1);
+      }
+    }
+    if (blockBound <= th) {
+      // no doc before next can beat the threshold
+      for (size_t i = 0; i <= p; ++i) {
+        cs[i]->it->seekTo(next);
+      }
+      continue;
+    }
+    if (cs[0]->id() == pivot) {
+      float score = 0;
+      for (size_t i = 0; i <= p; ++i) {
+        score += cs[i]->it->score();
+        cs[i]->it->next();
+      }
+      ++evaluated;
+      if (heap.size() < k) {
+        heap.emplace(score, pivot);
+      } else if (score > heap.top().first) {
+        heap.pop();
+        heap.emplace(score, pivot);
+      }
+    } else {
+      for (size_t i = 0; i < p && cs[i]->id() < pivot; ++i) {
+        cs[i]->it->seekTo(pivot);
+      }
+    }
+  }
+  CRYSTAL_LOG(DEBUG) << "top-k search evaluated " << evaluated << " docs";
+
+  results.resize(heap.size());
+  for (size_t i = heap.size(); i > 0; --i) {
+    results[i - 1] = std::make_pair(heap.top().second, heap.top().first);
+    heap.pop();
+  }
+  return true;
+}
+
+} // namespace detail
+} // namespace op
+} // namespace crystal
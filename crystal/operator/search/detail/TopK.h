@@ -0,0 +1,48 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "crystal/dataframe/DocumentArray.h"
+
+namespace crystal {
+namespace op {
+namespace detail {
+
+/*
+ * Block-max WAND over scored posting lists of the tokens, the score of
+ * a doc is the sum of its posting scores (assumed non-negative).
+ *
+ * Cursors are kept sorted by id, the pivot is the first cursor where
+ * the sum of list max scores beats the current threshold; the pivot is
+ * then checked against the block max scores, blocks which can not beat
+ * the threshold are skipped without decoding.
+ *
+ * Return the best k (id, score) pairs in descending score order.
+ */
+bool topKSearchIndex(DocumentArray& index,
+                     const std::string& indexName,
+                     const std::vector<uint64_t>& tokens,
+                     size_t k,
+                     std::vector<std::pair<uint64_t, float>>& results);
+
+} // namespace detail
+} // namespace op
+} // namespace crystal
@@ -14,8 +14,19 @@
  * limitations under the License.
  */
 
+#include <chrono>
+
+#include "crystal/graph/Graph.h"
+#include "crystal/graph/VectorParam.h"
+#include "crystal/operator/search/BooleanSearch.h"
+#include "crystal/operator/search/RangeSearch.h"
+#include "crystal/operator/search/Rerank.h"
 #include "crystal/operator/search/Search.h"
+#include "crystal/operator/search/TopKSearch.h"
+#include "crystal/operator/search/VectorSearch.h"
+#include "crystal/foundation/SystemUtil.h"
 #include "crystal/operator/test/OperatorTest.h"
+#include "crystal/query/Query.h"
 
 using namespace crystal;
 using namespace crystal::op;
@@ -31,3 +42,674 @@ TEST_F(OperatorTest, Search) {
   view | search(tokens);
   EXPECT_EQ(7, view.getRowCount());
 }
+
+TEST_F(OperatorTest, SearchKVBatch) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  // menu is split into 3 kv segments
+  ExtendedTable* extable = factory.getExtendedTable("restaurant/menu");
+  DataView view(std::make_unique<DocumentArray>(extable));
+
+  std::vector<uint64_t> tokens = {4,1,3,2};
+  view | search(tokens);
+  EXPECT_EQ(4, view.getRowCount());
+  auto* docs = view.getBaseTable();
+  for (size_t i = 0; i < tokens.size(); ++i) {
+    EXPECT_EQ(extable->table()->find(hashToken(tokens[i])),
+              docs->getDoc(i)->id());
+    EXPECT_EQ(i, docs->getDoc(i)->tokenOffset());
+  }
+}
+
+class SearchBitmapTest : public ::testing::Test {
+ protected:
+  std::string path = getProcessName() + "_bitmap_data";
+  std::filesystem::path conf =
+    std::filesystem::path(__FILE__).parent_path() / "bitmapgroup.cson";
+
+  static float weight(int i) {
+    return float((i * 7919) % 6007) / 100;
+  }
+
+  void SetUp() override {
+    static bool sOnce = true;
+    if (sOnce) {
+      std::filesystem::remove_all(path);
+      prepare();
+      sOnce = false;
+    }
+  }
+
+  // item i is tagged with 1 + i % 2 and 3 + i % 3, and 6 if i % 100 == 0,
+  // labels and topics are the same as tags, price is i - 1000,
+  // code is "c" + i, weight is distinct for every item
+  void prepare() {
+    TableFactory factory;
+    factory.load(conf.c_str(), path.c_str(), false);
+
+    auto builder = factory.getTableGroupBuilder("shop");
+    for (int i = 0; i < 6000; ++i) {
+      dynamic tags = dynamic::array(1 + i % 2, 3 + i % 3);
+      if (i % 100 == 0) {
+        tags.push_back(6);
+      }
+      builder->add("item.*", dynamic::object
+                   ("itemId", i)("tags", tags)("labels", tags)
+                   ("price", i - 1000)("code", toString("c", i))
+                   ("topics", tags)("weight", weight(i)));
+    }
+    factory.dump();
+  }
+};
+
+TEST_F(SearchBitmapTest, Search) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("shop/item");
+  std::vector<int32_t> even = {1};
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(even, "tags")
+         | search(std::vector<int32_t>{3}, "tags", -1, MergeType::kAnd);
+    EXPECT_EQ(1000, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(even, "tags")
+         | search(std::vector<int32_t>{3, 4}, "tags", -1, MergeType::kAnd);
+    EXPECT_EQ(0, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(even, "tags")
+         | search(std::vector<int32_t>{3, 4}, "tags", -1, MergeType::kNot);
+    EXPECT_EQ(1000, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(even, "tags")
+         | search(std::vector<int32_t>{3}, "tags", -1, MergeType::kOr);
+    EXPECT_EQ(4000, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(std::vector<int32_t>{3, 4}, "tags", -1, MergeType::kOr);
+    EXPECT_EQ(4000, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(std::vector<int32_t>{3, 4}, "tags", 10, MergeType::kOr);
+    EXPECT_EQ(10, view.getRowCount());
+  }
+  // kAnd takes the first limit postings of each token, as token by token
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(even, "tags")
+         | search(std::vector<int32_t>{3, 6}, "tags", 300, MergeType::kAnd);
+    DataView serial(std::make_unique<DocumentArray>(extable));
+    serial | search(even, "tags")
+           | search(std::vector<int32_t>{3}, "tags", 300, MergeType::kAnd)
+           | search(std::vector<int32_t>{6}, "tags", 300, MergeType::kAnd);
+    EXPECT_EQ(3, view.getRowCount());
+    EXPECT_EQ(serial.getRowCount(), view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(even, "tags")
+         | search(std::vector<int32_t>{3, 6}, "tags", -1, MergeType::kNot);
+    EXPECT_EQ(1960, view.getRowCount());
+  }
+}
+
+TEST_F(SearchBitmapTest, BooleanSearch) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("shop/item");
+  auto term = [](int token) {
+    return dynamic::object("key", "tags")("token", token);
+  };
+  {
+    // even and i % 3 != 0
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | booleanSearch(dynamic::object
+                         ("and", dynamic::array(
+                           dynamic::object("not", term(3)),
+                           term(1))));
+    EXPECT_EQ(2000, view.getRowCount());
+  }
+  {
+    // (i % 3 == 0 or i % 3 == 2) and odd and not i % 3 == 2
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | booleanSearch(dynamic::object
+                         ("and", dynamic::array(
+                           dynamic::object("or", dynamic::array(
+                             term(3), term(5))),
+                           term(2),
+                           dynamic::object("not", term(5)))));
+    EXPECT_EQ(1000, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | booleanSearch(dynamic::object
+                         ("or", dynamic::array(term(3), term(4), term(9))),
+                         10);
+    EXPECT_EQ(10, view.getRowCount());
+  }
+  {
+    // i % 6 == 0 or i % 100 == 0 or i % 3 == 2
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | booleanSearch(dynamic::object
+                         ("or", dynamic::array(
+                           dynamic::object("and", dynamic::array(
+                             term(1), term(3))),
+                           term(6),
+                           term(5))));
+    EXPECT_EQ(3020, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | booleanSearch(dynamic::object
+                         ("and", dynamic::array(term(1), term(9))));
+    EXPECT_EQ(0, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | booleanSearch(dynamic::object("not", term(1)));
+    EXPECT_EQ(0, view.getRowCount());
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | booleanSearch(dynamic::object
+                         ("or", dynamic::array(
+                           term(1), dynamic::object("key", "nokey"))));
+    EXPECT_EQ(0, view.getRowCount());
+    view | booleanSearch(dynamic::object("and", term(1)));
+    EXPECT_EQ(0, view.getRowCount());
+  }
+}
+
+TEST_F(SearchBitmapTest, RangeSearch) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("shop/item");
+  auto count = [&](auto&& op) {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | op;
+    return view.getRowCount();
+  };
+  EXPECT_EQ(100, count(rangeSearch("price", "-1000", "-900")));
+  EXPECT_EQ(5, count(rangeSearch("price", "", "-995")));
+  EXPECT_EQ(5000, count(rangeSearch("price", "0", "")));
+  EXPECT_EQ(10, count(rangeSearch("price", "4990", "5000")));
+  EXPECT_EQ(0, count(rangeSearch("price", "-5000", "-1000")));
+  EXPECT_EQ(10, count(rangeSearch("price", "100", "1100", 10)));
+  EXPECT_EQ(111, count(prefixSearch("code", "c59")));
+  EXPECT_EQ(6000, count(prefixSearch("code", "c")));
+  EXPECT_EQ(1111, count(rangeSearch("code", "c1", "c2")));
+  // not range strategy
+  EXPECT_EQ(0, count(rangeSearch("tags", "1", "3")));
+}
+
+TEST_F(SearchBitmapTest, TopKSearch) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("shop/item");
+  {
+    // score is weight * (even + i % 3 == 0)
+    std::vector<float> expected;
+    for (int i = 0; i < 6000; ++i) {
+      expected.push_back(weight(i) * ((i % 2 == 0) + (i % 3 == 0)));
+    }
+    std::sort(expected.begin(), expected.end(), std::greater<float>());
+
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | topKSearch(std::string("1,3"), "topics", 20, "score");
+    ASSERT_EQ(20, view.getRowCount());
+    for (size_t i = 0; i < 20; ++i) {
+      EXPECT_FLOAT_EQ(expected[i], *view.get<float>(i, "score"));
+    }
+  }
+  {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | topKSearch(std::string("6,9"), "topics", 100);
+    EXPECT_EQ(60, view.getRowCount());
+  }
+  {
+    // not scored
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | topKSearch(std::string("1"), "labels", 10);
+    EXPECT_EQ(0, view.getRowCount());
+  }
+}
+
+TEST_F(SearchBitmapTest, AndCrossover) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("shop/item");
+  std::vector<int32_t> even = {1};
+  // docs: m even items spread over all
+  // postings: i % 3 == 0 (2000), i % 100 == 0 (60)
+  for (int32_t token : {3, 6}) {
+    auto postingList =
+      extable->table()->getPostingList("tags", hashToken(token));
+    size_t n = get(postingList)->size();
+    for (size_t m : {1, 16, 256, 1024, 3000}) {
+      U32IndexArray spread;
+      for (size_t j = 0; j < m; ++j) {
+        spread.push_back(j * 3000 / m);
+      }
+      std::chrono::nanoseconds probe{0};
+      std::chrono::nanoseconds walk{0};
+      size_t probeCount = 0;
+      size_t walkCount = 0;
+      for (int r = 0; r < 20; ++r) {
+        DocumentArray a(extable);
+        DocumentArray b(extable);
+        msearchIndex<int32_t>(a, "tags", 0, even, -1, MergeType::kAppend);
+        msearchIndex<int32_t>(b, "tags", 0, even, -1, MergeType::kAppend);
+        a.trim(spread);
+        b.trim(spread);
+        auto t0 = std::chrono::steady_clock::now();
+        op::detail::intersectByGallop(b, postingList, n);
+        auto t1 = std::chrono::steady_clock::now();
+        op::detail::intersectByProbe(a, postingList);
+        auto t2 = std::chrono::steady_clock::now();
+        walk += t1 - t0;
+        probe += t2 - t1;
+        probeCount = a.getDocCount();
+        walkCount = b.getDocCount();
+      }
+      EXPECT_EQ(probeCount, walkCount);
+      CRYSTAL_LOG(INFO) << "and " << m << " docs with " << n << " postings:"
+          << " probe " << probe.count() / 20 << "ns,"
+          << " gallop " << walk.count() / 20 << "ns";
+    }
+  }
+}
+
+TEST_F(SearchBitmapTest, ParallelSearch) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("shop/item");
+  Graph::Executor executor(4);
+  for (auto mergeType : {"Append", "Or"}) {
+    std::string tokens = "1,3,6,4";
+    DataView serial(std::make_unique<DocumentArray>(extable));
+    serial | search(tokens, "labels", -1, stringToMergeType(mergeType));
+
+    DataView view(std::make_unique<DocumentArray>(extable));
+    tf::Taskflow taskflow;
+    taskflow.emplace([&](tf::Subflow& subflow) {
+      view | search(tokens, "labels", -1, stringToMergeType(mergeType),
+                    3, &subflow);
+    });
+    executor.run(taskflow).wait();
+
+    EXPECT_EQ(serial.getRowCount(), view.getRowCount());
+    auto* a = serial.getBaseTable();
+    auto* b = view.getBaseTable();
+    EXPECT_EQ(a->getTokenCount(), b->getTokenCount());
+    for (size_t i = 0; i < a->getDocCount(); ++i) {
+      EXPECT_EQ(a->getDoc(i)->id(), b->getDoc(i)->id());
+      EXPECT_EQ(a->getDoc(i)->tokenOffset(), b->getDoc(i)->tokenOffset());
+    }
+  }
+}
+
+TEST_F(SearchBitmapTest, PostingCache) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("shop/item");
+  PostingCache& cache = extable->table()->postingCache();
+  for (auto index : {"topics", "tags", "labels"}) {
+    for (auto mergeType : {"Append", "Or"}) {
+      std::string tokens = "1,3,6";
+      DataView first(std::make_unique<DocumentArray>(extable));
+      first | search(tokens, index, -1, stringToMergeType(mergeType));
+
+      // 1 and 3 are hot, 6 is too small to be cached. Bitmap lists of
+      // kOr are merged word-wise, not by token
+      bool wordWise = index == std::string("tags") &&
+        mergeType == std::string("Or");
+      uint64_t hits = cache.hits();
+      DataView view(std::make_unique<DocumentArray>(extable));
+      view | search(tokens, index, -1, stringToMergeType(mergeType));
+      EXPECT_EQ(hits + (wordWise ? 0 : 2), cache.hits());
+
+      EXPECT_EQ(first.getRowCount(), view.getRowCount());
+      auto* a = first.getBaseTable();
+      auto* b = view.getBaseTable();
+      for (size_t i = 0; i < a->getDocCount(); ++i) {
+        EXPECT_EQ(a->getDoc(i)->id(), b->getDoc(i)->id());
+        EXPECT_EQ(a->getDoc(i)->tokenOffset(), b->getDoc(i)->tokenOffset());
+      }
+    }
+  }
+  // lists cut by limit are not cached
+  for (int i = 0; i < 2; ++i) {
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | search(std::vector<int32_t>{4}, "topics", 10);
+  }
+  EXPECT_EQ(nullptr, cache.get(extable->table()->getNoOfIndex("topics"),
+                               hashToken(int32_t(4))));
+}
+
+class SearchVectorTest : public ::testing::Test {
+ protected:
+  std::string path = getProcessName() + "_vector_data";
+  std::filesystem::path conf =
+    std::filesystem::path(__FILE__).parent_path() / "vectorgroup.cson";
+
+  void SetUp() override {
+    static bool sOnce = true;
+    if (sOnce) {
+      std::filesystem::remove_all(path);
+      prepare();
+      sOnce = false;
+    }
+  }
+
+  // point i is (i, 0, 0, 0) with id i + 1, spread over 3 index segments,
+  // embedding i is (i / 4, 1, 0, 0) with id i + 1, exact in float16 and
+  // in int8 codes of scale 0.25
+  void prepare() {
+    TableFactory factory;
+    factory.load(conf.c_str(), path.c_str(), false);
+
+    auto builder = factory.getTableGroupBuilder("space");
+    for (int i = 0; i < 300; ++i) {
+      builder->add("point.*", dynamic::object
+                   ("pointId", i)
+                   ("vec", dynamic::array(double(i), 0.0, 0.0, 0.0)));
+    }
+    for (int i = 0; i < 100; ++i) {
+      dynamic vec = dynamic::array(i * 0.25, 1.0, 0.0, 0.0);
+      builder->add("embedding.*", dynamic::object
+                   ("embeddingId", i)
+                   ("half", vec)
+                   ("code", vec));
+    }
+    factory.dump();
+  }
+};
+
+TEST_F(SearchVectorTest, VectorSearch) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("space/point");
+  std::vector<float> x = {100.2, 0, 0, 0, 7.9, 0, 0, 0};
+  Span<float> xSpan(x.data(), x.size());
+  std::vector<uint64_t> expected = {101, 102, 100, 103, 99,
+                                    9, 8, 10, 7, 11};
+
+  DataView serial(std::make_unique<DocumentArray>(extable));
+  serial | vSearch(2, xSpan, "vec", "distance", -1, 5);
+  EXPECT_EQ(10, serial.getRowCount());
+  auto* docs = serial.getBaseTable();
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], docs->getDoc(i)->id());
+    EXPECT_EQ(i / 5, docs->getDoc(i)->tokenOffset());
+  }
+
+  Graph::Executor executor(4);
+  DataView view(std::make_unique<DocumentArray>(extable));
+  tf::Taskflow taskflow;
+  taskflow.emplace([&](tf::Subflow& subflow) {
+    view | vSearch(2, xSpan, "vec", "distance", -1, 5, false, &subflow);
+  });
+  executor.run(taskflow).wait();
+  EXPECT_EQ(10, view.getRowCount());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], view.getBaseTable()->getDoc(i)->id());
+  }
+
+  // a single segment holds every third point
+  DataView one(std::make_unique<DocumentArray>(extable));
+  one | vSearch(1, Span<float>(x.data(), 4), "vec", "distance", 0, 5);
+  EXPECT_EQ(5, one.getRowCount());
+  for (size_t i = 0; i < 5; ++i) {
+    EXPECT_EQ(0, one.getBaseTable()->getDoc(i)->id() % 3);
+  }
+}
+
+TEST_F(SearchVectorTest, Filter) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("space/point");
+  std::vector<float> x = {48.6, 0, 0, 0};
+  Span<float> xSpan(x.data(), x.size());
+  auto filterBy = [&](DataView& view, const std::vector<uint64_t>& ids) {
+    auto* docs = view.getBaseTable();
+    for (auto id : ids) {
+      docs->docs().emplace(extable, 0, id);
+    }
+    docs->incrementTokenCount();
+    view.docIndex().resize(docs->getDocCount());
+  };
+
+  // few candidates, scanned directly, 99999 is not indexed
+  DataView few(std::make_unique<DocumentArray>(extable));
+  filterBy(few, {200, 5, 51, 50, 290, 99999, 50});
+  few | vSearch(1, xSpan, "vec", "distance", -1, 3, true);
+  std::vector<uint64_t> expected = {50, 51, 5};
+  EXPECT_EQ(3, few.getRowCount());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], few.getBaseTable()->getDoc(i)->id());
+  }
+
+  // even ids, searched with a selector
+  DataView many(std::make_unique<DocumentArray>(extable));
+  std::vector<uint64_t> even;
+  for (uint64_t id = 2; id <= 300; id += 2) {
+    even.push_back(id);
+  }
+  filterBy(many, even);
+  many | vSearch(1, xSpan, "vec", "distance", -1, 3, true);
+  expected = {50, 48, 52};
+  EXPECT_EQ(3, many.getRowCount());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], many.getBaseTable()->getDoc(i)->id());
+  }
+}
+
+TEST_F(SearchVectorTest, LargeBatch) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("space/point");
+  // n * k of 256k results, used to overflow the stack of the thread
+  int64_t n = 256;
+  int64_t k = 1000;
+  std::vector<float> x(n * 4, 0);
+  for (int64_t i = 0; i < n; ++i) {
+    x[i * 4] = i;
+  }
+  DataView view(std::make_unique<DocumentArray>(extable));
+  Span<float> xSpan(x.data(), x.size());
+  view | vSearch(n, xSpan, "vec", "distance", -1, k);
+  EXPECT_EQ(n * 300, view.getRowCount());
+  for (int64_t i = 0; i < n; ++i) {
+    EXPECT_EQ(i + 1, view.getBaseTable()->getDoc(i * 300)->id());
+  }
+}
+
+TEST_F(SearchVectorTest, Rerank) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("space/point");
+  std::vector<float> x = {48.6, 0, 0, 0, 7.9, 0, 0, 0};
+  Span<float> xSpan(x.data(), x.size());
+
+  // candidates of the 2 queries in any order, 99999 has no vector
+  DataView view(std::make_unique<DocumentArray>(extable));
+  auto* docs = view.getBaseTable();
+  for (auto id : {200, 5, 99999, 51, 50}) {
+    docs->docs().emplace(extable, 0, id);
+  }
+  docs->incrementTokenCount();
+  for (auto id : {3, 10, 8}) {
+    docs->docs().emplace(extable, 1, id);
+  }
+  docs->incrementTokenCount();
+  view.docIndex().resize(docs->getDocCount());
+
+  view | op::rerank(2, xSpan, "vec", "distance");
+  std::vector<uint64_t> expected = {50, 51, 5, 200, 99999, 8, 10, 3};
+  std::vector<float> distances = {0.16, 1.96, 44.6 * 44.6, 150.4 * 150.4, -1,
+                                  0.81, 1.21, 34.81};
+  EXPECT_EQ(expected.size(), view.getRowCount());
+  for (size_t i = 0; i < expected.size(); ++i) {
+    EXPECT_EQ(expected[i], view.getDoc(view.getIndexOfDoc(i))->id());
+    if (distances[i] >= 0) {
+      EXPECT_NEAR(distances[i], *view.get<float>(i, "distance"), 1e-2);
+    }
+  }
+
+  // rows of earlier tokens keep their positions among the candidates
+  {
+    std::vector<float> y = {7.9, 0, 0, 0};
+    DataView mixed(std::make_unique<DocumentArray>(extable));
+    auto* mixedDocs = mixed.getBaseTable();
+    mixedDocs->docs().emplace(extable, 1, 3);
+    mixedDocs->docs().emplace(extable, 0, 7);
+    mixedDocs->docs().emplace(extable, 1, 10);
+    mixedDocs->docs().emplace(extable, 1, 8);
+    mixedDocs->docs().emplace(extable, 0, 6);
+    mixedDocs->incrementTokenCount(2);
+    mixed.docIndex().resize(mixedDocs->getDocCount());
+
+    mixed | op::rerank(1, Span<float>(y.data(), y.size()), "vec", "distance");
+    std::vector<uint64_t> mixedIds = {8, 7, 10, 3, 6};
+    ASSERT_EQ(mixedIds.size(), mixed.getRowCount());
+    for (size_t i = 0; i < mixedIds.size(); ++i) {
+      EXPECT_EQ(mixedIds[i], mixed.getDoc(mixed.getIndexOfDoc(i))->id());
+    }
+  }
+
+  // exact distances of the approximate results
+  DataView searched(std::make_unique<DocumentArray>(extable));
+  searched | vSearch(2, xSpan, "vec", "distance", -1, 5);
+  std::vector<uint64_t> ids;
+  for (size_t i = 0; i < searched.getRowCount(); ++i) {
+    ids.push_back(searched.getDoc(searched.getIndexOfDoc(i))->id());
+  }
+  searched | op::rerank(2, xSpan, "vec", "distance");
+  for (size_t i = 0; i < searched.getRowCount(); ++i) {
+    EXPECT_EQ(ids[i], searched.getDoc(searched.getIndexOfDoc(i))->id());
+  }
+}
+
+TEST_F(SearchVectorTest, QuantizedRerank) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("space/embedding");
+  std::vector<float> x = {10.1, 1, 0, 0, 2, 1, 0, 0};
+  auto candidates = [&](DataView& view, std::vector<uint64_t> ids) {
+    auto* docs = view.getBaseTable();
+    for (auto id : ids) {
+      docs->docs().emplace(extable, 0, id);
+    }
+    docs->incrementTokenCount();
+    view.docIndex().resize(docs->getDocCount());
+  };
+  auto check = [](DataView& view,
+                  const std::vector<uint64_t>& expected,
+                  const std::vector<float>& distances) {
+    EXPECT_EQ(expected.size(), view.getRowCount());
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(expected[i], view.getDoc(view.getIndexOfDoc(i))->id());
+      EXPECT_NEAR(distances[i], *view.get<float>(i, "distance"), 1e-4);
+    }
+  };
+
+  // L2 on float16
+  DataView half(std::make_unique<DocumentArray>(extable));
+  candidates(half, {42, 40, 41, 1});
+  half | op::rerank(1, Span<float>(x.data(), 4), "half", "distance");
+  check(half, {41, 42, 40, 1}, {0.01, 0.0225, 0.1225, 102.01});
+
+  // inner product on int8 codes, query (8, 4, 0, 0) in codes
+  DataView code(std::make_unique<DocumentArray>(extable));
+  candidates(code, {3, 90, 11});
+  code | op::rerank(1, Span<float>(x.data() + 4, 4), "code", "distance");
+  check(code, {90, 11, 3}, {45.5, 6, 2});
+
+  // the indexes are built on the decoded vectors
+  DataView searched(std::make_unique<DocumentArray>(extable));
+  searched | vSearch(1, Span<float>(x.data(), 4), "half", "distance", -1, 2);
+  EXPECT_EQ(2, searched.getRowCount());
+  EXPECT_EQ(41, searched.getBaseTable()->getDoc(0)->id());
+  EXPECT_EQ(42, searched.getBaseTable()->getDoc(1)->id());
+}
+
+// query vectors as decimals, base64 or raw attachment
+TEST_F(SearchVectorTest, BinaryQuery) {
+  TableFactory factory;
+  EXPECT_TRUE(factory.load(conf.c_str(), path.c_str(), true));
+
+  ExtendedTable* extable = factory.getExtendedTable("space/point");
+  std::vector<float> x = {100.2, 0, 0, 0, 7.9, 0, 0, 0};
+  std::string raw(reinterpret_cast<const char*>(x.data()),
+                  x.size() * sizeof(float));
+  std::vector<uint64_t> expected = {101, 102, 100, 103, 99,
+                                    9, 8, 10, 7, 11};
+  auto search = [&](const dynamic& param,
+                    const Attachments* attachments = nullptr) {
+    VectorParam xParam;
+    std::vector<uint64_t> ids;
+    if (!xParam.parse(param, attachments)) {
+      return ids;
+    }
+    EXPECT_EQ(0, uintptr_t(xParam.span().data()) % VectorParam::kAlignment);
+    DataView view(std::make_unique<DocumentArray>(extable));
+    view | vSearch(2, xParam.span(), "vec", "distance", -1, 5);
+    for (size_t i = 0; i < view.getRowCount(); ++i) {
+      ids.push_back(view.getDoc(view.getIndexOfDoc(i))->id());
+    }
+    return ids;
+  };
+
+  EXPECT_EQ(expected, search("100.2, 0,0,0,7.9,0,0,0,"));
+  EXPECT_EQ(expected, search(dynamic::object("base64", base64Encode(raw))));
+  EXPECT_EQ(expected, search(dynamic::object("raw", raw)));
+  // not whole floats
+  EXPECT_TRUE(search(dynamic::object("base64", base64Encode("abcde"))).empty());
+  EXPECT_TRUE(search(dynamic::object("base64", "YWJj*A==")).empty());
+
+  // attachments behind the query of a body
+  Graph::Executor executor(1);
+  Query query(&factory, &executor);
+  std::string body = "{path=\"space/point\"}" + raw + "12";
+  EXPECT_FALSE(query.attachFrom(body, "x:1000"));
+  // the sum of the sizes wraps around
+  EXPECT_FALSE(query.attachFrom(body, "x:2,y:18446744073709551615"));
+  EXPECT_TRUE(query.attachFrom(body, "x:" + std::to_string(raw.size()) +
+                                     ",y:2"));
+  EXPECT_EQ("{path=\"space/point\"}", body);
+  dynamic param = dynamic::object
+    ("n", 2)
+    ("x", dynamic::object("attachment", "x"));
+  EXPECT_TRUE(query.checkAttachments(param));
+  // viewed in the body taken by the query, not copied
+  std::string_view xView = query.attachments().at("x");
+  EXPECT_EQ(raw, xView);
+  EXPECT_EQ(query.attachments().at("y").data(),
+            xView.data() + xView.size());
+  EXPECT_EQ(expected, search(param["x"], &query.attachments()));
+  EXPECT_TRUE(search(param["x"]).empty());
+  param["x"] = dynamic::object("attachment", "z");
+  EXPECT_FALSE(query.checkAttachments(param));
+  EXPECT_TRUE(search(param["x"], &query.attachments()).empty());
+}
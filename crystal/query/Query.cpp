@@ -16,13 +16,80 @@
 
 #include "crystal/query/Query.h"
 
+#include <utility>
+#include <vector>
+
+#include "crystal/foundation/String.h"
 #include "crystal/graph/Graph.h"
 #include "crystal/operator/generic/Serialize.h"
 
 namespace crystal {
 
 Query::Query(TableFactory* factory, Graph::Executor* executor, bool useCson)
-    : factory_(factory), graph_(executor), useCson_(useCson) {
+    : factory_(factory), graph_(executor, &attachments_), useCson_(useCson) {
+}
+
+void Query::attach(const std::string& name, std::string data) {
+  buffers_.push_back(std::move(data));
+  attachments_[name] = buffers_.back();
+}
+
+bool Query::attachFrom(std::string& body, std::string_view spec) {
+  std::vector<std::string_view> items;
+  split(',', trimWhitespace(spec), items, true);
+  std::vector<std::pair<std::string, size_t>> sizes;
+  size_t total = 0;
+  for (auto item : items) {
+    std::string_view name;
+    size_t size;
+    if (!split(':', trimWhitespace(item), name, size)) {
+      CRYSTAL_LOG(ERROR) << "invalid attachment spec: " << spec;
+      return false;
+    }
+    // checked one by one, the sum may wrap around
+    if (size > body.size() - total) {
+      CRYSTAL_LOG(ERROR) << "attachments over body size: "
+          << total << "+" << size << ">" << body.size();
+      return false;
+    }
+    sizes.emplace_back(std::string(name), size);
+    total += size;
+  }
+  // attachments are viewed in the body, only the query before is copied
+  buffers_.push_back(std::move(body));
+  std::string_view owned = buffers_.back();
+  size_t offset = owned.size() - total;
+  body.assign(owned.substr(0, offset));
+  for (auto& p : sizes) {
+    attachments_[p.first] = owned.substr(offset, p.second);
+    offset += p.second;
+  }
+  return true;
+}
+
+bool Query::checkAttachments(const dynamic& param) const {
+  if (param.isObject()) {
+    if (auto* name = param.get_ptr("attachment")) {
+      if (attachments_.find(name->asString()) == attachments_.end()) {
+        CRYSTAL_LOG(ERROR) << "attachment '" << name->asString()
+            << "' not found";
+        return false;
+      }
+      return true;
+    }
+    for (auto& item : param.items()) {
+      if (!checkAttachments(item.second)) {
+        return false;
+      }
+    }
+  } else if (param.isArray()) {
+    for (auto& value : param) {
+      if (!checkAttachments(value)) {
+        return false;
+      }
+    }
+  }
+  return true;
 }
 
 DataView Query::run() {
@@ -34,6 +101,9 @@ DataView Query::run() {
     CRYSTAL_LOG(ERROR) << "table at path '" << path << "' not exist";
     return view;
   }
+  if (!attachments_.empty() && !checkAttachments(jq["graph"])) {
+    return view;
+  }
   view = DataView(std::make_unique<DocumentArray>(extable));
   graph_.gen(jq["graph"]);
   graph_.run(&view);
@@ -16,6 +16,10 @@
 
 #pragma once
 
+#include <deque>
+#include <string>
+#include <string_view>
+
 #include "crystal/graph/Graph.h"
 #include "crystal/storage/table/TableFactory.h"
 
@@ -38,6 +42,22 @@ class Query {
     return query_;
   }
 
+  // binary data of the query, read in place by ops of an op param
+  // {attachment="name"}, e.g. query vectors as float32s
+  void attach(const std::string& name, std::string data);
+
+  // take the body and view the attachments off its tail, spec is their
+  // names and sizes in order as "name:size,...". body is left with the
+  // query before them
+  bool attachFrom(std::string& body, std::string_view spec);
+
+  // check the {attachment="name"} params, false if not found
+  bool checkAttachments(const dynamic& param) const;
+
+  const Attachments& attachments() const {
+    return attachments_;
+  }
+
   DataView run();
 
   std::string runAndToJson(bool tableMode, bool prettify);
@@ -48,6 +68,9 @@ class Query {
   Graph graph_;
   bool useCson_;
   std::string query_;
+  // bodies and data the attachments view, not moved once added
+  std::deque<std::string> buffers_;
+  Attachments attachments_;
 };
 
 }  // namespace crystal
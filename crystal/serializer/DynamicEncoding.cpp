@@ -16,6 +16,10 @@
 
 #include "crystal/serializer/DynamicEncoding.h"
 
+#include <vector>
+
+#include "crystal/math/Quantize.h"
+
 namespace crystal {
 
 namespace detail {
@@ -43,6 +47,32 @@ void parseField(const dynamic& j, Record& value, const FieldMeta& meta) {
   }
 }
 
+// float vector encoded to int8 codes of the field scale
+void parseQuantizedField(
+    const dynamic& j, Record& value, const FieldMeta& meta) {
+  if (!j.isArray()) {
+    CRYSTAL_THROW(RuntimeError, "not array value");
+  }
+  size_t n = j.size();
+  if (meta.isVarArray()) {
+    value.rebuildVarArray(meta, n);
+  } else if (meta.count() != n) {
+    CRYSTAL_THROW(LengthError, "unequal array size: ", meta.count(), "!=", n);
+  }
+  if (n > 0) {
+    std::vector<float> x(n);
+    for (size_t i = 0; i < n; ++i) {
+      decode(j[i], x[i]);
+    }
+    std::vector<int8_t> codes(n);
+    quantizeInt8(x.data(), n, meta.scale(), codes.data());
+    Array<int8_t> a = value.get<Array<int8_t>>(meta);
+    for (size_t i = 0; i < n; ++i) {
+      a.set(i, codes[i]);
+    }
+  }
+}
+
 } // namespace detail
 
 void decode(const dynamic& j, Record& value) {
@@ -59,7 +89,6 @@ void decode(const dynamic& j, Record& value) {
     break;
 
         DECODE(bool, BOOL)
-        DECODE(int8_t, INT8)
         DECODE(int16_t, INT16)
         DECODE(int32_t, INT32)
         DECODE(int64_t, INT64)
@@ -69,10 +98,19 @@ void decode(const dynamic& j, Record& value) {
         DECODE(uint64_t, UINT64)
         DECODE(float, FLOAT)
         DECODE(double, DOUBLE)
+        DECODE(float16, FLOAT16)
         DECODE(std::string_view, STRING)
 
 #undef DECODE
 
+        case DataType::INT8:
+          if (meta->isQuantized()) {
+            detail::parseQuantizedField(kv.second, value, *meta);
+          } else {
+            detail::parseField<int8_t>(kv.second, value, *meta);
+          }
+          break;
+
         case DataType::UNKNOWN:
           CRYSTAL_LOG(ERROR) << "unsupport data type: "
               << dataTypeToString(meta->type());
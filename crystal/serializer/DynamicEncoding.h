@@ -63,6 +63,10 @@ inline dynamic encode(const char* value) {
   return value;
 }
 
+inline dynamic encode(float16 value) {
+  return float(value);
+}
+
 inline void decode(const dynamic& j, bool& value) {
   checkType<bool>(j);
   value = j.getBool();
@@ -16,11 +16,15 @@
 
 #include "crystal/serializer/record/Accessor.h"
 
+#include <cstring>
+
+#include "crystal/foundation/BitMask.h"
 #include "crystal/math/Div.h"
 
 namespace crystal {
 
-Accessor::Accessor(const RecordMeta& recordMeta) {
+Accessor::Accessor(const RecordMeta& recordMeta, bool packed)
+    : packed_(packed) {
   int blockCount = recordMeta.maxTag() + 1;
   blocks_.resize(blockCount);
   for (auto& meta : recordMeta) {
@@ -53,6 +57,30 @@ Accessor::Accessor(const RecordMeta& recordMeta) {
   hasOffset_ = byteSize;
   byteSize += div8(blockCount);
   bufferSize_ = div8(byteSize) * 8;
+
+  if (packed_) {
+    fixedBitOffset_ = bitOffset_;
+    fixedHasOffset_ = hasOffset_;
+    fixedSize_ = bufferSize_;
+    // the has bitmap is read by words
+    hasOffset_ = 0;
+    bitOffset_ = div64(blockCount) * 8;
+    byteOffset_ = bitOffset_ + fixedHasOffset_ - fixedBitOffset_;
+    byteFields_.resize(div64(blockCount));
+    size_t byteCount = 0;
+    for (auto& block : blocks_) {
+      if (block.byteSize > 0) {
+        byteFields_[block.tag / 64] |= uint64_t(1) << (block.tag % 64);
+        ++byteCount;
+      }
+    }
+    bufferSize_ = byteOffset_ + tableSize(byteCount) + fixedBitOffset_;
+
+    defaults_.resize(div8(fixedSize_));
+    Accessor(recordMeta).reset(defaults_.data(), nullptr, recordMeta);
+    packedDefaults_.resize(div8(packedSize(defaults_.data())));
+    pack(defaults_.data(), packedDefaults_.data());
+  }
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -67,6 +95,94 @@ void Accessor::setHasField(void* buf, const FieldMeta& meta, bool set) const {
   OffsetBitMask{ptr + hasOffset_, meta.tag()}.set(set);
 }
 
+const uint8_t* Accessor::getPackedBytes(
+    const uint8_t* buf, const FieldBlock& block) const {
+  BitMask has(const_cast<uint8_t*>(buf));
+  if (!has.isSet(block.tag)) {
+    return reinterpret_cast<const uint8_t*>(defaults_.data())
+      + block.byteOffset;
+  }
+  // the rank of the field in the byte fields set indexes the offset table
+  size_t rank = 0;
+  size_t last = block.tag / 64;
+  for (size_t i = 0; i <= last; ++i) {
+    uint64_t word;
+    memcpy(&word, buf + i * 8, sizeof(word));
+    word &= byteFields_[i];
+    if (i == last) {
+      word &= (uint64_t(1) << (block.tag % 64)) - 1;
+    }
+    rank += __builtin_popcountll(word);
+  }
+  uint32_t offset;
+  memcpy(&offset, buf + byteOffset_ + rank * sizeof(offset), sizeof(offset));
+  return buf + offset;
+}
+
+size_t Accessor::tableSize(size_t count) {
+  return div8(count * sizeof(uint32_t)) * 8;
+}
+
+size_t Accessor::packedSize(const void* fixedBuf) const {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(fixedBuf);
+  BitMask has(const_cast<uint8_t*>(in + fixedHasOffset_));
+  size_t count = 0;
+  size_t size = 0;
+  for (auto& block : blocks_) {
+    if (block.byteSize > 0 && has.isSet(block.tag)) {
+      ++count;
+      size += block.byteSize;
+    }
+  }
+  return byteOffset_ + tableSize(count) + size;
+}
+
+void Accessor::pack(const void* fixedBuf, void* buf) const {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(fixedBuf);
+  uint8_t* out = reinterpret_cast<uint8_t*>(buf);
+  BitMask has(const_cast<uint8_t*>(in + fixedHasOffset_));
+  memset(out, 0, bitOffset_);
+  memcpy(out, in + fixedHasOffset_, div8(blocks_.size()));
+  memcpy(out + bitOffset_, in + fixedBitOffset_,
+         fixedHasOffset_ - fixedBitOffset_);
+  size_t count = 0;
+  for (auto& block : blocks_) {
+    if (block.byteSize > 0 && has.isSet(block.tag)) {
+      ++count;
+    }
+  }
+  uint8_t* table = out + byteOffset_;
+  uint32_t offset = byteOffset_ + tableSize(count);
+  memset(table, 0, tableSize(count));
+  for (auto& block : blocks_) {
+    if (block.byteSize > 0 && has.isSet(block.tag)) {
+      memcpy(table, &offset, sizeof(offset));
+      table += sizeof(offset);
+      memcpy(out + offset, in + block.byteOffset, block.byteSize);
+      offset += block.byteSize;
+    }
+  }
+}
+
+void Accessor::unpack(const void* buf, void* fixedBuf) const {
+  const uint8_t* in = reinterpret_cast<const uint8_t*>(buf);
+  uint8_t* out = reinterpret_cast<uint8_t*>(fixedBuf);
+  BitMask has(const_cast<uint8_t*>(in));
+  memcpy(out, defaults_.data(), fixedSize_);
+  memcpy(out + fixedHasOffset_, in, div8(blocks_.size()));
+  memcpy(out + fixedBitOffset_, in + bitOffset_,
+         fixedHasOffset_ - fixedBitOffset_);
+  const uint8_t* table = in + byteOffset_;
+  for (auto& block : blocks_) {
+    if (block.byteSize > 0 && has.isSet(block.tag)) {
+      uint32_t offset;
+      memcpy(&offset, table, sizeof(offset));
+      table += sizeof(offset);
+      memcpy(out + block.byteOffset, in + offset, block.byteSize);
+    }
+  }
+}
+
 static bool resetOneImpl(
     const FieldMeta& meta,
     uint8_t* buf,
@@ -101,6 +217,7 @@ static bool resetOneImpl(
     RESET(uint64_t, UINT64)
     RESET(float, FLOAT)
     RESET(double, DOUBLE)
+    RESET(float16, FLOAT16)
 
 #undef RESET
 
@@ -169,6 +286,9 @@ bool Accessor::resetArray(
 
 bool Accessor::reset(
     void* buf, Allocator* alloc, const RecordMeta& recordMeta) const {
+  if (!checkWritable()) {
+    return false;
+  }
   for (auto& meta : recordMeta) {
     if (!(meta.isArray() ? resetArray(buf, alloc, meta)
                          : resetOne(buf, alloc, meta))) {
@@ -199,6 +319,7 @@ bool Accessor::mergeOne(
     COPY(uint64_t, UINT64)
     COPY(float, FLOAT)
     COPY(double, DOUBLE)
+    COPY(float16, FLOAT16)
     COPY(std::string_view, STRING)
 
 #undef COPY
@@ -231,6 +352,7 @@ bool Accessor::mergeArray(
     COPY(uint64_t, UINT64)
     COPY(float, FLOAT)
     COPY(double, DOUBLE)
+    COPY(float16, FLOAT16)
     COPY(std::string_view, STRING)
 
 #undef COPY
@@ -247,6 +369,9 @@ bool Accessor::merge(
     void* buf, Allocator* alloc,
     const void* srcBuf, Allocator* srcAlloc, const Accessor* other,
     const RecordMeta& recordMeta) const {
+  if (!checkWritable()) {
+    return false;
+  }
   for (auto& meta : recordMeta) {
     if (other->hasField(srcBuf, meta)) {
       if (!(meta.isArray()
@@ -299,6 +424,9 @@ bool Accessor::buildVarArray(
 
 bool Accessor::rebuildVarArray(
     void* buf, Allocator* alloc, const FieldMeta& meta, size_t size) const {
+  if (!checkWritable()) {
+    return false;
+  }
   if (!resetArray(buf, alloc, meta)) {
     CRYSTAL_LOG(ERROR) << "reset array '" << meta.name() << "' failed";
     return false;
@@ -16,19 +16,34 @@
 
 #pragma once
 
+#include <cstring>
 #include <string>
 #include <string_view>
 #include <vector>
 
+#include "crystal/foundation/Logging.h"
 #include "crystal/serializer/record/Array.h"
 #include "crystal/serializer/record/FieldBlock.h"
 #include "crystal/serializer/record/RecordMeta.h"
 
 namespace crystal {
 
+/*
+ * Field layout of a record buffer.
+ *
+ * A fixed buffer keeps every field at the same offset. A packed buffer,
+ * made by pack(), starts with the has bitmap and the bit fields, then
+ * holds only the byte fields set, in tag order, so unset fields take no
+ * room. A table of their offsets follows the bit fields, indexed by the
+ * rank of the field in the has bitmap, so a read does not walk the
+ * fields before it. Fields are not aligned there and are read by copy.
+ * A packed accessor reads in place, fields unset read as default, but
+ * does not write: records are modified in the fixed layout and packed
+ * again.
+ */
 class Accessor {
  public:
-  explicit Accessor(const RecordMeta& recordMeta);
+  explicit Accessor(const RecordMeta& recordMeta, bool packed = false);
   virtual ~Accessor() {}
 
   template <class T>
@@ -102,8 +117,22 @@ class Accessor {
   }
 
   size_t bitOffset() const;
+  // of a record with all fields set if packed
   size_t bufferSize() const;
 
+  bool packed() const;
+
+  /*
+   * packed only, buffers of the fixed layout are fixedSize() long
+   */
+
+  // a packed record of default values
+  const void* defaultBuffer() const;
+  size_t fixedSize() const;
+  size_t packedSize(const void* fixedBuf) const;
+  void pack(const void* fixedBuf, void* buf) const;
+  void unpack(const void* buf, void* fixedBuf) const;
+
   bool hasField(const void* buf, const FieldMeta& meta) const;
 
   bool reset(void* buf, Allocator* alloc, const RecordMeta& recordMeta) const;
@@ -134,6 +163,14 @@ class Accessor {
 
   void setHasField(void* buf, const FieldMeta& meta, bool set) const;
 
+  // the bytes of a byte field
+  const uint8_t* getBytes(const uint8_t* buf, const FieldBlock& block) const;
+  const uint8_t* getPackedBytes(
+      const uint8_t* buf, const FieldBlock& block) const;
+  // of the offset table of count byte fields, if packed
+  static size_t tableSize(size_t count);
+  bool checkWritable() const;
+
   const FieldBlock& getFieldBlock(const FieldMeta& meta) const;
 
   bool resetOne(void* buf, Allocator* alloc, const FieldMeta& meta) const;
@@ -161,6 +198,19 @@ class Accessor {
   size_t bitOffset_{0};
   size_t hasOffset_{0};
   size_t bufferSize_{0};
+
+  bool packed_;
+  // of the offset table, if packed
+  size_t byteOffset_{0};
+  // has bits of the byte fields, if packed
+  std::vector<uint64_t> byteFields_;
+  // offsets of the fixed layout, if packed
+  size_t fixedBitOffset_{0};
+  size_t fixedHasOffset_{0};
+  size_t fixedSize_{0};
+  // default record of the fixed layout, and packed
+  std::vector<uint64_t> defaults_;
+  std::vector<uint64_t> packedDefaults_;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -171,7 +221,9 @@ inline T Accessor::getNumeric(
   const FieldBlock& block = getFieldBlock(meta);
   const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buf);
   if (!meta.isCompact()) {
-    return *reinterpret_cast<const T*>(ptr + block.byteOffset);
+    T value;
+    memcpy(&value, getBytes(ptr, block), sizeof(T));
+    return value;
   }
   Bitset bits(meta.bits());
   bits.deserialize(ptr + bitOffset_, block.bitOffset, block.mask);
@@ -191,7 +243,8 @@ inline std::string_view Accessor::getString(
     const void* buf, const Allocator* alloc, const FieldMeta& meta) const {
   const FieldBlock& block = getFieldBlock(meta);
   const uint8_t* ptr = reinterpret_cast<const uint8_t*>(buf);
-  int64_t offset = *reinterpret_cast<const int64_t*>(ptr + block.byteOffset);
+  int64_t offset;
+  memcpy(&offset, getBytes(ptr, block), sizeof(offset));
   if (offset == 0) {
     return meta.dflt<std::string_view>();
   }
@@ -246,6 +299,9 @@ struct Accessor::GetImpl<std::string> {
 template <class T>
 inline bool Accessor::setNumeric(
     void* buf, Allocator*, const FieldMeta& meta, const T& value) const {
+  if (!checkWritable()) {
+    return false;
+  }
   const FieldBlock& block = getFieldBlock(meta);
   uint8_t* ptr = reinterpret_cast<uint8_t*>(buf);
   if (!meta.isCompact()) {
@@ -260,6 +316,9 @@ inline bool Accessor::setNumeric(
 
 inline bool Accessor::setBool(
     void* buf, Allocator*, const FieldMeta& meta, const bool& value) const {
+  if (!checkWritable()) {
+    return false;
+  }
   const FieldBlock& block = getFieldBlock(meta);
   uint8_t* ptr = reinterpret_cast<uint8_t*>(buf);
   Bitset bits(1, value ? 1 : 0);
@@ -271,6 +330,9 @@ inline bool Accessor::setBool(
 inline bool Accessor::setString(
     void* buf, Allocator* alloc, const FieldMeta& meta,
     const std::string_view& value) const {
+  if (!checkWritable()) {
+    return false;
+  }
   const FieldBlock& block = getFieldBlock(meta);
   uint8_t* ptr = reinterpret_cast<uint8_t*>(buf);
   int64_t& offset = *reinterpret_cast<int64_t*>(ptr + block.byteOffset);
@@ -341,13 +403,15 @@ inline Array<T> Accessor::mgetNumeric(
   uint8_t* ptr = reinterpret_cast<uint8_t*>(const_cast<void*>(buf));
   if (meta.isFixArray()) {
     return Array<T>(
-        meta.isCompact() ? ptr + bitOffset_ : ptr + block.byteOffset,
+        meta.isCompact() ? ptr + bitOffset_
+                         : const_cast<uint8_t*>(getBytes(ptr, block)),
         meta.count(),
         meta.isCompact() ? block.bitOffset : 0,
         meta.isCompact() ? block.itemBitSize : 0,
         OffsetBitMask(ptr + hasOffset_, meta.tag()));
   }
-  int64_t offset = *reinterpret_cast<int64_t*>(ptr + block.byteOffset);
+  int64_t offset;
+  memcpy(&offset, getBytes(ptr, block), sizeof(offset));
   if (offset == 0) {
     return Array<T>(nullptr, 0);
   }
@@ -374,7 +438,8 @@ inline Array<bool> Accessor::mgetBool(
         block.bitOffset,
         OffsetBitMask(ptr + hasOffset_, meta.tag()));
   }
-  int64_t offset = *reinterpret_cast<int64_t*>(ptr + block.byteOffset);
+  int64_t offset;
+  memcpy(&offset, getBytes(ptr, block), sizeof(offset));
   if (offset == 0) {
     return Array<bool>(nullptr, 0);
   }
@@ -395,13 +460,14 @@ inline Array<std::string_view> Accessor::mgetString(
   uint8_t* ptr = reinterpret_cast<uint8_t*>(const_cast<void*>(buf));
   if (meta.isFixArray()) {
     return Array<std::string_view>(
-        ptr + block.byteOffset,
+        const_cast<uint8_t*>(getBytes(ptr, block)),
         meta.count(),
         alloc,
         meta.dflt<std::string_view>(),
         OffsetBitMask(ptr + hasOffset_, meta.tag()));
   }
-  int64_t offset = *reinterpret_cast<int64_t*>(ptr + block.byteOffset);
+  int64_t offset;
+  memcpy(&offset, getBytes(ptr, block), sizeof(offset));
   if (offset == 0) {
     return Array<std::string_view>(nullptr, 0, alloc);
   }
@@ -469,10 +535,35 @@ inline size_t Accessor::bitOffset() const {
   return bitOffset_;
 }
 
+inline bool Accessor::packed() const {
+  return packed_;
+}
+
+inline const void* Accessor::defaultBuffer() const {
+  return packedDefaults_.data();
+}
+
+inline size_t Accessor::fixedSize() const {
+  return fixedSize_;
+}
+
 inline const FieldBlock& Accessor::getFieldBlock(const FieldMeta& meta) const {
   return blocks_[meta.tag()];
 }
 
+inline const uint8_t* Accessor::getBytes(
+    const uint8_t* buf, const FieldBlock& block) const {
+  return packed_ ? getPackedBytes(buf, block) : buf + block.byteOffset;
+}
+
+inline bool Accessor::checkWritable() const {
+  if (packed_) {
+    CRYSTAL_LOG(ERROR) << "write packed record";
+    return false;
+  }
+  return true;
+}
+
 template <class T>
 bool Accessor::mergeArrayImpl(
     void* buf, Allocator* alloc,
@@ -217,6 +217,7 @@ template <> struct IsArray<Array<uint32_t>> : std::true_type {};
 template <> struct IsArray<Array<uint64_t>> : std::true_type {};
 template <> struct IsArray<Array<float>> : std::true_type {};
 template <> struct IsArray<Array<double>> : std::true_type {};
+template <> struct IsArray<Array<float16>> : std::true_type {};
 template <> struct IsArray<Array<std::string>> : std::true_type {};
 template <> struct IsArray<Array<std::string_view>> : std::true_type {};
 
@@ -24,19 +24,22 @@ FieldMeta::FieldMeta()
       type_(DataType::UNKNOWN),
       bits_(0),
       count_(1),
-      compact_(false) {}
+      compact_(false),
+      scale_(0) {}
 
 FieldMeta::FieldMeta(const std::string& name,
                      int tag,
                      DataType type,
                      size_t bits,
                      size_t count,
-                     const dynamic& dflt)
+                     const dynamic& dflt,
+                     float scale)
     : name_(name),
       tag_(tag),
       type_(type),
       bits_(bits),
-      count_(count) {
+      count_(count),
+      scale_(type == DataType::INT8 && count != 1 ? scale : 0) {
   switch (type_) {
 #define DEFAULT(type, enum_type)                                      \
     case DataType::enum_type:                                         \
@@ -55,6 +58,9 @@ FieldMeta::FieldMeta(const std::string& name,
     DEFAULT(float, FLOAT)
     DEFAULT(double, DOUBLE)
 
+    case DataType::FLOAT16:
+      default_ = dflt.isNull() ? 0.0 : to<double>(dflt.asString());
+      break;
     case DataType::STRING:
       default_ = dflt.isNull() ? "" : dflt.asString();
       break;
@@ -66,7 +72,7 @@ FieldMeta::FieldMeta(const std::string& name,
 }
 
 dynamic FieldMeta::toDynamic() const {
-  return dynamic::object
+  dynamic j = dynamic::object
     ("name", name_)
     ("tag", tag_)
     ("type", dataTypeToString(type_))
@@ -74,6 +80,10 @@ dynamic FieldMeta::toDynamic() const {
     ("count", count_)
     ("compact", compact_)
     ("default", default_);
+  if (isQuantized()) {
+    j.insert("scale", scale_);
+  }
+  return j;
 }
 
 std::string FieldMeta::toString() const {
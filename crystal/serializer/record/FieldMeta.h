@@ -33,7 +33,8 @@ class FieldMeta {
             DataType type,
             size_t bits,
             size_t count,
-            const dynamic& dflt = nullptr);
+            const dynamic& dflt = nullptr,
+            float scale = 0);
 
   virtual ~FieldMeta() {}
 
@@ -42,8 +43,10 @@ class FieldMeta {
   DataType type() const;
   size_t bits() const;
   size_t count() const;
+  float scale() const;
 
   bool isCompact() const;
+  bool isQuantized() const;
 
   bool isArray() const;
   bool isFixArray() const;
@@ -66,6 +69,8 @@ class FieldMeta {
   size_t count_;
   bool compact_;
   dynamic default_;
+  // int8 arrays of scale > 0 keep quantized codes of float vectors
+  float scale_;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -90,10 +95,18 @@ inline size_t FieldMeta::count() const {
   return count_;
 }
 
+inline float FieldMeta::scale() const {
+  return scale_;
+}
+
 inline bool FieldMeta::isCompact() const {
   return compact_;
 }
 
+inline bool FieldMeta::isQuantized() const {
+  return scale_ > 0;
+}
+
 inline bool FieldMeta::isArray() const {
   return count_ != 1;
 }
@@ -126,6 +139,12 @@ struct FieldMeta::GetDefaultImpl<
     return to<T>(d.getDouble());
   }
 };
+template <>
+struct FieldMeta::GetDefaultImpl<float16> {
+  static float16 get(const dynamic& d) {
+    return float(d.getDouble());
+  }
+};
 template <class T>
 struct FieldMeta::GetDefaultImpl<
     T, typename std::enable_if<IsString<T>::value>::type> {
@@ -16,8 +16,38 @@
 
 #include "crystal/serializer/record/Record.h"
 
+#include <vector>
+
+#include "crystal/math/Quantize.h"
+
 namespace crystal {
 
+template <>
+dynamic Record::toDynamic<float16>(const FieldMeta& meta) const {
+  if (!meta.isArray()) {
+    return float(get<float16>(meta));
+  }
+  dynamic j = dynamic::array;
+  Array<float16> array = get<Array<float16>>(meta);
+  for (size_t i = 0; i < array.size(); ++i) {
+    j.push_back(float(array.get(i)));
+  }
+  return j;
+}
+
+// quantized codes are printed as the float vector they encode
+static dynamic dequantizeToDynamic(const Record& record,
+                                   const FieldMeta& meta) {
+  Array<int8_t> array = record.get<Array<int8_t>>(meta);
+  std::vector<float> x(array.size());
+  dequantizeInt8(array.data(), array.size(), meta.scale(), x.data());
+  dynamic j = dynamic::array;
+  for (float v : x) {
+    j.push_back(v);
+  }
+  return j;
+}
+
 dynamic Record::toDynamic() const {
   if (!isValid()) {
     return nullptr;
@@ -39,7 +69,6 @@ dynamic Record::toDynamic() const {
     break;
 
       PRINT(bool, BOOL)
-      PRINT(int8_t, INT8)
       PRINT(int16_t, INT16)
       PRINT(int32_t, INT32)
       PRINT(int64_t, INT64)
@@ -49,10 +78,17 @@ dynamic Record::toDynamic() const {
       PRINT(uint64_t, UINT64)
       PRINT(float, FLOAT)
       PRINT(double, DOUBLE)
+      PRINT(float16, FLOAT16)
       PRINT(std::string_view, STRING)
 
 #undef PRINT
 
+      case DataType::INT8:
+        j.insert(meta.name(), meta.isQuantized()
+                 ? dequantizeToDynamic(*this, meta)
+                 : toDynamic<int8_t>(meta));
+        break;
+
       case DataType::UNKNOWN:
         CRYSTAL_THROW(RuntimeError,
                       "unsupport data type: ", dataTypeToString(meta.type()));
@@ -245,4 +245,7 @@ dynamic Record::toDynamic(const FieldMeta& meta) const {
   return j;
 }
 
+template <>
+dynamic Record::toDynamic<float16>(const FieldMeta& meta) const;
+
 }  // namespace crystal
@@ -68,6 +68,14 @@ bool FieldConfig::parse(const dynamic& root) {
       count_ = count.getInt();
     }
     default_ = root.getDefault("default", nullptr);
+    float scale = root.getDefault("scale", 0).asDouble();
+    if (scale > 0) {
+      if (type_ != DataType::INT8 || count_ == 1) {
+        CRYSTAL_LOG(ERROR) << "scale needs int8 array: " << toCson(root);
+        return false;
+      }
+      scale_ = scale;
+    }
   }
   return true;
 }
@@ -92,6 +100,10 @@ size_t FieldConfig::count() const {
   return count_;
 }
 
+float FieldConfig::scale() const {
+  return scale_;
+}
+
 const dynamic& FieldConfig::dflt() const {
   return default_;
 }
@@ -105,7 +117,7 @@ bool FieldConfig::isRelated() const {
 }
 
 FieldMeta FieldConfig::toFieldMeta() const {
-  return FieldMeta(name_, tag_, type_, bits_, count_, default_);
+  return FieldMeta(name_, tag_, type_, bits_, count_, default_, scale_);
 }
 
 dynamic FieldConfig::toDynamic() const {
@@ -118,6 +130,9 @@ dynamic FieldConfig::toDynamic() const {
   if (!default_.isNull()) {
     j.insert("default", default_);
   }
+  if (scale_ > 0) {
+    j.insert("scale", scale_);
+  }
   if (!related_.empty()) {
     j.insert("type", "related");
     j.insert("table", related_);
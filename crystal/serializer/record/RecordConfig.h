@@ -37,6 +37,7 @@ class FieldConfig {
   DataType type() const;
   size_t bits() const;
   size_t count() const;
+  float scale() const;
   const dynamic& dflt() const;
   const std::string& related() const;
 
@@ -52,6 +53,7 @@ class FieldConfig {
   DataType type_{DataType::UNKNOWN};
   size_t bits_{0};
   size_t count_{1};
+  float scale_{0};
   dynamic default_;
   std::string related_;
 };
@@ -161,3 +161,111 @@ TEST(Accessor, all) {
       R"(,bufferSize=200})",
       accessor.toString().c_str());
 }
+
+TEST(Accessor, packed) {
+  RecordMeta meta;
+
+  meta.addMeta(FieldMeta("field1", 1, DataType::BOOL, 1, 1));
+  meta.addMeta(FieldMeta("field2", 2, DataType::INT8, 8, 1, "50"));
+  meta.addMeta(FieldMeta("field3", 3, DataType::INT8, 4, 1));
+  meta.addMeta(FieldMeta("field4", 4, DataType::FLOAT, 32, 1));
+  meta.addMeta(FieldMeta("field5", 5, DataType::STRING, 0, 1, "default"));
+  meta.addMeta(FieldMeta("field6", 6, DataType::INT64, 64, 1, "7"));
+
+  Accessor accessor(meta);
+  Accessor packed(meta, true);
+
+  EXPECT_TRUE(packed.packed());
+  EXPECT_EQ(accessor.bufferSize(), packed.fixedSize());
+
+  SysAllocator allocator;
+  void* buf = allocator.address(allocator.allocate(accessor.bufferSize()));
+  memset(buf, 0, accessor.bufferSize());
+  accessor.reset(buf, &allocator, meta);
+
+  // defaults only: the bitmaps and no byte field
+  size_t emptySize = packed.packedSize(buf);
+  EXPECT_GT(packed.bufferSize(), emptySize);
+  EXPECT_EQ(50, packed.get<int8_t>(
+          packed.defaultBuffer(), &allocator, *meta.getMeta(2)));
+  EXPECT_EQ(7, packed.get<int64_t>(
+          packed.defaultBuffer(), &allocator, *meta.getMeta(6)));
+
+  EXPECT_TRUE(accessor.set<bool>(buf, &allocator, *meta.getMeta(1), true));
+  EXPECT_TRUE(accessor.set<int8_t>(buf, &allocator, *meta.getMeta(3), 5));
+  EXPECT_TRUE(accessor.set<float>(buf, &allocator, *meta.getMeta(4), 1.23));
+  EXPECT_TRUE(accessor.set<std::string_view>(buf, &allocator, *meta.getMeta(5),
+                                             "string"));
+  // two offsets of the table, padded to 8 bytes
+  EXPECT_EQ(emptySize + 2 * sizeof(uint32_t) + sizeof(float) + sizeof(int64_t),
+            packed.packedSize(buf));
+
+  std::string pbuf(packed.packedSize(buf), '\0');
+  packed.pack(buf, &pbuf[0]);
+
+  EXPECT_EQ(true, packed.get<bool>(pbuf.data(), &allocator, *meta.getMeta(1)));
+  EXPECT_EQ(50, packed.get<int8_t>(pbuf.data(), &allocator, *meta.getMeta(2)));
+  EXPECT_EQ(5, packed.get<int8_t>(pbuf.data(), &allocator, *meta.getMeta(3)));
+  EXPECT_FLOAT_EQ(1.23, packed.get<float>(
+          pbuf.data(), &allocator, *meta.getMeta(4)));
+  EXPECT_STREQ("string", std::string(packed.get<std::string_view>(
+          pbuf.data(), &allocator, *meta.getMeta(5))).c_str());
+  EXPECT_EQ(7, packed.get<int64_t>(pbuf.data(), &allocator, *meta.getMeta(6)));
+  EXPECT_FALSE(packed.hasField(pbuf.data(), *meta.getMeta(2)));
+  EXPECT_TRUE(packed.hasField(pbuf.data(), *meta.getMeta(4)));
+
+  // written in the fixed layout only
+  EXPECT_FALSE(packed.set<int8_t>(
+          &pbuf[0], &allocator, *meta.getMeta(2), 1));
+
+  std::string fbuf(packed.fixedSize(), '\0');
+  packed.unpack(pbuf.data(), &fbuf[0]);
+  EXPECT_EQ(0, memcmp(buf, fbuf.data(), accessor.bufferSize()));
+}
+
+TEST(Accessor, packedWide) {
+  RecordMeta meta;
+  // byte fields of odd sizes across several has words
+  for (int tag = 1; tag <= 200; ++tag) {
+    if (tag % 3 == 0) {
+      meta.addMeta(FieldMeta("i16_" + std::to_string(tag), tag,
+                             DataType::INT16, 16, 1));
+    } else {
+      meta.addMeta(FieldMeta("i64_" + std::to_string(tag), tag,
+                             DataType::INT64, 64, 1, "-1"));
+    }
+  }
+
+  Accessor accessor(meta);
+  Accessor packed(meta, true);
+
+  SysAllocator allocator;
+  void* buf = allocator.address(allocator.allocate(accessor.bufferSize()));
+  memset(buf, 0, accessor.bufferSize());
+  accessor.reset(buf, &allocator, meta);
+  for (int tag = 1; tag <= 200; tag += 2) {
+    if (tag % 3 == 0) {
+      EXPECT_TRUE(accessor.set<int16_t>(buf, &allocator, *meta.getMeta(tag),
+                                        tag));
+    } else {
+      EXPECT_TRUE(accessor.set<int64_t>(buf, &allocator, *meta.getMeta(tag),
+                                        tag * 1000));
+    }
+  }
+
+  std::string pbuf(packed.packedSize(buf), '\0');
+  packed.pack(buf, &pbuf[0]);
+  for (int tag = 1; tag <= 200; ++tag) {
+    if (tag % 3 == 0) {
+      EXPECT_EQ(tag % 2 ? tag : 0, packed.get<int16_t>(
+              pbuf.data(), &allocator, *meta.getMeta(tag)));
+    } else {
+      EXPECT_EQ(tag % 2 ? tag * 1000 : -1, packed.get<int64_t>(
+              pbuf.data(), &allocator, *meta.getMeta(tag)));
+    }
+  }
+
+  std::string fbuf(packed.fixedSize(), '\0');
+  packed.unpack(pbuf.data(), &fbuf[0]);
+  EXPECT_EQ(0, memcmp(buf, fbuf.data(), accessor.bufferSize()));
+}
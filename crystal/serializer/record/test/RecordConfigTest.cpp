@@ -84,3 +84,19 @@ TEST(FieldConfig, related) {
       R"({bits=64,count=1,name="chefId",table="chef",tag=4,type="related"})",
       config.toString().c_str());
 }
+
+TEST(FieldConfig, scale) {
+  FieldConfig config;
+  config.parse(parseCson(R"({ tag=5, name="embedding", type="int8", count=4, scale=0.5 })"));
+
+  EXPECT_EQ(DataType::INT8, config.type());
+  EXPECT_EQ(4, config.count());
+  EXPECT_EQ(0.5, config.scale());
+  EXPECT_TRUE(config.toFieldMeta().isQuantized());
+
+  EXPECT_STREQ(
+      R"({bits=8,count=4,name="embedding",scale=0.5,tag=5,type="INT8"})",
+      config.toString().c_str());
+
+  EXPECT_FALSE(config.parse(parseCson(R"({ tag=5, name="embedding", type="float", count=4, scale=0.5 })")));
+}
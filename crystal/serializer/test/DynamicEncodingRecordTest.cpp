@@ -14,8 +14,12 @@
  * limitations under the License.
  */
 
+#include <cmath>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "crystal/math/Quantize.h"
 #include "crystal/memory/SysAllocator.h"
 #include "crystal/serializer/DynamicEncoding.h"
 #include "crystal/serializer/record/RecordConfig.h"
@@ -89,3 +93,77 @@ TEST(DynamicEncoding, record) {
   EXPECT_STREQ("b", std::string(b.get(1)).c_str());
   EXPECT_STREQ("c", std::string(b.get(2)).c_str());
 }
+
+TEST(DynamicEncoding, quantized) {
+  const char* conf = R"(
+      {
+        record=[
+          { tag=1, name="half", type="float16", count=4 },
+          { tag=2, name="code", type="int8", count=0, scale=0.5 }
+        ]
+      }
+      )";
+  const char* cson = R"(
+      {
+        half=[0.5,-2.0,1000.0,0.1],
+        code=[1.0,-0.74,100.0,-0.25]
+      }
+      )";
+
+  RecordMeta meta = buildRecordMeta(parseRecordConfig(parseCson(conf)));
+
+  Accessor accessor(meta);
+  SysAllocator allocator;
+  void* buf = allocator.address(allocator.allocate(accessor.bufferSize()));
+  memset(buf, 0, accessor.bufferSize());
+
+  Record record;
+  record.init(&meta, &accessor, &allocator, buf);
+
+  record.reset();
+  decode(parseCson(cson), record);
+
+  Array<float16> a = record.get<Array<float16>>(*meta.getMeta(1));
+  EXPECT_EQ(4, a.size());
+  EXPECT_EQ(0.5, a.get(0));
+  EXPECT_EQ(-2.0, a.get(1));
+  EXPECT_EQ(1000.0, a.get(2));
+  EXPECT_NEAR(0.1, a.get(3), 1e-4);
+
+  // codes of round(x / 0.5) in [-127, 127]
+  Array<int8_t> b = record.get<Array<int8_t>>(*meta.getMeta(2));
+  EXPECT_EQ(4, b.size());
+  EXPECT_EQ(2, b.get(0));
+  EXPECT_EQ(-1, b.get(1));
+  EXPECT_EQ(127, b.get(2));
+  EXPECT_EQ(0, b.get(3));
+
+  dynamic j = record.toDynamic();
+  EXPECT_EQ(dynamic::array(1.0, -0.5, 63.5, 0.0), j["code"]);
+  EXPECT_EQ(0.5, j["half"][0].asDouble());
+}
+
+// batches clamp out of range and NaN values as single codes do
+TEST(DynamicEncoding, quantizeInt8) {
+  std::vector<float> x(35);
+  for (size_t i = 0; i < x.size(); ++i) {
+    x[i] = (float(i) - 17) * 10;
+  }
+  x[3] = 1e20;
+  x[5] = -1e20;
+  x[7] = INFINITY;
+  x[9] = -INFINITY;
+  x[11] = NAN;
+  std::vector<int8_t> codes(x.size());
+  quantizeInt8(x.data(), x.size(), 1, codes.data());
+  for (size_t i = 0; i < x.size(); ++i) {
+    EXPECT_EQ(quantizeInt8(x[i], 1), codes[i]) << i;
+  }
+  EXPECT_EQ(127, codes[3]);
+  EXPECT_EQ(-127, codes[5]);
+  EXPECT_EQ(127, codes[7]);
+  EXPECT_EQ(-127, codes[9]);
+  EXPECT_EQ(0, codes[11]);
+  EXPECT_EQ(-127, codes[0]);
+  EXPECT_EQ(100, codes[27]);
+}
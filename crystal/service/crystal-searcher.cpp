@@ -65,6 +65,14 @@ int main(int argc, char** argv) {
         Query query(&factory, &executor, FLAGS_use_cson);
 
         std::string queryStr = request->content.string();
+        // binary attachments follow the query, e.g. query vectors
+        auto it = request->header.find("Crystal-Attachments");
+        if (it != request->header.end() &&
+            !query.attachFrom(queryStr, it->second)) {
+          response->write(StatusCode::client_error_bad_request,
+                          "invalid attachments");
+          return;
+        }
         std::string_view sv(queryStr);
         sv = trimWhitespace(sv);
         query += std::string(sv);
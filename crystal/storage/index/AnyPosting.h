@@ -18,12 +18,14 @@
 
 #include "crystal/storage/index/Variant.h"
 #include "crystal/storage/index/bitmap/BitmapPosting.h"
+#include "crystal/storage/index/scored/ScoredPosting.h"
 #include "crystal/storage/index/vector/VectorPosting.h"
 
 namespace crystal {
 
 typedef std::variant<
   BitmapPosting,
+  ScoredPosting,
   VectorPosting,
   std::monostate> AnyPosting;
 
@@ -18,12 +18,16 @@
 
 #include "crystal/storage/index/Variant.h"
 #include "crystal/storage/index/bitmap/BitmapPostingList.h"
+#include "crystal/storage/index/bitmap/RoaringPostingList.h"
+#include "crystal/storage/index/scored/ScoredPostingList.h"
 #include "crystal/storage/index/vector/VectorPostingList.h"
 
 namespace crystal {
 
 typedef std::variant<
   BitmapPostingList,
+  RoaringPostingList,
+  ScoredPostingList,
   VectorPostingList,
   std::monostate> AnyPostingList;
 
@@ -18,12 +18,16 @@
 
 #include "crystal/storage/index/Variant.h"
 #include "crystal/storage/index/bitmap/BitmapPostingListIterator.h"
+#include "crystal/storage/index/bitmap/RoaringPostingListIterator.h"
+#include "crystal/storage/index/scored/ScoredPostingListIterator.h"
 #include "crystal/storage/index/vector/VectorPostingListIterator.h"
 
 namespace crystal {
 
 typedef std::variant<
   BitmapPostingListIterator,
+  RoaringPostingListIterator,
+  ScoredPostingListIterator,
   VectorPostingListIterator,
   std::monostate> AnyPostingListIterator;
 
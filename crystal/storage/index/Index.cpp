@@ -18,6 +18,9 @@
 
 #include "crystal/storage/index/IndexType.h"
 #include "crystal/storage/index/bitmap/BitmapIndex.h"
+#include "crystal/storage/index/bitmap/RoaringIndex.h"
+#include "crystal/storage/index/scored/ScoredIndex.h"
+#include "crystal/storage/index/vector/VectorIndex.h"
 
 namespace crystal {
 
@@ -31,6 +34,16 @@ bool Index::init(MemoryManager* memory) {
     case IndexType::kBitmap:
       index_ = std::unique_ptr<IndexBase>(new BitmapIndex(config_));
       break;
+    case IndexType::kRoaring:
+      index_ = std::unique_ptr<IndexBase>(new RoaringIndex(config_));
+      break;
+    case IndexType::kScored:
+      index_ = std::unique_ptr<IndexBase>(new ScoredIndex(config_));
+      break;
+    case IndexType::kFaiss:
+    case IndexType::kFlat:
+      index_ = std::unique_ptr<IndexBase>(new VectorIndex(config_));
+      break;
     default:
       CRYSTAL_LOG(ERROR) << "unsupport index type: " << config_->type();
       return false;
@@ -42,6 +42,8 @@ class Index {
   bool remove(uint64_t key, const Record& record);
   bool bulkLoad(uint64_t key, const std::vector<Record>& records);
 
+  void sync();
+
  private:
   const IndexConfig* config_{nullptr};
   std::unique_ptr<IndexBase> index_;
@@ -85,4 +87,8 @@ inline bool Index::bulkLoad(uint64_t key, const std::vector<Record>& records) {
   return index_->bulkLoad(key, records);
 }
 
+inline void Index::sync() {
+  index_->sync();
+}
+
 }  // namespace crystal
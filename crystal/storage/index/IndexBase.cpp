@@ -119,7 +119,7 @@ bool IndexBase::remove(uint64_t key, const Record& record) {
     CRYSTAL_LOG_INDEX(ERROR) << "parse from record failed";
     return false;
   }
-  if (!get(postingList)->remove(get(posting)->id)) {
+  if (get(postingList)->remove(get(posting)->id) != 0) {
     CRYSTAL_LOG_INDEX(ERROR) << "remove posting failed";
     return false;
   }
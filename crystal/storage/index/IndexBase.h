@@ -16,6 +16,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "crystal/memory/MemoryManager.h"
 #include "crystal/memory/RecycledAllocator.h"
 #include "crystal/serializer/record/Record.h"
@@ -41,6 +43,9 @@ class IndexBase {
   virtual bool remove(uint64_t key, const Record& record);
   virtual bool bulkLoad(uint64_t key, const std::vector<Record>& records);
 
+  // wait for background work on the index, before dump
+  virtual void sync() {}
+
   const IndexConfig* config() const;
   const RecordMeta& recordMeta() const;
   const FieldMeta& keyMeta() const;
@@ -51,6 +56,11 @@ class IndexBase {
 
   Record createRecord(void* buf = nullptr) const;
 
+  // version of the posting list of key, bumped on every change of it,
+  // posting ids cached at an older version are stale
+  uint32_t version(uint64_t key) const;
+  void touch(uint64_t key);
+
  protected:
   const IndexConfig* config_{nullptr};
   RecordMeta recordMeta_;
@@ -58,6 +68,9 @@ class IndexBase {
   Accessor accessor_;
   PostingAllocator alloc_;
   mutable RecycledAllocator recycledAlloc_;
+  // versions are striped by key, a collision only costs a cache miss
+  static constexpr size_t kVersionStripes = 1024;
+  std::atomic<uint32_t> versions_[kVersionStripes] = {};
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -90,4 +103,12 @@ inline Record IndexBase::createRecord(void* buf) const {
   return Record(&recordMeta_, &accessor_, &recycledAlloc_, buf);
 }
 
+inline uint32_t IndexBase::version(uint64_t key) const {
+  return versions_[key % kVersionStripes].load(std::memory_order_acquire);
+}
+
+inline void IndexBase::touch(uint64_t key) {
+  versions_[key % kVersionStripes].fetch_add(1, std::memory_order_release);
+}
+
 }  // namespace crystal
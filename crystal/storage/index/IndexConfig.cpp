@@ -21,20 +21,33 @@
 namespace crystal {
 
 bool IndexConfig::parse(const dynamic& root, const RecordConfig& recordConfig) {
-  if (!KVConfig::parse(root, recordConfig, "payload", true)) {
-    return false;
-  }
   auto type = root.getDefault("type");
   if (type.empty()) {
     CRYSTAL_LOG(ERROR) << "miss type: " << toCson(root);
     return false;
   }
   type_ = type.getString();
-  if (strcasecmp(type_.substr(0, 5).c_str(), "Faiss") == 0) {
-    vectorMeta_.type = VectorType::Faiss;
-    if (type_.size() > 5) {
-      vectorMeta_.desc = type_.substr(strlen("Faiss:"));
-      type_ = "Faiss";
+  if (!KVConfig::parse(root, recordConfig, "payload", true)) {
+    return false;
+  }
+  if (strcasecmp(type_.c_str(), "Scored") == 0) {
+    score_ = root.getDefault("score", "").getString();
+    auto it = recordConfig.find(score_);
+    if (it == recordConfig.end() ||
+        !isArithmetic(it->second.type())) {
+      CRYSTAL_LOG(ERROR) << "miss or invalid score: " << toCson(root);
+      return false;
+    }
+  }
+  if (isVector()) {
+    if (strcasecmp(type_.c_str(), "Flat") == 0) {
+      vectorMeta_.type = VectorType::Flat;
+    } else {
+      vectorMeta_.type = VectorType::Faiss;
+      if (type_.size() > 5) {
+        vectorMeta_.desc = type_.substr(strlen("Faiss:"));
+        type_ = "Faiss";
+      }
     }
     auto dimension = root.getDefault("dimension", -1);
     if (dimension.getInt() < 0) {
@@ -47,19 +60,46 @@ bool IndexConfig::parse(const dynamic& root, const RecordConfig& recordConfig) {
       CRYSTAL_LOG(ERROR) << "miss metric: " << toCson(root);
       return false;
     }
-    vectorMeta_.metric = stringToFaissMetric(metric.asString().c_str());
+    vectorMeta_.metric = stringToVectorMetric(metric.asString().c_str());
+    if (vectorMeta_.metric == -1 ||
+        (vectorMeta_.type == VectorType::Faiss &&
+         vectorMeta_.metric == kMetricCosine)) {
+      CRYSTAL_LOG(ERROR) << "invalid metric: " << toCson(root);
+      return false;
+    }
     vectorMeta_.trainSize = root.getDefault("trainSize",
                                             vectorMeta_.trainSize).getInt();
     vectorMeta_.batchSize = root.getDefault("batchSize",
                                             vectorMeta_.batchSize).getInt();
+    if (strategy() != StrategyType::kId) {
+      CRYSTAL_LOG(ERROR) << "vector index needs id strategy: " << toCson(root);
+      return false;
+    }
   }
   return true;
 }
 
+bool IndexConfig::supportKeyType(DataType type) const {
+  if (isVector()) {
+    // int8 keys are quantized vectors
+    return isFloat(type) || type == DataType::INT8;
+  }
+  return KVConfig::supportKeyType(type);
+}
+
 const std::string& IndexConfig::type() const {
   return type_;
 }
 
+const std::string& IndexConfig::score() const {
+  return score_;
+}
+
+bool IndexConfig::isVector() const {
+  return strcasecmp(type_.substr(0, 5).c_str(), "Faiss") == 0 ||
+         strcasecmp(type_.c_str(), "Flat") == 0;
+}
+
 const VectorMeta& IndexConfig::vectorMeta() const {
   return vectorMeta_;
 }
@@ -31,10 +31,18 @@ class IndexConfig : public KVConfig {
   bool parse(const dynamic& root, const RecordConfig& recordConfig) override;
 
   const std::string& type() const;
+  const std::string& score() const;
+  // Faiss or Flat, keyed by float array
+  bool isVector() const;
   const VectorMeta& vectorMeta() const;
 
+ protected:
+  // vector index is keyed by float array
+  bool supportKeyType(DataType type) const override;
+
  private:
   std::string type_;
+  std::string score_;
   VectorMeta vectorMeta_;
 };
 
@@ -21,7 +21,10 @@ namespace crystal {
 #define CRYSTAL_INDEX_TYPE_GEN(x) \
   x(None),                        \
   x(Bitmap),                      \
-  x(Faiss)
+  x(Roaring),                     \
+  x(Scored),                      \
+  x(Faiss),                       \
+  x(Flat)
 
 #define CRYSTAL_INDEX_TYPE_ENUM(type) k##type
 
@@ -52,7 +52,7 @@ class PostingAllocator : public Allocator {
   };
 
   RecycledAllocator alloc_;
-  Posting* posting_;
+  Posting* posting_{nullptr};
   MemNode* head_{nullptr};
   MemNode* tail_{nullptr};
 };
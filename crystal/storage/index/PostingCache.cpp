@@ -0,0 +1,143 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/PostingCache.h"
+
+#include <algorithm>
+
+#include "crystal/foundation/Logging.h"
+#include "crystal/storage/index/IndexBase.h"
+
+namespace crystal {
+
+PostingCache::PostingCache(size_t capacity, size_t minSize)
+    : slotsPerShard_(std::max((capacity + kShards - 1) / kShards, size_t(1))),
+      minSize_(minSize) {
+  for (auto& shard : shards_) {
+    shard.slots.reset(new std::atomic<PostingIds*>[slotsPerShard_]);
+    for (size_t i = 0; i < slotsPerShard_; ++i) {
+      shard.slots[i].store(nullptr, std::memory_order_relaxed);
+    }
+  }
+}
+
+PostingCache::~PostingCache() {
+  for (auto& shard : shards_) {
+    for (size_t i = 0; i < slotsPerShard_; ++i) {
+      delete shard.slots[i].load(std::memory_order_relaxed);
+    }
+    for (auto& r : shard.retired) {
+      delete r.entry;
+    }
+  }
+}
+
+std::atomic<PostingIds*>&
+PostingCache::slot(size_t indexNo, uint64_t token, Shard*& shard) {
+  uint64_t h = (token ^ (uint64_t(indexNo) << 56)) * 0x9e3779b97f4a7c15ull;
+  shard = &shards_[h >> 60];
+  return shard->slots[(h >> 16) % slotsPerShard_];
+}
+
+bool PostingCache::valid(const PostingIds* entry) {
+  return entry->version == entry->index->version(entry->token);
+}
+
+const PostingIds* PostingCache::get(size_t indexNo, uint64_t token) {
+  Shard* shard;
+  PostingIds* entry = slot(indexNo, token, shard)
+      .load(std::memory_order_acquire);
+  if (entry && entry->indexNo == indexNo && entry->token == token &&
+      valid(entry)) {
+    if (entry->hits.load(std::memory_order_relaxed) < kMaxHits) {
+      entry->hits.fetch_add(1, std::memory_order_relaxed);
+    }
+    report(shard->hits.fetch_add(1, std::memory_order_relaxed) + 1);
+    return entry;
+  }
+  report(shard->misses.fetch_add(1, std::memory_order_relaxed) + 1);
+  return nullptr;
+}
+
+void PostingCache::report(uint64_t n) const {
+  if (n % kReportInterval == 0) {
+    uint64_t h = hits();
+    uint64_t m = misses();
+    CRYSTAL_LOG(INFO) << "posting cache hits=" << h << " misses=" << m
+        << " hit rate=" << (h + m ? double(h) / (h + m) : 0);
+  }
+}
+
+const PostingIds* PostingCache::put(
+    size_t indexNo,
+    uint64_t token,
+    IndexBase* index,
+    std::function<void(std::vector<uint64_t>&)> decode) {
+  Shard* shard;
+  auto& s = slot(indexNo, token, shard);
+  std::lock_guard<std::mutex> guard(shard->lock);
+  PostingIds* old = s.load(std::memory_order_relaxed);
+  if (old && valid(old)) {
+    if (old->indexNo == indexNo && old->token == token) {
+      return old;
+    }
+    // age the hot entry, take over the slot once it gets cold
+    uint32_t hits = old->hits.load(std::memory_order_relaxed);
+    if (hits > 0) {
+      old->hits.store(hits / 2, std::memory_order_relaxed);
+      return nullptr;
+    }
+  }
+  // version is read before decoding, a concurrent change makes the
+  // entry stale rather than wrong
+  auto entry = std::make_unique<PostingIds>();
+  entry->indexNo = indexNo;
+  entry->token = token;
+  entry->index = index;
+  entry->version = index->version(token);
+  decode(entry->ids);
+  s.store(entry.get(), std::memory_order_release);
+
+  time_t now = time(nullptr);
+  size_t n = 0;
+  for (; n < shard->retired.size() &&
+       shard->retired[n].tm + kDelaySecond <= now; ++n) {
+    delete shard->retired[n].entry;
+  }
+  shard->retired.erase(shard->retired.begin(), shard->retired.begin() + n);
+  if (old) {
+    shard->retired.push_back({now, old});
+  }
+  return entry.release();
+}
+
+uint64_t PostingCache::hits() const {
+  uint64_t n = 0;
+  for (auto& shard : shards_) {
+    n += shard.hits.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+uint64_t PostingCache::misses() const {
+  uint64_t n = 0;
+  for (auto& shard : shards_) {
+    n += shard.misses.load(std::memory_order_relaxed);
+  }
+  return n;
+}
+
+}  // namespace crystal
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace crystal {
+
+class IndexBase;
+
+struct PostingIds {
+  size_t indexNo;
+  uint64_t token;
+  IndexBase* index;         // owner of the posting list
+  uint32_t version;         // posting list version when decoded
+  std::vector<uint64_t> ids;
+  mutable std::atomic<uint32_t> hits{0};
+};
+
+/*
+ * Bounded cache of decoded posting ids for hot tokens, keyed by
+ * (index no, token) and validated by the version of the token's posting
+ * list, so updates of other tokens keep the entry.
+ *
+ * Slots are direct-mapped and split into shards. Lookups are lock-free:
+ * a slot is one atomic pointer to an immutable entry, replaced entries
+ * are freed after kDelaySecond as done for postings. Inserts take the
+ * shard lock, a slot is only taken over after misses of other tokens
+ * have aged out the hits of its entry. Hit and miss counters are logged
+ * every kReportInterval hits or misses of a shard.
+ */
+class PostingCache {
+ public:
+  static constexpr size_t kShards = 16;
+  static constexpr size_t kDefaultCapacity = 1024;
+  static constexpr size_t kDefaultMinSize = 256;
+  static constexpr uint64_t kReportInterval = 1 << 16;
+
+  explicit PostingCache(size_t capacity = kDefaultCapacity,
+                        size_t minSize = kDefaultMinSize);
+  ~PostingCache();
+
+  PostingCache(const PostingCache&) = delete;
+  PostingCache& operator=(const PostingCache&) = delete;
+
+  // nullptr on miss or stale
+  const PostingIds* get(size_t indexNo, uint64_t token);
+
+  // decode is called only if the token is admitted, nullptr if not
+  const PostingIds* put(size_t indexNo,
+                        uint64_t token,
+                        IndexBase* index,
+                        std::function<void(std::vector<uint64_t>&)> decode);
+
+  // posting lists smaller than this are cheap to walk, not cached
+  size_t minSize() const;
+
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+ private:
+  static constexpr int kDelaySecond = 3;
+  // cap of entry hits, keeps hot entries from being written on every hit
+  static constexpr uint32_t kMaxHits = 64;
+
+  struct Retired {
+    time_t tm;
+    PostingIds* entry;
+  };
+
+  struct Shard {
+    std::mutex lock;
+    std::unique_ptr<std::atomic<PostingIds*>[]> slots;
+    std::vector<Retired> retired;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+  };
+
+  std::atomic<PostingIds*>& slot(size_t indexNo, uint64_t token, Shard*& shard);
+
+  static bool valid(const PostingIds* entry);
+
+  void report(uint64_t n) const;
+
+  size_t slotsPerShard_;
+  size_t minSize_;
+  Shard shards_[kShards];
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline size_t PostingCache::minSize() const {
+  return minSize_;
+}
+
+}  // namespace crystal
@@ -51,6 +51,7 @@ void BitmapIndex::updatePostingList(uint64_t key, void* meta) {
   if (it != hashMap_.cend()) {
     it->second.data = *reinterpret_cast<BitmapPostingList::Meta*>(meta);
   }
+  touch(key);
 }
 
 }  // namespace crystal
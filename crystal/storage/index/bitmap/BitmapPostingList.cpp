@@ -22,23 +22,35 @@
 namespace crystal {
 
 constexpr uint64_t kDefaultMaxId = 1 << 20;
+constexpr uint64_t kSummaryMagic = 0x5355'4d4d'4152'5931;   // "SUMMARY1"
+
+static_assert(sizeof(BitmapPostingList::Meta) == 24,
+              "BitmapPostingList::Meta is persisted");
 
 bool BitmapPostingList::expand(uint64_t maxId) {
   if (maxId < kDefaultMaxId) {
     maxId = kDefaultMaxId;
   }
   uint64_t n = div64(maxId);
-  int64_t offset = index_->allocator().allocate(n * sizeof(uint64_t));
+  uint64_t m = div64(n);
+  auto& alloc = index_->allocator();
+  int64_t offset = alloc.allocate((n + m + 1) * sizeof(uint64_t));
   if (offset == 0) {
     CRYSTAL_LOG(ERROR) << "allocate failed";
     return false;
   }
-  void* dst = index_->allocator().address(offset);
-  memset(dst, 0, n * sizeof(uint64_t));
+  auto* dst = reinterpret_cast<uint64_t*>(alloc.address(offset));
+  uint64_t* sum = dst + n;
+  memset(dst, 0, (n + m) * sizeof(uint64_t));
+  dst[n + m] = kSummaryMagic;
   if (meta_.offset != 0) {
-    void* src = index_->allocator().address(meta_.offset);
-    memcpy(dst, src, meta_.maxId / 8);
-    index_->allocator().deallocate(meta_.offset);
+    memcpy(dst, words(), meta_.maxId / 8);
+    alloc.deallocate(meta_.offset);
+    for (uint64_t i = 0; i < meta_.maxId / 64; ++i) {
+      if (dst[i] != 0) {
+        sum[i / 64] |= uint64_t(1) << (i % 64);
+      }
+    }
   }
   meta_.offset = offset;
   meta_.maxId = n * 64;
@@ -46,9 +58,31 @@ bool BitmapPostingList::expand(uint64_t maxId) {
   return true;
 }
 
-bool BitmapPostingList::isSet(uint64_t id) const {
-  auto* addr = reinterpret_cast<uint64_t*>(
+uint64_t* BitmapPostingList::words() const {
+  if (meta_.offset == 0) {
+    return nullptr;
+  }
+  return reinterpret_cast<uint64_t*>(
       index_->allocator().address(meta_.offset));
+}
+
+uint64_t* BitmapPostingList::summary() const {
+  uint64_t* addr = words();
+  if (addr == nullptr) {
+    return nullptr;
+  }
+  uint64_t n = meta_.maxId / 64;
+  uint64_t m = div64(n);
+  if (index_->allocator().getSize(meta_.offset) <
+          (n + m + 1) * sizeof(uint64_t) ||
+      addr[n + m] != kSummaryMagic) {
+    return nullptr;
+  }
+  return addr + n;
+}
+
+bool BitmapPostingList::isSet(uint64_t id) const {
+  uint64_t* addr = words();
   if (addr == nullptr) {
     CRYSTAL_LOG(ERROR) << "get address failed";
     return false;
@@ -57,23 +91,31 @@ bool BitmapPostingList::isSet(uint64_t id) const {
 }
 
 void BitmapPostingList::set(uint64_t id) {
-  auto* addr = reinterpret_cast<uint64_t*>(
-      index_->allocator().address(meta_.offset));
+  uint64_t* addr = words();
   if (addr == nullptr) {
     CRYSTAL_LOG(ERROR) << "get address failed";
     return;
   }
-  addr[id / 64] |= uint64_t(1) << (id % 64);
+  uint64_t i = id / 64;
+  addr[i] |= uint64_t(1) << (id % 64);
+  uint64_t* sum = summary();
+  if (sum) {
+    sum[i / 64] |= uint64_t(1) << (i % 64);
+  }
 }
 
 void BitmapPostingList::unset(uint64_t id) {
-  auto* addr = reinterpret_cast<uint64_t*>(
-      index_->allocator().address(meta_.offset));
+  uint64_t* addr = words();
   if (addr == nullptr) {
     CRYSTAL_LOG(ERROR) << "get address failed";
     return;
   }
-  addr[id / 64] &= ~(uint64_t(1) << (id % 64));
+  uint64_t i = id / 64;
+  addr[i] &= ~(uint64_t(1) << (id % 64));
+  uint64_t* sum = summary();
+  if (sum && addr[i] == 0) {
+    sum[i / 64] &= ~(uint64_t(1) << (i % 64));
+  }
 }
 
 AnyPostingListIterator BitmapPostingList::iterator() {
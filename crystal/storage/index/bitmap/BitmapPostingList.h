@@ -23,6 +23,11 @@ namespace crystal {
 
 class BitmapPostingList : public PostingList {
  public:
+  /*
+   * Stored by value in the index files. The words at offset are followed
+   * by a summary of one bit per non-zero word and kSummaryMagic, absent
+   * from lists written before it.
+   */
   struct Meta {
     size_t size{0};
     int64_t offset{0};
@@ -51,11 +56,18 @@ class BitmapPostingList : public PostingList {
   int remove(uint64_t id) override;
   int bulkLoad(std::vector<AnyPosting>& postings) override;
 
+  // raw bitmap words for set algebra, nullptr if empty
+  uint64_t* words() const;
+  size_t wordCount() const;
+
  private:
   friend class BitmapPostingListIterator;
 
   bool expand(uint64_t maxId);
 
+  // nullptr if absent
+  uint64_t* summary() const;
+
   bool isSet(uint64_t id) const;
   void set(uint64_t id);
   void unset(uint64_t id);
@@ -83,6 +95,10 @@ inline size_t BitmapPostingList::size() const {
   return meta_.size;
 }
 
+inline size_t BitmapPostingList::wordCount() const {
+  return meta_.maxId / 64;
+}
+
 inline bool BitmapPostingList::exist(uint64_t id) const {
   if (id >= meta_.maxId) {
     return false;
@@ -16,149 +16,138 @@
 
 #include "crystal/storage/index/bitmap/BitmapPostingListIterator.h"
 
+#include "crystal/math/Div.h"
+
 #include "crystal/storage/index/IndexBase.h"
 #include "crystal/storage/index/bitmap/BitmapPostingList.h"
 
 namespace crystal {
 
-void BitmapPostingListIterator::seekFirst() {
-  auto* addr = reinterpret_cast<uint64_t*>(
-      postingList_->index_->allocator().address(postingList_->meta_.offset));
-  if (addr == nullptr) {
-    return;
-  }
-  uint64_t n = postingList_->meta_.maxId / 64;
-  i = 0;
-  while (*addr == 0 && i < n) {
-    ++addr;
-    ++i;
-  }
-  if (i < n) {
-    j = 0;
-    while (j < 64) {
-      if (*addr & (uint64_t(1) << j)) {
-        break;
+void BitmapPostingListIterator::load() {
+  words_ = postingList_->words();
+  summary_ = postingList_->summary();
+  n_ = words_ ? postingList_->meta_.maxId / 64 : 0;
+}
+
+uint64_t BitmapPostingListIterator::nextWord(uint64_t w) const {
+  if (w >= n_) {
+    return n_;
+  }
+  if (summary_) {
+    uint64_t k = w / 64;
+    uint64_t m = div64(n_);
+    uint64_t bits = summary_[k] & (~uint64_t(0) << (w % 64));
+    while (bits == 0) {
+      if (++k == m) {
+        return n_;
       }
-      ++j;
-    }
-    if (j < 64) {
-      curPosting_.id = i * 64 + j;
+      bits = summary_[k];
     }
+    return k * 64 + __builtin_ctzll(bits);
+  }
+  while (w < n_ && words_[w] == 0) {
+    ++w;
   }
+  return w;
 }
 
-void BitmapPostingListIterator::seekLast() {
-  auto* addr = reinterpret_cast<uint64_t*>(
-      postingList_->index_->allocator().address(postingList_->meta_.offset));
-  if (addr == nullptr) {
-    return;
-  }
-  uint64_t n = postingList_->meta_.maxId / 64;
-  if (n == 0) {
-    return;
-  }
-  i = n - 1;
-  addr += i;
-  while (*addr == 0 && i < n) {
-    --addr;
-    --i;
-  }
-  if (i < n) {
-    j = 63;
-    while (j >= 0) {
-      if (*addr & (uint64_t(1) << j)) {
-        break;
+uint64_t BitmapPostingListIterator::prevWord(uint64_t w) const {
+  if (w >= n_) {
+    return uint64_t(-1);
+  }
+  if (summary_) {
+    uint64_t k = w / 64;
+    uint64_t bits = summary_[k] & (~uint64_t(0) >> (63 - w % 64));
+    while (bits == 0) {
+      if (k-- == 0) {
+        return uint64_t(-1);
       }
-      --j;
-    }
-    if (j >= 0) {
-      curPosting_.id = i * 64 + j;
+      bits = summary_[k];
     }
+    return k * 64 + 63 - __builtin_clzll(bits);
   }
-}
-
-void BitmapPostingListIterator::seekTo(uint64_t id) {
-  seekFirst();
-  while (isValid() && i * 64 + j < id) {
-    next();
+  while (w < n_ && words_[w] == 0) {
+    --w;
   }
-  curPosting_.id = i * 64 + j;
+  return w;
 }
 
-void BitmapPostingListIterator::next() {
-  auto* addr = reinterpret_cast<uint64_t*>(
-      postingList_->index_->allocator().address(postingList_->meta_.offset));
-  if (addr == nullptr) {
-    return;
-  }
-  ++j;
-  while (j < 64) {
-    if (addr[i] & (uint64_t(1) << j)) {
-      break;
-    }
-    ++j;
-  }
-  if (j < 64) {
-    curPosting_.id = i * 64 + j;
+void BitmapPostingListIterator::seekForward(uint64_t pos) {
+  i = pos / 64;
+  j = 0;
+  if (i >= n_) {
+    i = n_;
     return;
   }
-  ++i;
-  uint64_t n = postingList_->meta_.maxId / 64;
-  while (addr[i] == 0 && i < n) {
-    ++i;
-  }
-  if (i < n) {
-    j = 0;
-    while (j < 64) {
-      if (addr[i] & (uint64_t(1) << j)) {
-        break;
-      }
-      ++j;
-    }
-    if (j < 64) {
-      curPosting_.id = i * 64 + j;
+  uint64_t word = words_[i] & (~uint64_t(0) << (pos % 64));
+  if (word == 0) {
+    i = nextWord(i + 1);
+    if (i >= n_) {
+      return;
     }
+    word = words_[i];
   }
+  j = __builtin_ctzll(word);
+  curPosting_.id = i * 64 + j;
 }
 
-void BitmapPostingListIterator::prev() {
-  auto* addr = reinterpret_cast<uint64_t*>(
-      postingList_->index_->allocator().address(postingList_->meta_.offset));
-  if (addr == nullptr) {
+void BitmapPostingListIterator::seekBackward(uint64_t pos) {
+  i = pos / 64;
+  j = 0;
+  if (i >= n_) {
+    i = uint64_t(-1);
     return;
   }
-  --j;
-  while (j >= 0) {
-    if (addr[i] & (uint64_t(1) << j)) {
-      break;
+  uint64_t word = words_[i] & (~uint64_t(0) >> (63 - pos % 64));
+  if (word == 0) {
+    i = prevWord(i - 1);
+    if (i >= n_) {
+      return;
     }
-    --j;
+    word = words_[i];
   }
-  if (j >= 0) {
-    curPosting_.id = i * 64 + j;
+  j = 63 - __builtin_clzll(word);
+  curPosting_.id = i * 64 + j;
+}
+
+void BitmapPostingListIterator::seekFirst() {
+  load();
+  seekForward(0);
+}
+
+void BitmapPostingListIterator::seekLast() {
+  load();
+  if (n_ == 0) {
+    i = uint64_t(-1);
     return;
   }
-  --i;
-  uint64_t n = postingList_->meta_.maxId / 64;
-  while (addr[i] == 0 && i < n) {
-    --i;
+  seekBackward(n_ * 64 - 1);
+}
+
+void BitmapPostingListIterator::seekTo(uint64_t id) {
+  load();
+  seekForward(id);
+}
+
+void BitmapPostingListIterator::next() {
+  if (isValid()) {
+    seekForward(i * 64 + j + 1);
   }
-  if (i < n) {
-    j = 63;
-    while (j >= 0) {
-      if (addr[i] & (uint64_t(1) << j)) {
-        break;
-      }
-      --j;
-    }
-    if (j >= 0) {
-      curPosting_.id = i * 64 + j;
+}
+
+void BitmapPostingListIterator::prev() {
+  if (isValid()) {
+    uint64_t pos = i * 64 + j;
+    if (pos == 0) {
+      i = uint64_t(-1);
+      return;
     }
+    seekBackward(pos - 1);
   }
 }
 
 bool BitmapPostingListIterator::isValid() const {
-  return i < postingList_->meta_.maxId / 64 && j >= 0 && j < 64;
+  return i < n_ && j >= 0 && j < 64;
 }
 
 }  // namespace crystal
@@ -43,8 +43,23 @@ class BitmapPostingListIterator : public PostingListIterator {
   const Posting* value() const override;
 
  private:
+  void load();
+
+  // first non-zero word >= w, or n_
+  uint64_t nextWord(uint64_t w) const;
+  // last non-zero word <= w, or uint64_t(-1)
+  uint64_t prevWord(uint64_t w) const;
+
+  // position at the first set bit >= pos
+  void seekForward(uint64_t pos);
+  // position at the last set bit <= pos
+  void seekBackward(uint64_t pos);
+
   BitmapPostingList* postingList_;
   BitmapPosting curPosting_;
+  const uint64_t* words_{nullptr};
+  const uint64_t* summary_{nullptr};  // one bit per non-zero word
+  uint64_t n_{0}; // count of uint64_t words
   uint64_t i{0};  // index for uint64_t id
   int j{0};       // index in uint64_t id bits
 };
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace crystal {
+
+/*
+ * A roaring container holds the low 16 bits of the ids sharing the same
+ * high bits (a 64K chunk), in one of three encodings:
+ *
+ *   kArray   sorted uint16_t values, up to kRoaringArrayMax entries
+ *   kBitset  1024 uint64_t words
+ *   kRun     (start, length - 1) uint16_t pairs, sorted by start
+ */
+struct RoaringContainer {
+  enum Type : uint16_t {
+    kArray,
+    kBitset,
+    kRun,
+  };
+
+  uint64_t key;       // id >> 16
+  int64_t offset;     // container data offset in posting allocator
+  uint32_t size;      // cardinality
+  uint16_t type;
+  uint16_t runs;      // run count for kRun
+};
+
+constexpr uint32_t kRoaringArrayMax = 4096;
+constexpr uint32_t kRoaringBitsetWords = 1024;
+
+inline uint64_t roaringKey(uint64_t id) {
+  return id >> 16;
+}
+
+inline uint16_t roaringLow(uint64_t id) {
+  return id & 0xffff;
+}
+
+inline uint64_t roaringId(uint64_t key, uint16_t low) {
+  return (key << 16) | low;
+}
+
+namespace detail {
+
+inline bool arrayContains(const uint16_t* a, uint32_t n, uint16_t x) {
+  return std::binary_search(a, a + n, x);
+}
+
+inline bool bitsetContains(const uint64_t* w, uint16_t x) {
+  return w[x >> 6] & (uint64_t(1) << (x & 63));
+}
+
+// index of the last run with start <= x, or -1
+inline int runFind(const uint16_t* r, uint32_t runs, uint16_t x) {
+  int lo = 0;
+  int hi = int(runs) - 1;
+  int found = -1;
+  while (lo <= hi) {
+    int mid = (lo + hi) / 2;
+    if (r[mid * 2] <= x) {
+      found = mid;
+      lo = mid + 1;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  return found;
+}
+
+inline bool runContains(const uint16_t* r, uint32_t runs, uint16_t x) {
+  int i = runFind(r, runs, x);
+  return i >= 0 && uint32_t(x) <= uint32_t(r[i * 2]) + r[i * 2 + 1];
+}
+
+// first set bit >= x, or -1
+inline int bitsetNext(const uint64_t* w, uint32_t x) {
+  if (x >= 65536) {
+    return -1;
+  }
+  uint32_t i = x >> 6;
+  uint64_t word = w[i] & (~uint64_t(0) << (x & 63));
+  while (word == 0) {
+    if (++i == kRoaringBitsetWords) {
+      return -1;
+    }
+    word = w[i];
+  }
+  return (i << 6) + __builtin_ctzll(word);
+}
+
+// last set bit <= x, or -1
+inline int bitsetPrev(const uint64_t* w, int x) {
+  if (x < 0) {
+    return -1;
+  }
+  int i = x >> 6;
+  uint64_t word = w[i] & (~uint64_t(0) >> (63 - (x & 63)));
+  while (word == 0) {
+    if (--i < 0) {
+      return -1;
+    }
+    word = w[i];
+  }
+  return (i << 6) + 63 - __builtin_clzll(word);
+}
+
+inline uint32_t countRuns(const uint16_t* a, uint32_t n) {
+  uint32_t runs = 0;
+  for (uint32_t i = 0; i < n; ++i) {
+    if (i == 0 || a[i] != a[i - 1] + 1) {
+      ++runs;
+    }
+  }
+  return runs;
+}
+
+inline uint32_t countRuns(const uint64_t* w) {
+  uint32_t runs = 0;
+  for (uint32_t i = 0; i < kRoaringBitsetWords; ++i) {
+    uint64_t word = w[i];
+    uint64_t carry = i > 0 ? w[i - 1] >> 63 : 0;
+    // count run starts: set bits whose predecessor is unset
+    runs += __builtin_popcountll(word & ~((word << 1) | carry));
+  }
+  return runs;
+}
+
+}  // namespace detail
+
+}  // namespace crystal
@@ -0,0 +1,507 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/bitmap/RoaringPostingList.h"
+
+#include "crystal/foundation/Logging.h"
+#include "crystal/storage/index/IndexBase.h"
+
+namespace crystal {
+
+namespace {
+
+constexpr uint32_t kMinArrayCapacity = 4;
+constexpr uint32_t kMinDirCapacity = 4;
+
+uint16_t chooseType(uint32_t size, uint32_t runs) {
+  size_t arrayBytes = size <= kRoaringArrayMax
+      ? size * sizeof(uint16_t) : size_t(-1);
+  size_t bitsetBytes = kRoaringBitsetWords * sizeof(uint64_t);
+  size_t runBytes = runs * 2 * sizeof(uint16_t);
+  if (runBytes < std::min(arrayBytes, bitsetBytes)) {
+    return RoaringContainer::kRun;
+  }
+  return arrayBytes <= bitsetBytes
+      ? RoaringContainer::kArray : RoaringContainer::kBitset;
+}
+
+}  // namespace
+
+void* RoaringPostingList::address(int64_t offset) const {
+  return index_->allocator().address(offset);
+}
+
+const RoaringContainer* RoaringPostingList::containers() const {
+  if (meta_.offset == 0) {
+    return nullptr;
+  }
+  return reinterpret_cast<const RoaringContainer*>(address(meta_.offset));
+}
+
+RoaringContainer* RoaringPostingList::directory() {
+  if (meta_.offset == 0) {
+    return nullptr;
+  }
+  return reinterpret_cast<RoaringContainer*>(address(meta_.offset));
+}
+
+size_t RoaringPostingList::lowerBound(uint64_t key) const {
+  const RoaringContainer* dir = containers();
+  size_t lo = 0;
+  size_t hi = meta_.count;
+  while (lo < hi) {
+    size_t mid = (lo + hi) / 2;
+    if (dir[mid].key < key) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+bool RoaringPostingList::exist(uint64_t id) const {
+  if (meta_.count == 0) {
+    return false;
+  }
+  uint64_t key = roaringKey(id);
+  size_t i = lowerBound(key);
+  if (i == meta_.count) {
+    return false;
+  }
+  const RoaringContainer& c = containers()[i];
+  if (c.key != key) {
+    return false;
+  }
+  uint16_t low = roaringLow(id);
+  const void* data = address(c.offset);
+  switch (c.type) {
+    case RoaringContainer::kArray:
+      return detail::arrayContains(
+          reinterpret_cast<const uint16_t*>(data), c.size, low);
+    case RoaringContainer::kBitset:
+      return detail::bitsetContains(
+          reinterpret_cast<const uint64_t*>(data), low);
+    case RoaringContainer::kRun:
+      return detail::runContains(
+          reinterpret_cast<const uint16_t*>(data), c.runs, low);
+  }
+  return false;
+}
+
+bool RoaringPostingList::rewriteDirectory(size_t i,
+                                          size_t erase,
+                                          const RoaringContainer* add,
+                                          size_t n) {
+  auto& alloc = index_->allocator();
+  size_t count = meta_.count - erase + n;
+  int64_t offset = 0;
+  if (count > 0) {
+    offset = alloc.allocate(
+        std::max(count, size_t(kMinDirCapacity)) * sizeof(RoaringContainer));
+    if (offset == 0) {
+      CRYSTAL_LOG(ERROR) << "allocate failed";
+      return false;
+    }
+    auto* dst = reinterpret_cast<RoaringContainer*>(address(offset));
+    const RoaringContainer* src = containers();
+    if (i > 0) {
+      memcpy(dst, src, i * sizeof(RoaringContainer));
+    }
+    if (n > 0) {
+      memcpy(dst + i, add, n * sizeof(RoaringContainer));
+    }
+    if (meta_.count > i + erase) {
+      memcpy(dst + i + n, src + i + erase,
+             (meta_.count - i - erase) * sizeof(RoaringContainer));
+    }
+  }
+  int64_t old = meta_.offset;
+  meta_.offset = offset;
+  meta_.count = count;
+  index_->updatePostingList(key_, &meta_);
+  if (old != 0) {
+    alloc.deallocate(old);
+  }
+  return true;
+}
+
+bool RoaringPostingList::replaceContainer(size_t i,
+                                          const RoaringContainer& c) {
+  RoaringContainer& old = directory()[i];
+  if (c.offset == old.offset) {
+    // a bitset modified in place
+    old.size = c.size;
+    index_->updatePostingList(key_, &meta_);
+    return true;
+  }
+  auto& alloc = index_->allocator();
+  int64_t data = old.offset;
+  if (!rewriteDirectory(i, 1, &c, 1)) {
+    alloc.deallocate(c.offset);
+    return false;
+  }
+  alloc.deallocate(data);
+  return true;
+}
+
+void RoaringPostingList::decode(const RoaringContainer& c,
+                                std::vector<uint16_t>& lows) const {
+  lows.clear();
+  lows.reserve(c.size);
+  const void* data = address(c.offset);
+  switch (c.type) {
+    case RoaringContainer::kArray: {
+      auto a = reinterpret_cast<const uint16_t*>(data);
+      lows.assign(a, a + c.size);
+      break;
+    }
+    case RoaringContainer::kBitset: {
+      auto w = reinterpret_cast<const uint64_t*>(data);
+      for (uint32_t i = 0; i < kRoaringBitsetWords; ++i) {
+        uint64_t word = w[i];
+        while (word != 0) {
+          lows.push_back((i << 6) + __builtin_ctzll(word));
+          word &= word - 1;
+        }
+      }
+      break;
+    }
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<const uint16_t*>(data);
+      for (uint32_t i = 0; i < c.runs; ++i) {
+        uint32_t end = uint32_t(r[i * 2]) + r[i * 2 + 1];
+        for (uint32_t x = r[i * 2]; x <= end; ++x) {
+          lows.push_back(x);
+        }
+      }
+      break;
+    }
+  }
+}
+
+bool RoaringPostingList::encode(RoaringContainer& c,
+                                const uint16_t* lows,
+                                uint32_t n,
+                                uint32_t runs) {
+  DCHECK(n != 0) << "empty container";
+  auto& alloc = index_->allocator();
+  uint16_t type = chooseType(n, runs);
+  size_t size = 0;
+  switch (type) {
+    case RoaringContainer::kArray:
+      size = std::max(n, kMinArrayCapacity) * sizeof(uint16_t);
+      break;
+    case RoaringContainer::kBitset:
+      size = kRoaringBitsetWords * sizeof(uint64_t);
+      break;
+    case RoaringContainer::kRun:
+      size = runs * 2 * sizeof(uint16_t);
+      break;
+  }
+  int64_t offset = alloc.allocate(size);
+  if (offset == 0) {
+    CRYSTAL_LOG(ERROR) << "allocate failed";
+    return false;
+  }
+  void* data = address(offset);
+  switch (type) {
+    case RoaringContainer::kArray:
+      memcpy(data, lows, n * sizeof(uint16_t));
+      break;
+    case RoaringContainer::kBitset: {
+      auto w = reinterpret_cast<uint64_t*>(data);
+      memset(w, 0, size);
+      for (uint32_t i = 0; i < n; ++i) {
+        w[lows[i] >> 6] |= uint64_t(1) << (lows[i] & 63);
+      }
+      break;
+    }
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<uint16_t*>(data);
+      uint32_t k = 0;
+      for (uint32_t i = 0; i < n; ++i) {
+        if (i == 0 || lows[i] != lows[i - 1] + 1) {
+          r[k * 2] = lows[i];
+          r[k * 2 + 1] = 0;
+          ++k;
+        } else {
+          ++r[k * 2 - 1];
+        }
+      }
+      break;
+    }
+  }
+  c.offset = offset;
+  c.size = n;
+  c.type = type;
+  c.runs = type == RoaringContainer::kRun ? runs : 0;
+  return true;
+}
+
+bool RoaringPostingList::optimize(RoaringContainer& c) {
+  std::vector<uint16_t> lows;
+  decode(c, lows);
+  uint32_t runs = detail::countRuns(lows.data(), lows.size());
+  if (chooseType(c.size, runs) == c.type) {
+    return true;
+  }
+  return encode(c, lows.data(), lows.size(), runs);
+}
+
+int RoaringPostingList::addTo(RoaringContainer& c, uint16_t low) {
+  auto& alloc = index_->allocator();
+  switch (c.type) {
+    case RoaringContainer::kArray: {
+      auto a = reinterpret_cast<const uint16_t*>(address(c.offset));
+      const uint16_t* p = std::lower_bound(a, a + c.size, low);
+      if (p != a + c.size && *p == low) {
+        return 0;
+      }
+      size_t i = p - a;
+      if (c.size == kRoaringArrayMax) {
+        std::vector<uint16_t> lows(a, a + c.size);
+        lows.insert(lows.begin() + i, low);
+        return encode(c, lows.data(), lows.size(),
+                      detail::countRuns(lows.data(), lows.size())) ? 1 : -1;
+      }
+      size_t capacity = alloc.getSize(c.offset) / sizeof(uint16_t);
+      if (c.size == capacity) {
+        capacity = std::min(capacity * 2, size_t(kRoaringArrayMax));
+      }
+      int64_t offset = alloc.allocate(capacity * sizeof(uint16_t));
+      if (offset == 0) {
+        CRYSTAL_LOG(ERROR) << "allocate failed";
+        return -1;
+      }
+      auto dst = reinterpret_cast<uint16_t*>(address(offset));
+      memcpy(dst, a, i * sizeof(uint16_t));
+      dst[i] = low;
+      memcpy(dst + i + 1, a + i, (c.size - i) * sizeof(uint16_t));
+      c.offset = offset;
+      ++c.size;
+      return 1;
+    }
+    case RoaringContainer::kBitset: {
+      auto w = reinterpret_cast<uint64_t*>(address(c.offset));
+      if (detail::bitsetContains(w, low)) {
+        return 0;
+      }
+      __atomic_or_fetch(&w[low >> 6], uint64_t(1) << (low & 63),
+                        __ATOMIC_RELEASE);
+      ++c.size;
+      return 1;
+    }
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<const uint16_t*>(address(c.offset));
+      if (detail::runContains(r, c.runs, low)) {
+        return 0;
+      }
+      std::vector<uint16_t> lows;
+      decode(c, lows);
+      lows.insert(std::lower_bound(lows.begin(), lows.end(), low), low);
+      return encode(c, lows.data(), lows.size(),
+                    detail::countRuns(lows.data(), lows.size())) ? 1 : -1;
+    }
+  }
+  return -1;
+}
+
+int RoaringPostingList::removeFrom(RoaringContainer& c, uint16_t low) {
+  auto& alloc = index_->allocator();
+  switch (c.type) {
+    case RoaringContainer::kArray: {
+      auto a = reinterpret_cast<const uint16_t*>(address(c.offset));
+      const uint16_t* p = std::lower_bound(a, a + c.size, low);
+      if (p == a + c.size || *p != low) {
+        return 0;
+      }
+      if (c.size == 1) {
+        c.size = 0;
+        return 1;
+      }
+      size_t i = p - a;
+      int64_t offset = alloc.allocate(alloc.getSize(c.offset));
+      if (offset == 0) {
+        CRYSTAL_LOG(ERROR) << "allocate failed";
+        return -1;
+      }
+      auto dst = reinterpret_cast<uint16_t*>(address(offset));
+      memcpy(dst, a, i * sizeof(uint16_t));
+      memcpy(dst + i, a + i + 1, (c.size - i - 1) * sizeof(uint16_t));
+      c.offset = offset;
+      --c.size;
+      return 1;
+    }
+    case RoaringContainer::kBitset: {
+      auto w = reinterpret_cast<uint64_t*>(address(c.offset));
+      if (!detail::bitsetContains(w, low)) {
+        return 0;
+      }
+      __atomic_and_fetch(&w[low >> 6], ~(uint64_t(1) << (low & 63)),
+                         __ATOMIC_RELEASE);
+      --c.size;
+      if (c.size <= kRoaringArrayMax && c.size > 0) {
+        optimize(c);
+      }
+      return 1;
+    }
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<const uint16_t*>(address(c.offset));
+      if (!detail::runContains(r, c.runs, low)) {
+        return 0;
+      }
+      std::vector<uint16_t> lows;
+      decode(c, lows);
+      lows.erase(std::lower_bound(lows.begin(), lows.end(), low));
+      if (lows.empty()) {
+        c.size = 0;
+        return 1;
+      }
+      return encode(c, lows.data(), lows.size(),
+                    detail::countRuns(lows.data(), lows.size())) ? 1 : -1;
+    }
+  }
+  return -1;
+}
+
+AnyPostingListIterator RoaringPostingList::iterator() {
+  if (!index_) {
+    return std::monostate();
+  }
+  RoaringPostingListIterator it(this);
+  it.seekFirst();
+  return it;
+}
+
+int RoaringPostingList::add(const Posting& posting) {
+  uint64_t id = posting.id;
+  uint64_t key = roaringKey(id);
+  uint16_t low = roaringLow(id);
+  size_t i = meta_.count > 0 ? lowerBound(key) : 0;
+  if (i == meta_.count || containers()[i].key != key) {
+    RoaringContainer c = { key, 0, 0, RoaringContainer::kArray, 0 };
+    if (!encode(c, &low, 1, 1)) {
+      CRYSTAL_LOG(ERROR) << "encode roaring container failed";
+      return -1;
+    }
+    ++meta_.size;
+    if (!rewriteDirectory(i, 0, &c, 1)) {
+      --meta_.size;
+      index_->allocator().deallocate(c.offset);
+      CRYSTAL_LOG(ERROR) << "insert roaring container failed";
+      return -1;
+    }
+    return 0;
+  }
+  RoaringContainer c = containers()[i];
+  int r = addTo(c, low);
+  if (r < 0) {
+    CRYSTAL_LOG(ERROR) << "add to roaring container failed";
+    return -1;
+  }
+  if (r > 0) {
+    ++meta_.size;
+    if (!replaceContainer(i, c)) {
+      --meta_.size;
+      CRYSTAL_LOG(ERROR) << "replace roaring container failed";
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int RoaringPostingList::remove(uint64_t id) {
+  uint64_t key = roaringKey(id);
+  size_t i = meta_.count > 0 ? lowerBound(key) : 0;
+  if (i == meta_.count || containers()[i].key != key) {
+    CRYSTAL_LOG(ERROR) << "id not exist";
+    return -1;
+  }
+  RoaringContainer c = containers()[i];
+  int r = removeFrom(c, roaringLow(id));
+  if (r < 0) {
+    CRYSTAL_LOG(ERROR) << "remove from roaring container failed";
+    return -1;
+  }
+  if (r > 0) {
+    --meta_.size;
+    bool ok = c.size == 0
+      ? rewriteDirectory(i, 1, nullptr, 0)
+      : replaceContainer(i, c);
+    if (!ok) {
+      ++meta_.size;
+      CRYSTAL_LOG(ERROR) << "replace roaring container failed";
+      return -1;
+    }
+    if (c.size == 0) {
+      index_->allocator().deallocate(c.offset);
+    }
+  }
+  return 0;
+}
+
+int RoaringPostingList::bulkLoad(std::vector<AnyPosting>& postings) {
+  if (meta_.count > 0) {
+    for (auto& posting : postings) {
+      if (add(*get(posting)) != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+  std::vector<uint64_t> ids;
+  ids.reserve(postings.size());
+  for (auto& posting : postings) {
+    ids.push_back(get(posting)->id);
+  }
+  std::sort(ids.begin(), ids.end());
+  ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+  std::vector<RoaringContainer> dir;
+  std::vector<uint16_t> lows;
+  for (size_t i = 0; i < ids.size(); ) {
+    uint64_t key = roaringKey(ids[i]);
+    lows.clear();
+    for (; i < ids.size() && roaringKey(ids[i]) == key; ++i) {
+      lows.push_back(roaringLow(ids[i]));
+    }
+    RoaringContainer c = { key, 0, 0, RoaringContainer::kArray, 0 };
+    if (!encode(c, lows.data(), lows.size(),
+                detail::countRuns(lows.data(), lows.size()))) {
+      CRYSTAL_LOG(ERROR) << "encode roaring container failed";
+      return -1;
+    }
+    dir.push_back(c);
+  }
+  if (!dir.empty()) {
+    size_t capacity = std::max(dir.size(), size_t(kMinDirCapacity));
+    int64_t offset = index_->allocator().allocate(
+        capacity * sizeof(RoaringContainer));
+    if (offset == 0) {
+      CRYSTAL_LOG(ERROR) << "allocate failed";
+      return -1;
+    }
+    memcpy(address(offset), dir.data(), dir.size() * sizeof(RoaringContainer));
+    meta_.offset = offset;
+    meta_.count = dir.size();
+  }
+  meta_.size = ids.size();
+  index_->updatePostingList(key_, &meta_);
+  return 0;
+}
+
+}  // namespace crystal
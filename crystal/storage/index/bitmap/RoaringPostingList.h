@@ -0,0 +1,122 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/storage/index/PostingList.h"
+#include "crystal/storage/index/bitmap/BitmapPosting.h"
+#include "crystal/storage/index/bitmap/RoaringContainer.h"
+
+namespace crystal {
+
+/*
+ * Compressed bitmap posting list.
+ *
+ * Ids are split into 64K chunks by their high bits, each chunk stored in
+ * the cheapest of an array, bitset or run container (chosen when the
+ * container is built or converted). Only chunks that hold postings take
+ * memory, so sparse keys cost a few bytes per posting instead of a flat
+ * bitmap up to the max id.
+ */
+class RoaringPostingList : public PostingList {
+ public:
+  struct Meta {
+    size_t size{0};
+    int64_t offset{0};    // container directory
+    uint32_t count{0};    // container count
+  };
+
+  RoaringPostingList() {}
+  RoaringPostingList(IndexBase* index, uint64_t key, const Meta& meta)
+      : PostingList(index),
+        key_(key),
+        meta_(meta) {
+  }
+
+  virtual ~RoaringPostingList() {}
+
+  AnyPosting newPosting() override;
+  AnyPosting getOnlinePosting(uint64_t id) override;
+  AnyPostingListIterator iterator() override;
+  bool newPostings(std::vector<AnyPosting>& postings) override;
+
+  size_t size() const override;
+
+  bool exist(uint64_t id) const override;
+
+  int add(const Posting& posting) override;
+  int remove(uint64_t id) override;
+  int bulkLoad(std::vector<AnyPosting>& postings) override;
+
+  size_t containerCount() const;
+  const RoaringContainer* containers() const;
+
+ private:
+  friend class RoaringPostingListIterator;
+
+  RoaringContainer* directory();
+  size_t lowerBound(uint64_t key) const;
+
+  /*
+   * Containers are modified copy-on-write for concurrent readers: the
+   * directory with [i, i + erase) replaced by the n containers of add is
+   * copied to a new allocation and published, the old one is left to its
+   * readers until recycled.
+   */
+  bool rewriteDirectory(size_t i, size_t erase,
+                        const RoaringContainer* add, size_t n);
+
+  // 1 if added (removed), 0 if present (absent), -1 on failure
+  int addTo(RoaringContainer& c, uint16_t low);
+  int removeFrom(RoaringContainer& c, uint16_t low);
+  // publishes c, modified from the i-th container
+  bool replaceContainer(size_t i, const RoaringContainer& c);
+
+  void decode(const RoaringContainer& c, std::vector<uint16_t>& lows) const;
+  bool encode(RoaringContainer& c,
+              const uint16_t* lows, uint32_t n, uint32_t runs);
+  bool optimize(RoaringContainer& c);
+
+  void* address(int64_t offset) const;
+
+  uint64_t key_;
+  Meta meta_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline AnyPosting RoaringPostingList::newPosting() {
+  return BitmapPosting();
+}
+
+inline AnyPosting RoaringPostingList::getOnlinePosting(uint64_t) {
+  return std::monostate();
+}
+
+inline bool RoaringPostingList::newPostings(std::vector<AnyPosting>& postings) {
+  DCHECK(postings.size() != 0) << "empty postings";
+  return true;
+}
+
+inline size_t RoaringPostingList::size() const {
+  return meta_.size;
+}
+
+inline size_t RoaringPostingList::containerCount() const {
+  return meta_.count;
+}
+
+}  // namespace crystal
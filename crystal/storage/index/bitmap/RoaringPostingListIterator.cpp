@@ -0,0 +1,228 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/bitmap/RoaringPostingListIterator.h"
+
+#include "crystal/storage/index/IndexBase.h"
+#include "crystal/storage/index/bitmap/RoaringPostingList.h"
+
+namespace crystal {
+
+const RoaringContainer* RoaringPostingListIterator::container() const {
+  if (ci_ >= postingList_->meta_.count) {
+    return nullptr;
+  }
+  return postingList_->containers() + ci_;
+}
+
+const void* RoaringPostingListIterator::data(const RoaringContainer& c) const {
+  return postingList_->address(c.offset);
+}
+
+void RoaringPostingListIterator::update() {
+  curPosting_.id = roaringId(container()->key, low_);
+}
+
+bool RoaringPostingListIterator::seekForward(uint32_t x) {
+  low_ = -1;
+  const RoaringContainer* c = container();
+  if (c == nullptr || x >= 65536) {
+    return false;
+  }
+  switch (c->type) {
+    case RoaringContainer::kArray: {
+      auto a = reinterpret_cast<const uint16_t*>(data(*c));
+      pos_ = std::lower_bound(a, a + c->size, x) - a;
+      if (pos_ < c->size) {
+        low_ = a[pos_];
+      }
+      break;
+    }
+    case RoaringContainer::kBitset:
+      low_ = detail::bitsetNext(
+          reinterpret_cast<const uint64_t*>(data(*c)), x);
+      break;
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<const uint16_t*>(data(*c));
+      int i = detail::runFind(r, c->runs, x);
+      if (i >= 0 && x <= uint32_t(r[i * 2]) + r[i * 2 + 1]) {
+        pos_ = i;
+        low_ = x;
+      } else if (uint32_t(i + 1) < c->runs) {
+        pos_ = i + 1;
+        low_ = r[pos_ * 2];
+      }
+      break;
+    }
+  }
+  return low_ >= 0;
+}
+
+bool RoaringPostingListIterator::seekBackward(int x) {
+  low_ = -1;
+  const RoaringContainer* c = container();
+  if (c == nullptr || x < 0) {
+    return false;
+  }
+  switch (c->type) {
+    case RoaringContainer::kArray: {
+      auto a = reinterpret_cast<const uint16_t*>(data(*c));
+      size_t i = std::upper_bound(a, a + c->size, x) - a;
+      if (i > 0) {
+        pos_ = i - 1;
+        low_ = a[pos_];
+      }
+      break;
+    }
+    case RoaringContainer::kBitset:
+      low_ = detail::bitsetPrev(
+          reinterpret_cast<const uint64_t*>(data(*c)), x);
+      break;
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<const uint16_t*>(data(*c));
+      int i = detail::runFind(r, c->runs, std::min(x, 65535));
+      if (i >= 0) {
+        pos_ = i;
+        low_ = std::min(x, int(r[i * 2]) + r[i * 2 + 1]);
+      }
+      break;
+    }
+  }
+  return low_ >= 0;
+}
+
+void RoaringPostingListIterator::nextContainer() {
+  while (++ci_ < postingList_->meta_.count) {
+    if (seekForward(0)) {
+      update();
+      return;
+    }
+  }
+  low_ = -1;
+}
+
+void RoaringPostingListIterator::prevContainer() {
+  while (ci_-- > 0) {
+    if (seekBackward(65535)) {
+      update();
+      return;
+    }
+  }
+  ci_ = postingList_->meta_.count;
+  low_ = -1;
+}
+
+void RoaringPostingListIterator::seekFirst() {
+  ci_ = 0;
+  if (seekForward(0)) {
+    update();
+  } else {
+    nextContainer();
+  }
+}
+
+void RoaringPostingListIterator::seekLast() {
+  ci_ = postingList_->meta_.count;
+  prevContainer();
+}
+
+void RoaringPostingListIterator::seekTo(uint64_t id) {
+  uint64_t key = roaringKey(id);
+  ci_ = postingList_->meta_.count > 0 ? postingList_->lowerBound(key) : 0;
+  const RoaringContainer* c = container();
+  if (c == nullptr) {
+    low_ = -1;
+    return;
+  }
+  if (seekForward(c->key == key ? roaringLow(id) : 0)) {
+    update();
+  } else {
+    nextContainer();
+  }
+}
+
+void RoaringPostingListIterator::next() {
+  const RoaringContainer* c = container();
+  if (c == nullptr || low_ < 0) {
+    return;
+  }
+  switch (c->type) {
+    case RoaringContainer::kArray: {
+      auto a = reinterpret_cast<const uint16_t*>(data(*c));
+      low_ = ++pos_ < c->size ? a[pos_] : -1;
+      break;
+    }
+    case RoaringContainer::kBitset:
+      low_ = detail::bitsetNext(
+          reinterpret_cast<const uint64_t*>(data(*c)), low_ + 1);
+      break;
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<const uint16_t*>(data(*c));
+      if (low_ < int(r[pos_ * 2]) + r[pos_ * 2 + 1]) {
+        ++low_;
+      } else {
+        low_ = ++pos_ < c->runs ? r[pos_ * 2] : -1;
+      }
+      break;
+    }
+  }
+  if (low_ >= 0) {
+    update();
+  } else {
+    nextContainer();
+  }
+}
+
+void RoaringPostingListIterator::prev() {
+  const RoaringContainer* c = container();
+  if (c == nullptr || low_ < 0) {
+    return;
+  }
+  switch (c->type) {
+    case RoaringContainer::kArray: {
+      auto a = reinterpret_cast<const uint16_t*>(data(*c));
+      low_ = pos_ > 0 ? a[--pos_] : -1;
+      break;
+    }
+    case RoaringContainer::kBitset:
+      low_ = detail::bitsetPrev(
+          reinterpret_cast<const uint64_t*>(data(*c)), low_ - 1);
+      break;
+    case RoaringContainer::kRun: {
+      auto r = reinterpret_cast<const uint16_t*>(data(*c));
+      if (low_ > r[pos_ * 2]) {
+        --low_;
+      } else if (pos_ > 0) {
+        --pos_;
+        low_ = int(r[pos_ * 2]) + r[pos_ * 2 + 1];
+      } else {
+        low_ = -1;
+      }
+      break;
+    }
+  }
+  if (low_ >= 0) {
+    update();
+  } else {
+    prevContainer();
+  }
+}
+
+bool RoaringPostingListIterator::isValid() const {
+  return ci_ < postingList_->meta_.count && low_ >= 0;
+}
+
+}  // namespace crystal
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/storage/index/PostingListIterator.h"
+#include "crystal/storage/index/bitmap/BitmapPosting.h"
+
+namespace crystal {
+
+class RoaringPostingList;
+struct RoaringContainer;
+
+class RoaringPostingListIterator : public PostingListIterator {
+ public:
+  RoaringPostingListIterator() {}
+  explicit RoaringPostingListIterator(RoaringPostingList* postingList)
+      : postingList_(postingList) {}
+
+  virtual ~RoaringPostingListIterator() {}
+
+  void seekFirst() override;
+  void seekLast() override;
+  void seekTo(uint64_t id) override;
+
+  void next() override;
+  void prev() override;
+
+  bool isValid() const override;
+
+  const Posting* value() const override;
+
+ private:
+  const RoaringContainer* container() const;
+  const void* data(const RoaringContainer& c) const;
+
+  // position at the first value >= x in current container
+  bool seekForward(uint32_t x);
+  // position at the last value <= x in current container
+  bool seekBackward(int x);
+
+  void nextContainer();
+  void prevContainer();
+  void update();
+
+  RoaringPostingList* postingList_;
+  BitmapPosting curPosting_;
+  size_t ci_{0};    // index of container
+  uint32_t pos_{0}; // index in array or run container
+  int low_{-1};     // low 16 bits of current id
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline const Posting* RoaringPostingListIterator::value() const {
+  return isValid() ? &curPosting_ : nullptr;
+}
+
+}  // namespace crystal
@@ -84,6 +84,57 @@ TEST_F(BitmapIndexTest, write) {
   manager.dump();
 }
 
+TEST_F(BitmapIndexTest, seek) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), false);
+
+  BitmapIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  index.createPostingList(300);
+  AnyPostingList pl = index.getPostingList(300);
+
+  std::vector<uint64_t> ids = {0, 63, 64, 5000, 300000, 2000000, 2000001};
+  BitmapPosting posting;
+  for (auto id : ids) {
+    posting.id = id;
+    EXPECT_EQ(0, get(pl)->add(posting));
+  }
+  EXPECT_EQ(ids.size(), get(pl)->size());
+
+  AnyPostingListIterator it = get(pl)->iterator();
+  for (auto id : ids) {
+    EXPECT_TRUE(get(it)->isValid());
+    EXPECT_EQ(id, get(it)->value()->id);
+    get(it)->next();
+  }
+  EXPECT_FALSE(get(it)->isValid());
+
+  get(it)->seekLast();
+  for (auto i = ids.rbegin(); i != ids.rend(); ++i) {
+    EXPECT_TRUE(get(it)->isValid());
+    EXPECT_EQ(*i, get(it)->value()->id);
+    get(it)->prev();
+  }
+  EXPECT_FALSE(get(it)->isValid());
+
+  get(it)->seekTo(65);
+  EXPECT_EQ(5000, get(it)->value()->id);
+  get(it)->seekTo(300000);
+  EXPECT_EQ(300000, get(it)->value()->id);
+  get(it)->seekTo(300001);
+  EXPECT_EQ(2000000, get(it)->value()->id);
+  get(it)->seekTo(2000002);
+  EXPECT_FALSE(get(it)->isValid());
+
+  EXPECT_EQ(0, get(pl)->remove(5000));
+  get(it)->seekTo(65);
+  EXPECT_EQ(300000, get(it)->value()->id);
+}
+
 TEST_F(BitmapIndexTest, read) {
   IndexConfig config;
   dynamic j = parseCson(conf);
@@ -0,0 +1,212 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <set>
+
+#include "crystal/memory/test/MemoryManagerTest.h"
+#include "crystal/storage/builder/RecordBuilder.h"
+#include "crystal/storage/index/bitmap/RoaringIndex.h"
+
+using namespace crystal;
+
+class RoaringIndexTest : public MemoryManagerTest {
+ protected:
+  const char* conf = R"(
+      {
+        record=[
+          { tag=1, name="menuId", type="uint64" },
+          { tag=2, name="status", type="int32", bits=4, default=1 }
+        ],
+        index=[
+          {
+            type="roaring",
+            key="status"
+          }
+        ]
+      }
+      )";
+
+  static void expectSame(AnyPostingList& pl, const std::set<uint64_t>& ids) {
+    EXPECT_EQ(ids.size(), get(pl)->size());
+    AnyPostingListIterator it = get(pl)->iterator();
+    for (auto id : ids) {
+      ASSERT_TRUE(get(it)->isValid());
+      EXPECT_EQ(id, get(it)->value()->id);
+      get(it)->next();
+    }
+    EXPECT_FALSE(get(it)->isValid());
+    get(it)->seekLast();
+    for (auto i = ids.rbegin(); i != ids.rend(); ++i) {
+      ASSERT_TRUE(get(it)->isValid());
+      EXPECT_EQ(*i, get(it)->value()->id);
+      get(it)->prev();
+    }
+    EXPECT_FALSE(get(it)->isValid());
+  }
+};
+
+TEST_F(RoaringIndexTest, write) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), false);
+
+  RoaringIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  index.createPostingList(100);
+  AnyPostingList pl = index.getPostingList(100);
+  EXPECT_TRUE(std::holds_alternative<RoaringPostingList>(pl));
+
+  std::set<uint64_t> ids;
+  BitmapPosting posting;
+  // sparse chunk
+  for (uint64_t id : std::vector<uint64_t>{3, 10, 70000, 5ul << 32}) {
+    posting.id = id;
+    EXPECT_EQ(0, get(pl)->add(posting));
+    ids.insert(id);
+  }
+  // dense chunk, converted to bitset
+  for (uint64_t id = 200000; id < 200000 + 20000; id += 3) {
+    posting.id = id;
+    EXPECT_EQ(0, get(pl)->add(posting));
+    ids.insert(id);
+  }
+  // a list got before an add keeps reading its own copy
+  AnyPostingList snapshot = index.getPostingList(100);
+  std::set<uint64_t> snapshotIds = ids;
+  posting.id = 4;
+  EXPECT_EQ(0, get(pl)->add(posting));
+  ids.insert(4);
+  expectSame(snapshot, snapshotIds);
+  posting.id = 10;
+  EXPECT_EQ(0, get(pl)->add(posting));
+  expectSame(pl, ids);
+
+  auto& rpl = std::get<RoaringPostingList>(pl);
+  EXPECT_EQ(4, rpl.containerCount());
+  EXPECT_EQ(RoaringContainer::kBitset, rpl.containers()[2].type);
+
+  for (uint64_t id : ids) {
+    EXPECT_TRUE(get(pl)->exist(id));
+  }
+  EXPECT_FALSE(get(pl)->exist(11));
+  EXPECT_FALSE(get(pl)->exist(200001));
+  EXPECT_FALSE(get(pl)->exist(6ul << 32));
+
+  // back to array
+  for (uint64_t id = 200000; id < 200000 + 15000; id += 3) {
+    EXPECT_EQ(0, get(pl)->remove(id));
+    ids.erase(id);
+  }
+  EXPECT_EQ(RoaringContainer::kArray, rpl.containers()[2].type);
+  // drop the container
+  EXPECT_EQ(0, get(pl)->remove(70000));
+  ids.erase(70000);
+  EXPECT_EQ(3, rpl.containerCount());
+  expectSame(pl, ids);
+
+  AnyPostingListIterator it = get(pl)->iterator();
+  get(it)->seekTo(11);
+  EXPECT_EQ(*ids.lower_bound(11), get(it)->value()->id);
+  get(it)->seekTo(215000);
+  EXPECT_EQ(*ids.lower_bound(215000), get(it)->value()->id);
+  get(it)->seekTo((5ul << 32) + 1);
+  EXPECT_FALSE(get(it)->isValid());
+
+  manager.dump();
+}
+
+TEST_F(RoaringIndexTest, bulkLoad) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), false);
+
+  RoaringIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  index.createPostingList(200);
+  AnyPostingList pl = index.getPostingList(200);
+
+  std::set<uint64_t> ids;
+  std::vector<AnyPosting> postings;
+  // run chunk
+  for (uint64_t id = 65536; id < 65536 * 2; ++id) {
+    ids.insert(id);
+  }
+  for (uint64_t id = 65536 * 3 + 5; id < 65536 * 3 + 1000; ++id) {
+    ids.insert(id);
+  }
+  ids.insert(65536 * 3 + 2000);
+  for (auto id : ids) {
+    BitmapPosting posting;
+    posting.id = id;
+    postings.push_back(posting);
+  }
+  EXPECT_EQ(0, get(pl)->bulkLoad(postings));
+
+  auto& rpl = std::get<RoaringPostingList>(pl);
+  EXPECT_EQ(2, rpl.containerCount());
+  EXPECT_EQ(RoaringContainer::kRun, rpl.containers()[0].type);
+  EXPECT_EQ(1, rpl.containers()[0].runs);
+  EXPECT_EQ(RoaringContainer::kRun, rpl.containers()[1].type);
+  EXPECT_EQ(2, rpl.containers()[1].runs);
+  expectSame(pl, ids);
+
+  AnyPostingListIterator it = get(pl)->iterator();
+  get(it)->seekTo(65536 * 2);
+  EXPECT_EQ(65536 * 3 + 5, get(it)->value()->id);
+  get(it)->seekTo(65536 * 3 + 1000);
+  EXPECT_EQ(65536 * 3 + 2000, get(it)->value()->id);
+
+  BitmapPosting posting;
+  posting.id = 65536 * 3 + 1000;
+  EXPECT_EQ(0, get(pl)->add(posting));
+  ids.insert(posting.id);
+  EXPECT_EQ(2, rpl.containers()[1].runs);
+  EXPECT_EQ(0, get(pl)->remove(65536 + 100));
+  ids.erase(65536 + 100);
+  EXPECT_EQ(2, rpl.containers()[0].runs);
+  expectSame(pl, ids);
+
+  manager.dump();
+}
+
+TEST_F(RoaringIndexTest, read) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), true);
+
+  RoaringIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  AnyPostingList pl = index.getPostingList(100);
+  EXPECT_TRUE(std::holds_alternative<RoaringPostingList>(pl));
+  EXPECT_TRUE(get(pl)->exist(10));
+  EXPECT_TRUE(get(pl)->exist(5ul << 32));
+  EXPECT_FALSE(get(pl)->exist(70000));
+
+  AnyPostingListIterator it = get(pl)->iterator();
+  EXPECT_EQ(3, get(it)->value()->id);
+
+  pl = index.getPostingList(200);
+  EXPECT_EQ(65535 + 997, get(pl)->size());
+}
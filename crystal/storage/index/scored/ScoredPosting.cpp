@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/scored/ScoredPosting.h"
+
+#include "crystal/foundation/Logging.h"
+
+namespace crystal {
+
+bool ScoredPosting::parseFrom(const Record& record) {
+  const FieldMeta* meta = record.recordMeta()->getMeta("__id");
+  if (meta == nullptr) {
+    CRYSTAL_LOG(ERROR) << "__id field not found";
+    return false;
+  }
+  id = record.get<uint64_t>(*meta);
+  meta = record.recordMeta()->getMeta(scoreField_);
+  if (meta == nullptr) {
+    CRYSTAL_LOG(ERROR) << scoreField_ << " field not found";
+    return false;
+  }
+  switch (meta->type()) {
+#define GET(type, enum_type)                    \
+    case DataType::enum_type:                   \
+      score = record.get<type>(*meta);          \
+      return true;
+
+    GET(int8_t, INT8)
+    GET(int16_t, INT16)
+    GET(int32_t, INT32)
+    GET(int64_t, INT64)
+    GET(uint8_t, UINT8)
+    GET(uint16_t, UINT16)
+    GET(uint32_t, UINT32)
+    GET(uint64_t, UINT64)
+    GET(float, FLOAT)
+    GET(double, DOUBLE)
+
+#undef GET
+
+    default:
+      break;
+  }
+  CRYSTAL_LOG(ERROR) << "unsupport score type: "
+      << dataTypeToString(meta->type());
+  return false;
+}
+
+bool ScoredPosting::update(const Record&) {
+  CRYSTAL_LOG(ERROR) << "update not support";
+  return false;
+}
+
+}  // namespace crystal
@@ -0,0 +1,59 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "crystal/storage/index/Posting.h"
+
+namespace crystal {
+
+/*
+ * Posting with a weight, the weight is read from the payload field
+ * configured by 'score' of the index.
+ */
+class ScoredPosting : public Posting {
+ public:
+  ScoredPosting() {}
+  explicit ScoredPosting(const std::string& scoreField)
+      : scoreField_(scoreField) {}
+
+  virtual ~ScoredPosting() {}
+
+  const char* data() const override;
+  size_t size() const override;
+
+  bool parseFrom(const Record& record) override;
+  bool update(const Record& record) override;
+
+  float score{0};
+
+ private:
+  std::string scoreField_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline const char* ScoredPosting::data() const {
+  return reinterpret_cast<const char*>(&id);
+}
+
+inline size_t ScoredPosting::size() const {
+  return sizeof(uint64_t);
+}
+
+}  // namespace crystal
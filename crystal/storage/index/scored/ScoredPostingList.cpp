@@ -0,0 +1,283 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/scored/ScoredPostingList.h"
+
+#include <algorithm>
+
+#include "crystal/foundation/Logging.h"
+#include "crystal/storage/index/IndexBase.h"
+
+namespace crystal {
+
+namespace {
+
+constexpr size_t kMinCapacity = kScoredBlockSize;
+
+size_t allocSize(size_t capacity) {
+  return capacity * sizeof(uint64_t) +
+      capacity / kScoredBlockSize * sizeof(ScoredBlock) +
+      capacity * sizeof(float);
+}
+
+}  // namespace
+
+void* ScoredPostingList::address(int64_t offset) const {
+  return index_->allocator().address(offset);
+}
+
+const uint64_t* ScoredPostingList::ids() const {
+  return reinterpret_cast<const uint64_t*>(address(meta_.offset));
+}
+
+const ScoredBlock* ScoredPostingList::blocks() const {
+  return reinterpret_cast<const ScoredBlock*>(ids() + meta_.capacity);
+}
+
+const float* ScoredPostingList::scores() const {
+  return reinterpret_cast<const float*>(
+      blocks() + meta_.capacity / kScoredBlockSize);
+}
+
+uint64_t* ScoredPostingList::mutableIds() {
+  return reinterpret_cast<uint64_t*>(address(meta_.offset));
+}
+
+ScoredBlock* ScoredPostingList::mutableBlocks() {
+  return reinterpret_cast<ScoredBlock*>(mutableIds() + meta_.capacity);
+}
+
+float* ScoredPostingList::mutableScores() {
+  return reinterpret_cast<float*>(
+      mutableBlocks() + meta_.capacity / kScoredBlockSize);
+}
+
+AnyPosting ScoredPostingList::newPosting() {
+  return ScoredPosting(index_->config()->score());
+}
+
+AnyPostingListIterator ScoredPostingList::iterator() {
+  if (!index_) {
+    return std::monostate();
+  }
+  ScoredPostingListIterator it(this);
+  it.seekFirst();
+  return it;
+}
+
+size_t ScoredPostingList::lowerBound(uint64_t id) const {
+  if (meta_.size == 0) {
+    return 0;
+  }
+  const uint64_t* a = ids();
+  return std::lower_bound(a, a + meta_.size, id) - a;
+}
+
+bool ScoredPostingList::exist(uint64_t id) const {
+  size_t i = lowerBound(id);
+  return i < meta_.size && ids()[i] == id;
+}
+
+bool ScoredPostingList::reserve(size_t capacity) {
+  if (capacity <= meta_.capacity) {
+    return true;
+  }
+  capacity = std::max(
+      std::max(capacity, meta_.capacity * 2), kMinCapacity);
+  capacity = (capacity + kScoredBlockSize - 1)
+      / kScoredBlockSize * kScoredBlockSize;
+  auto& alloc = index_->allocator();
+  int64_t offset = alloc.allocate(allocSize(capacity));
+  if (offset == 0) {
+    CRYSTAL_LOG(ERROR) << "allocate failed";
+    return false;
+  }
+  Meta meta = meta_;
+  meta.offset = offset;
+  meta.capacity = capacity;
+  if (meta_.offset != 0) {
+    ScoredPostingList dst(index_, key_, meta);
+    memcpy(dst.mutableIds(), ids(), meta_.size * sizeof(uint64_t));
+    memcpy(dst.mutableBlocks(), blocks(), blockCount() * sizeof(ScoredBlock));
+    memcpy(dst.mutableScores(), scores(), meta_.size * sizeof(float));
+    alloc.deallocate(meta_.offset);
+  }
+  meta_ = meta;
+  return true;
+}
+
+void ScoredPostingList::updateBlocks(size_t from) {
+  const uint64_t* a = ids();
+  const float* s = scores();
+  ScoredBlock* b = mutableBlocks();
+  size_t n = blockCount();
+  for (size_t i = from / kScoredBlockSize; i < n; ++i) {
+    size_t begin = i * kScoredBlockSize;
+    size_t end = std::min(begin + kScoredBlockSize, meta_.size);
+    b[i].lastId = a[end - 1];
+    b[i].maxScore = *std::max_element(s + begin, s + end);
+  }
+}
+
+bool ScoredPostingList::rewrite(size_t i,
+                                size_t erased,
+                                const uint64_t* newIds,
+                                const float* newScores,
+                                size_t n) {
+  Meta meta = meta_;
+  meta.size = meta_.size - erased + n;
+  if (meta.size > meta.capacity) {
+    meta.capacity = std::max(
+        std::max(meta.size, meta_.capacity * 2), kMinCapacity);
+    meta.capacity = (meta.capacity + kScoredBlockSize - 1)
+        / kScoredBlockSize * kScoredBlockSize;
+  }
+  auto& alloc = index_->allocator();
+  meta.offset = alloc.allocate(allocSize(meta.capacity));
+  if (meta.offset == 0) {
+    CRYSTAL_LOG(ERROR) << "allocate failed";
+    return false;
+  }
+  ScoredPostingList dst(index_, key_, meta);
+  uint64_t* a = dst.mutableIds();
+  float* s = dst.mutableScores();
+  if (meta_.size > 0) {
+    size_t tail = meta_.size - i - erased;
+    memcpy(a, ids(), i * sizeof(uint64_t));
+    memcpy(a + i + n, ids() + i + erased, tail * sizeof(uint64_t));
+    memcpy(s, scores(), i * sizeof(float));
+    memcpy(s + i + n, scores() + i + erased, tail * sizeof(float));
+    memcpy(dst.mutableBlocks(), blocks(),
+           i / kScoredBlockSize * sizeof(ScoredBlock));
+  }
+  for (size_t k = 0; k < n; ++k) {
+    a[i + k] = newIds[k];
+    s[i + k] = newScores[k];
+    // an upper bound, removed or lowered scores do not lower it
+    dst.meta_.maxScore = std::max(dst.meta_.maxScore, newScores[k]);
+  }
+  if (dst.meta_.size == 0) {
+    dst.meta_.maxScore = 0;
+  }
+  dst.updateBlocks(i);
+
+  // readers holding the old meta keep reading the old allocation, whose
+  // reuse is delayed by the allocator
+  int64_t old = meta_.offset;
+  meta_ = dst.meta_;
+  index_->updatePostingList(key_, &meta_);
+  if (old != 0) {
+    alloc.deallocate(old);
+  }
+  return true;
+}
+
+bool ScoredPostingList::append(uint64_t id, float score) {
+  size_t i = meta_.size;
+  mutableIds()[i] = id;
+  mutableScores()[i] = score;
+  ScoredBlock& block = mutableBlocks()[i / kScoredBlockSize];
+  if (i % kScoredBlockSize == 0) {
+    block.maxScore = score;
+  } else {
+    block.maxScore = std::max(block.maxScore, score);
+  }
+  block.lastId = id;
+
+  // readers are bounded by the size of their meta, which is published
+  // after the posting is written
+  Meta meta = meta_;
+  meta.size = i + 1;
+  meta.maxScore = i == 0 ? score : std::max(meta.maxScore, score);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  meta_ = meta;
+  index_->updatePostingList(key_, &meta_);
+  return true;
+}
+
+int ScoredPostingList::add(const Posting& posting) {
+  uint64_t id = posting.id;
+  float score = static_cast<const ScoredPosting&>(posting).score;
+  if (meta_.size < meta_.capacity &&
+      (meta_.size == 0 || id > ids()[meta_.size - 1])) {
+    return append(id, score) ? 0 : -1;
+  }
+  size_t i = lowerBound(id);
+  size_t erased = i < meta_.size && ids()[i] == id ? 1 : 0;
+  return rewrite(i, erased, &id, &score, 1) ? 0 : -1;
+}
+
+int ScoredPostingList::remove(uint64_t id) {
+  size_t i = lowerBound(id);
+  if (i == meta_.size || ids()[i] != id) {
+    CRYSTAL_LOG(ERROR) << "id not exist";
+    return -1;
+  }
+  return rewrite(i, 1, nullptr, nullptr, 0) ? 0 : -1;
+}
+
+int ScoredPostingList::bulkLoad(std::vector<AnyPosting>& postings) {
+  std::vector<std::pair<uint64_t, float>> entries;
+  entries.reserve(postings.size());
+  for (auto& posting : postings) {
+    auto& p = std::get<ScoredPosting>(posting);
+    entries.emplace_back(p.id, p.score);
+  }
+  // keep the last one of duplicated ids, same as add
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](const auto& a, const auto& b) {
+                     return a.first < b.first;
+                   });
+  std::vector<std::pair<uint64_t, float>> uniq;
+  for (auto& e : entries) {
+    if (!uniq.empty() && uniq.back().first == e.first) {
+      uniq.back() = e;
+    } else {
+      uniq.push_back(e);
+    }
+  }
+  if (meta_.size > 0) {
+    // in id order, ids above the last one are appended in place
+    ScoredPosting posting;
+    for (auto& e : uniq) {
+      posting.id = e.first;
+      posting.score = e.second;
+      if (add(posting) != 0) {
+        return -1;
+      }
+    }
+    return 0;
+  }
+  if (!reserve(uniq.size())) {
+    return -1;
+  }
+  uint64_t* a = mutableIds();
+  float* s = mutableScores();
+  for (size_t i = 0; i < uniq.size(); ++i) {
+    a[i] = uniq[i].first;
+    s[i] = uniq[i].second;
+  }
+  meta_.size = uniq.size();
+  meta_.maxScore = 0;
+  for (auto& e : uniq) {
+    meta_.maxScore = std::max(meta_.maxScore, e.second);
+  }
+  updateBlocks(0);
+  index_->updatePostingList(key_, &meta_);
+  return 0;
+}
+
+}  // namespace crystal
@@ -0,0 +1,132 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/storage/index/PostingList.h"
+#include "crystal/storage/index/scored/ScoredPosting.h"
+
+namespace crystal {
+
+constexpr size_t kScoredBlockSize = 64;
+
+// block-max metadata of every kScoredBlockSize postings
+struct ScoredBlock {
+  uint64_t lastId;
+  float maxScore;
+};
+
+/*
+ * Id ordered posting list with a score per posting.
+ *
+ * Ids, block directory and scores are kept in one allocation, the block
+ * directory lets top-K retrieval skip blocks which can not beat the
+ * current threshold without touching their postings.
+ */
+class ScoredPostingList : public PostingList {
+ public:
+  struct Meta {
+    size_t size{0};
+    size_t capacity{0};   // multiple of kScoredBlockSize
+    int64_t offset{0};
+    float maxScore{0};    // upper bound of scores
+  };
+
+  ScoredPostingList() {}
+  ScoredPostingList(IndexBase* index, uint64_t key, const Meta& meta)
+      : PostingList(index),
+        key_(key),
+        meta_(meta) {
+  }
+
+  virtual ~ScoredPostingList() {}
+
+  AnyPosting newPosting() override;
+  AnyPosting getOnlinePosting(uint64_t id) override;
+  AnyPostingListIterator iterator() override;
+  bool newPostings(std::vector<AnyPosting>& postings) override;
+
+  size_t size() const override;
+
+  bool exist(uint64_t id) const override;
+
+  int add(const Posting& posting) override;
+  int remove(uint64_t id) override;
+  int bulkLoad(std::vector<AnyPosting>& postings) override;
+
+  float maxScore() const;
+  size_t blockCount() const;
+
+  const uint64_t* ids() const;
+  const float* scores() const;
+  const ScoredBlock* blocks() const;
+
+ private:
+  friend class ScoredPostingListIterator;
+
+  bool reserve(size_t capacity);
+  void updateBlocks(size_t from);
+
+  // copy-on-write: postings [i, i + erased) are replaced by the n given
+  // ones in a new allocation, which is then published
+  bool rewrite(size_t i,
+               size_t erased,
+               const uint64_t* newIds,
+               const float* newScores,
+               size_t n);
+
+  // writes a posting above the last id in the spare capacity in place
+  bool append(uint64_t id, float score);
+
+  size_t lowerBound(uint64_t id) const;
+
+  uint64_t* mutableIds();
+  float* mutableScores();
+  ScoredBlock* mutableBlocks();
+
+  void* address(int64_t offset) const;
+
+  uint64_t key_;
+  Meta meta_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline AnyPosting ScoredPostingList::getOnlinePosting(uint64_t) {
+  return std::monostate();
+}
+
+inline bool ScoredPostingList::newPostings(std::vector<AnyPosting>& postings) {
+  DCHECK(postings.size() != 0) << "empty postings";
+  for (auto& posting : postings) {
+    posting = newPosting();
+  }
+  return true;
+}
+
+inline size_t ScoredPostingList::size() const {
+  return meta_.size;
+}
+
+inline float ScoredPostingList::maxScore() const {
+  return meta_.maxScore;
+}
+
+inline size_t ScoredPostingList::blockCount() const {
+  return (meta_.size + kScoredBlockSize - 1) / kScoredBlockSize;
+}
+
+}  // namespace crystal
@@ -0,0 +1,90 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/scored/ScoredPostingListIterator.h"
+
+#include <algorithm>
+
+#include "crystal/storage/index/scored/ScoredPostingList.h"
+
+namespace crystal {
+
+void ScoredPostingListIterator::update() {
+  if (isValid()) {
+    curPosting_.id = postingList_->ids()[i_];
+    curPosting_.score = postingList_->scores()[i_];
+  }
+}
+
+size_t ScoredPostingListIterator::blockOf(uint64_t id) const {
+  const ScoredBlock* b = postingList_->blocks();
+  size_t n = postingList_->blockCount();
+  size_t from = isValid() && curPosting_.id <= id ? i_ / kScoredBlockSize : 0;
+  return std::lower_bound(b + from, b + n, id,
+                          [](const ScoredBlock& block, uint64_t x) {
+                            return block.lastId < x;
+                          }) - b;
+}
+
+const ScoredBlock* ScoredPostingListIterator::shallowSeek(uint64_t id) const {
+  size_t i = blockOf(id);
+  return i < postingList_->blockCount() ? postingList_->blocks() + i : nullptr;
+}
+
+void ScoredPostingListIterator::seekFirst() {
+  i_ = 0;
+  update();
+}
+
+void ScoredPostingListIterator::seekLast() {
+  i_ = postingList_->size() - 1;
+  update();
+}
+
+void ScoredPostingListIterator::seekTo(uint64_t id) {
+  size_t size = postingList_->size();
+  size_t block = blockOf(id);
+  if (block == postingList_->blockCount()) {
+    i_ = size;
+    return;
+  }
+  size_t begin = block * kScoredBlockSize;
+  if (isValid() && curPosting_.id <= id) {
+    begin = std::max(begin, i_);
+  }
+  size_t end = std::min(block * kScoredBlockSize + kScoredBlockSize, size);
+  const uint64_t* a = postingList_->ids();
+  i_ = std::lower_bound(a + begin, a + end, id) - a;
+  update();
+}
+
+void ScoredPostingListIterator::next() {
+  if (isValid()) {
+    ++i_;
+  }
+  update();
+}
+
+void ScoredPostingListIterator::prev() {
+  i_ = isValid() ? i_ - 1 : postingList_->size();
+  update();
+}
+
+bool ScoredPostingListIterator::isValid() const {
+  return i_ < postingList_->size();
+}
+
+}  // namespace crystal
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/storage/index/PostingListIterator.h"
+#include "crystal/storage/index/scored/ScoredPosting.h"
+
+namespace crystal {
+
+class ScoredPostingList;
+struct ScoredBlock;
+
+class ScoredPostingListIterator : public PostingListIterator {
+ public:
+  ScoredPostingListIterator() {}
+  explicit ScoredPostingListIterator(ScoredPostingList* postingList)
+      : postingList_(postingList) {}
+
+  virtual ~ScoredPostingListIterator() {}
+
+  void seekFirst() override;
+  void seekLast() override;
+  void seekTo(uint64_t id) override;
+
+  void next() override;
+  void prev() override;
+
+  bool isValid() const override;
+
+  const Posting* value() const override;
+
+  float score() const;
+
+  // block which may hold id (the first block with lastId >= id) without
+  // moving the iterator, nullptr if id is beyond the list
+  const ScoredBlock* shallowSeek(uint64_t id) const;
+
+ private:
+  size_t blockOf(uint64_t id) const;
+  void update();
+
+  ScoredPostingList* postingList_;
+  ScoredPosting curPosting_;
+  size_t i_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline const Posting* ScoredPostingListIterator::value() const {
+  return isValid() ? &curPosting_ : nullptr;
+}
+
+inline float ScoredPostingListIterator::score() const {
+  return curPosting_.score;
+}
+
+}  // namespace crystal
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <map>
+
+#include "crystal/memory/test/MemoryManagerTest.h"
+#include "crystal/storage/builder/RecordBuilder.h"
+#include "crystal/storage/index/scored/ScoredIndex.h"
+
+using namespace crystal;
+
+class ScoredIndexTest : public MemoryManagerTest {
+ protected:
+  const char* conf = R"(
+      {
+        record=[
+          { tag=1, name="menuId", type="uint64" },
+          { tag=2, name="status", type="int32", bits=4, default=1 },
+          { tag=3, name="weight", type="float" }
+        ],
+        index=[
+          {
+            type="scored",
+            key="status",
+            payload=["weight"],
+            score="weight"
+          }
+        ]
+      }
+      )";
+
+  static void expectSame(AnyPostingList& pl,
+                         const std::map<uint64_t, float>& postings) {
+    EXPECT_EQ(postings.size(), get(pl)->size());
+    AnyPostingListIterator it = get(pl)->iterator();
+    for (auto& p : postings) {
+      ASSERT_TRUE(get(it)->isValid());
+      EXPECT_EQ(p.first, get(it)->value()->id);
+      EXPECT_EQ(p.second, std::get<ScoredPostingListIterator>(it).score());
+      get(it)->next();
+    }
+    EXPECT_FALSE(get(it)->isValid());
+  }
+
+  static void expectBlocks(AnyPostingList& pl,
+                           const std::map<uint64_t, float>& postings) {
+    auto& spl = std::get<ScoredPostingList>(pl);
+    ASSERT_EQ((postings.size() + kScoredBlockSize - 1) / kScoredBlockSize,
+              spl.blockCount());
+    size_t i = 0;
+    float maxScore = 0;
+    for (auto& p : postings) {
+      const ScoredBlock& b = spl.blocks()[i / kScoredBlockSize];
+      EXPECT_GE(b.lastId, p.first);
+      EXPECT_GE(b.maxScore, p.second);
+      maxScore = std::max(maxScore, p.second);
+      ++i;
+    }
+    // an upper bound, not lowered by removals
+    EXPECT_LE(maxScore, spl.maxScore());
+  }
+};
+
+TEST_F(ScoredIndexTest, write) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+  EXPECT_EQ("weight", config.score());
+
+  MemoryManager manager(path.c_str(), false);
+
+  ScoredIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  index.createPostingList(100);
+  AnyPostingList pl = index.getPostingList(100);
+  EXPECT_TRUE(std::holds_alternative<ScoredPostingList>(pl));
+
+  std::map<uint64_t, float> postings;
+  ScoredPosting posting;
+  for (int i = 1000; i > 0; i -= 3) {
+    uint64_t id = i;
+    posting.id = id;
+    posting.score = id % 97;
+    EXPECT_EQ(0, get(pl)->add(posting));
+    postings[id] = posting.score;
+  }
+  // overwrite score
+  posting.id = 10;
+  posting.score = 200;
+  EXPECT_EQ(0, get(pl)->add(posting));
+  postings[10] = 200;
+  expectSame(pl, postings);
+  expectBlocks(pl, postings);
+
+  EXPECT_TRUE(get(pl)->exist(10));
+  EXPECT_FALSE(get(pl)->exist(11));
+
+  // a list got before an update keeps its postings
+  AnyPostingList snapshot = index.getPostingList(100);
+  EXPECT_EQ(0, get(pl)->remove(10));
+  EXPECT_EQ(-1, get(pl)->remove(10));
+  expectSame(snapshot, postings);
+  postings.erase(10);
+  expectSame(pl, postings);
+  expectBlocks(pl, postings);
+  EXPECT_EQ(200, std::get<ScoredPostingList>(pl).maxScore());
+
+  AnyPostingListIterator it = get(pl)->iterator();
+  auto& sit = std::get<ScoredPostingListIterator>(it);
+  get(it)->seekTo(500);
+  EXPECT_EQ(postings.lower_bound(500)->first, get(it)->value()->id);
+  // shallow seek does not move the iterator
+  const ScoredBlock* b = sit.shallowSeek(900);
+  ASSERT_NE(nullptr, b);
+  EXPECT_GE(b->lastId, 900);
+  EXPECT_EQ(postings.lower_bound(500)->first, get(it)->value()->id);
+  EXPECT_EQ(nullptr, sit.shallowSeek(1001));
+  get(it)->seekTo(100);
+  EXPECT_EQ(postings.lower_bound(100)->first, get(it)->value()->id);
+  get(it)->seekTo(1001);
+  EXPECT_FALSE(get(it)->isValid());
+
+  manager.dump();
+}
+
+TEST_F(ScoredIndexTest, bulkLoad) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), false);
+
+  ScoredIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  index.createPostingList(200);
+  AnyPostingList pl = index.getPostingList(200);
+
+  std::vector<AnyPosting> postings;
+  std::map<uint64_t, float> expected;
+  for (int i = 0; i < 300; ++i) {
+    ScoredPosting posting;
+    posting.id = (i * 7919) % 1000;
+    posting.score = i * 0.5;
+    postings.push_back(posting);
+    expected[posting.id] = posting.score;
+  }
+  EXPECT_EQ(0, get(pl)->bulkLoad(postings));
+  expectSame(pl, expected);
+  expectBlocks(pl, expected);
+
+  // score from record
+  RecordBuilder<SysAllocator> builder(parseCson(conf), true);
+  builder.init(nullptr);
+  Record record = builder.build();
+  decode(parseCson("{ menuId=1, status=2, weight=2.5 }"), record);
+  record.set<uint64_t>("__id", 1001);
+  EXPECT_TRUE(index.add(200, record));
+  expected[1001] = 2.5;
+  pl = index.getPostingList(200);
+  expectSame(pl, expected);
+
+  manager.dump();
+}
+
+TEST_F(ScoredIndexTest, read) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), true);
+
+  ScoredIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  AnyPostingList pl = index.getPostingList(100);
+  EXPECT_TRUE(std::holds_alternative<ScoredPostingList>(pl));
+  EXPECT_TRUE(get(pl)->exist(1000));
+  EXPECT_FALSE(get(pl)->exist(10));
+  EXPECT_EQ(333, get(pl)->size());
+}
+
+TEST_F(ScoredIndexTest, append) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager((path + "_append").c_str(), false);
+
+  ScoredIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  index.createPostingList(300);
+  AnyPostingList pl = index.getPostingList(300);
+
+  std::map<uint64_t, float> postings;
+  ScoredPosting posting;
+  for (uint64_t id = 1; id <= 65; ++id) {
+    posting.id = id * 2;
+    posting.score = id % 13;
+    EXPECT_EQ(0, get(pl)->add(posting));
+    postings[posting.id] = posting.score;
+  }
+  AnyPostingList snapshot = index.getPostingList(300);
+  std::map<uint64_t, float> before = postings;
+  const uint64_t* ids = std::get<ScoredPostingList>(snapshot).ids();
+
+  // ids above the last one are written in place, the capacity allows
+  for (uint64_t id = 66; id <= 128; ++id) {
+    posting.id = id * 2;
+    posting.score = id % 13;
+    EXPECT_EQ(0, get(pl)->add(posting));
+    postings[posting.id] = posting.score;
+  }
+  pl = index.getPostingList(300);
+  EXPECT_EQ(ids, std::get<ScoredPostingList>(pl).ids());
+  expectSame(pl, postings);
+  expectBlocks(pl, postings);
+  expectSame(snapshot, before);
+
+  // a middle insert copies
+  posting.id = 3;
+  posting.score = 20;
+  EXPECT_EQ(0, get(pl)->add(posting));
+  postings[3] = 20;
+  EXPECT_NE(ids, std::get<ScoredPostingList>(pl).ids());
+  expectSame(pl, postings);
+  expectBlocks(pl, postings);
+
+  // bulk load into a list with postings, in id order
+  std::vector<AnyPosting> more;
+  for (uint64_t id = 400; id > 250; id -= 5) {
+    posting.id = id;
+    posting.score = id % 7;
+    more.push_back(posting);
+    postings[id] = posting.score;
+  }
+  EXPECT_EQ(0, get(pl)->bulkLoad(more));
+  pl = index.getPostingList(300);
+  expectSame(pl, postings);
+  expectBlocks(pl, postings);
+}
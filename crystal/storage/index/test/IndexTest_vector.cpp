@@ -0,0 +1,414 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <thread>
+
+#include "crystal/memory/test/MemoryManagerTest.h"
+#include "crystal/storage/builder/RecordBuilder.h"
+#include "crystal/storage/index/Index.h"
+#include "crystal/storage/index/vector/VectorIndex.h"
+#include "crystal/storage/index/vector/VectorResults.h"
+#include "crystal/strategy/IdStrategy.h"
+
+using namespace crystal;
+
+class IndexTest : public MemoryManagerTest {
+ protected:
+  const char* conf = R"(
+      {
+        record=[
+          { tag=1, name="pointId", type="uint64" },
+          { tag=2, name="vec", type="float", count=4 }
+        ],
+        index=[
+          {
+            type="Faiss:Flat",
+            key="vec",
+            strategy="id",
+            dimension=4,
+            metric="L2",
+            trainSize=1,
+            batchSize=4
+          }
+        ]
+      }
+      )";
+
+  // ids of the nearest 2 of (x, 0, 0, 0)
+  std::vector<int64_t> search(const VectorIndex* index, float x) {
+    std::vector<float> q = {x, 0, 0, 0};
+    std::vector<float> distances(2);
+    std::vector<int64_t> ids(2);
+    index->vsearch(1, q.data(), 2, distances.data(), ids.data());
+    return ids;
+  }
+};
+
+// point i is (i, 0, 0, 0) with id i + 10, the last one is pending
+TEST_F(IndexTest, write) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), false);
+
+  Index index(config);
+  EXPECT_TRUE(index.init(&manager));
+  auto vIndex = reinterpret_cast<VectorIndex*>(index.index());
+
+  RecordBuilder<SysAllocator> builder(parseCson(conf), true);
+  builder.init(nullptr);
+
+  IdStrategy strategy(index.keyMeta());
+  for (int i = 0; i < 5; ++i) {
+    Record record = builder.build(dynamic::object
+        ("pointId", i)
+        ("vec", dynamic::array(double(i), 0.0, 0.0, 0.0)));
+    record.set<uint64_t>("__id", i + 10);
+    auto keys = strategy.getIndexKeys(record);
+    EXPECT_TRUE(index.add(keys[0], record));
+    builder.release();
+    // batches are added in background
+    index.sync();
+  }
+
+  AnyPostingList pl = index.getPostingList(0);
+  EXPECT_EQ(1, get(pl)->size());
+
+  std::vector<int64_t> expected = {14, 13};
+  EXPECT_EQ(expected, search(vIndex, 4.2));
+  EXPECT_EQ(14, vIndex->labelToId(4));
+
+  manager.dump();
+}
+
+TEST_F(IndexTest, read) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), true);
+
+  Index index(config);
+  EXPECT_TRUE(index.init(&manager));
+  auto vIndex = reinterpret_cast<VectorIndex*>(index.index());
+
+  // the pending vector is kept over restart
+  AnyPostingList pl = index.getPostingList(0);
+  EXPECT_EQ(1, get(pl)->size());
+  AnyPostingListIterator it = get(pl)->iterator();
+  EXPECT_EQ(4, get(it)->value()->id);
+
+  std::vector<int64_t> expected = {14, 13};
+  EXPECT_EQ(expected, search(vIndex, 4.2));
+  expected = {10, 11};
+  EXPECT_EQ(expected, search(vIndex, -1));
+
+  std::vector<float> q = {4.2, 0, 0, 0};
+  std::vector<float> distances(2);
+  std::vector<int64_t> ids(2);
+  vIndex->vsearch(1, q.data(), 2, distances.data(), ids.data(), {11, 14});
+  expected = {14, 11};
+  EXPECT_EQ(expected, ids);
+}
+
+// trained in background once trainSize vectors are pending
+TEST_F(IndexTest, train) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  j["index"][0]["type"] = "Faiss:IVF1,Flat";
+  j["index"][0]["trainSize"] = 4;
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  std::string ivfPath = path + "_ivf";
+  MemoryManager::remove(ivfPath);
+  MemoryManager manager(ivfPath.c_str(), false);
+
+  Index index(config);
+  EXPECT_TRUE(index.init(&manager));
+  auto vIndex = reinterpret_cast<VectorIndex*>(index.index());
+
+  RecordBuilder<SysAllocator> builder(parseCson(conf), true);
+  builder.init(nullptr);
+
+  IdStrategy strategy(index.keyMeta());
+  AnyPostingList pl = index.getPostingList(0);
+  for (int i = 0; i < 6; ++i) {
+    Record record = builder.build(dynamic::object
+        ("pointId", i)
+        ("vec", dynamic::array(double(i), 0.0, 0.0, 0.0)));
+    record.set<uint64_t>("__id", i + 10);
+    auto keys = strategy.getIndexKeys(record);
+    EXPECT_TRUE(index.add(keys[0], record));
+    builder.release();
+    index.sync();
+    // trained and added at trainSize, then pending until batchSize
+    EXPECT_EQ(i < 3 ? i + 1 : (i + 1) % 4, get(pl)->size());
+  }
+
+  std::vector<int64_t> expected = {15, 14};
+  EXPECT_EQ(expected, search(vIndex, 5.2));
+  expected = {11, 12};
+  EXPECT_EQ(expected, search(vIndex, 1.4));
+  manager.dump();
+
+  // read-only, the inverted lists of the 4 added vectors are mapped
+  MemoryManager reader(ivfPath.c_str(), true);
+  Index readIndex(config);
+  EXPECT_TRUE(readIndex.init(&reader));
+  EXPECT_EQ(4 * (4 * sizeof(float) + sizeof(int64_t)),
+            reader.getMemory(MemoryType::kMemFaiss)->getMappedSize());
+}
+
+// filtered searches of IVF and HNSW pass their own search parameters,
+// for candidates and for tombstones
+TEST_F(IndexTest, filter) {
+  for (auto type : {"Faiss:IVF1,Flat", "Faiss:HNSW32"}) {
+    IndexConfig config;
+    dynamic j = parseCson(conf);
+    j["index"][0]["type"] = type;
+    j["index"][0]["trainSize"] = 4;
+    EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+    std::string filterPath = path + "_filter";
+    MemoryManager::remove(filterPath);
+    MemoryManager manager(filterPath.c_str(), false);
+
+    Index index(config);
+    EXPECT_TRUE(index.init(&manager));
+    auto vIndex = reinterpret_cast<VectorIndex*>(index.index());
+
+    RecordBuilder<SysAllocator> builder(parseCson(conf), true);
+    builder.init(nullptr);
+
+    IdStrategy strategy(index.keyMeta());
+    // 4 in faiss, 2 pending
+    for (int i = 0; i < 6; ++i) {
+      Record record = builder.build(dynamic::object
+          ("pointId", i)
+          ("vec", dynamic::array(double(i), 0.0, 0.0, 0.0)));
+      record.set<uint64_t>("__id", i + 10);
+      EXPECT_TRUE(index.add(strategy.getIndexKeys(record)[0], record));
+      builder.release();
+      index.sync();
+    }
+
+    std::vector<float> q = {4.2, 0, 0, 0};
+    std::vector<float> distances(2);
+    std::vector<int64_t> ids(2);
+    vIndex->vsearch(1, q.data(), 2, distances.data(), ids.data(),
+                    {11, 12, 15});
+    std::vector<int64_t> expected = {15, 12};
+    EXPECT_EQ(expected, ids) << type;
+    vIndex->vsearch(1, q.data(), 2, distances.data(), ids.data(), {10, 11});
+    expected = {11, 10};
+    EXPECT_EQ(expected, ids) << type;
+
+    // tombstones are skipped by a selector, kept over compaction
+    EXPECT_TRUE(vIndex->vremove(13));
+    index.sync();
+    vIndex->vcompact();
+    EXPECT_EQ(1, vIndex->deletedCount());
+    expected = {14, 15};
+    EXPECT_EQ(expected, search(vIndex, 4.2)) << type;
+    expected = {12, 14};
+    EXPECT_EQ(expected, search(vIndex, 2.8)) << type;
+  }
+}
+
+// tombstoned on remove and update, then compacted out of faiss
+TEST_F(IndexTest, remove) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  std::string removePath = path + "_remove";
+  MemoryManager::remove(removePath);
+  MemoryManager manager(removePath.c_str(), false);
+
+  Index index(config);
+  EXPECT_TRUE(index.init(&manager));
+  auto vIndex = reinterpret_cast<VectorIndex*>(index.index());
+
+  RecordBuilder<SysAllocator> builder(parseCson(conf), true);
+  builder.init(nullptr);
+
+  IdStrategy strategy(index.keyMeta());
+  auto build = [&](int i, double x) {
+    Record record = builder.build(dynamic::object
+        ("pointId", i)
+        ("vec", dynamic::array(x, 0.0, 0.0, 0.0)));
+    record.set<uint64_t>("__id", i + 10);
+    return record;
+  };
+  // 4 in faiss, 2 pending
+  for (int i = 0; i < 6; ++i) {
+    Record record = build(i, i);
+    EXPECT_TRUE(index.add(strategy.getIndexKeys(record)[0], record));
+    index.sync();
+  }
+  for (int i : {3, 5}) {
+    Record record = build(i, i);
+    EXPECT_TRUE(index.remove(strategy.getIndexKeys(record)[0], record));
+    EXPECT_FALSE(index.remove(strategy.getIndexKeys(record)[0], record));
+  }
+  Record record = build(0, 5.0);
+  EXPECT_TRUE(index.update(strategy.getIndexKeys(record)[0], record));
+  builder.release();
+
+  // may be compacted in background meanwhile
+  std::vector<int64_t> expected = {10, 14};
+  EXPECT_EQ(expected, search(vIndex, 4.9));
+  expected = {11, 12};
+  EXPECT_EQ(expected, search(vIndex, -1));
+
+  // the deleted pending one is kept until added
+  index.sync();
+  vIndex->vcompact();
+  EXPECT_EQ(1, vIndex->deletedCount());
+  EXPECT_EQ(4, vIndex->idToLabel(10));
+  expected = {10, 14};
+  EXPECT_EQ(expected, search(vIndex, 4.9));
+  expected = {11, 12};
+  EXPECT_EQ(expected, search(vIndex, -1));
+}
+
+// all vectors in the buffer and scanned, compacted in place
+TEST_F(IndexTest, flat) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  j["index"][0]["type"] = "Flat";
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  std::string flatPath = path + "_flat";
+  MemoryManager::remove(flatPath);
+  MemoryManager manager(flatPath.c_str(), false);
+
+  Index index(config);
+  EXPECT_TRUE(index.init(&manager));
+  auto vIndex = reinterpret_cast<VectorIndex*>(index.index());
+
+  RecordBuilder<SysAllocator> builder(parseCson(conf), true);
+  builder.init(nullptr);
+
+  IdStrategy strategy(index.keyMeta());
+  AnyPostingList pl = index.getPostingList(0);
+  std::vector<Record> records;
+  for (int i = 0; i < 6; ++i) {
+    Record record = builder.build(dynamic::object
+        ("pointId", i)
+        ("vec", dynamic::array(double(i), 0.0, 0.0, 0.0)));
+    record.set<uint64_t>("__id", i + 10);
+    EXPECT_TRUE(index.add(strategy.getIndexKeys(record)[0], record));
+    records.push_back(record);
+    index.sync();
+  }
+  EXPECT_EQ(6, get(pl)->size());
+
+  std::vector<int64_t> expected = {14, 15};
+  EXPECT_EQ(expected, search(vIndex, 4.2));
+
+  EXPECT_TRUE(index.remove(strategy.getIndexKeys(records[4])[0], records[4]));
+  builder.release();
+  expected = {15, 13};
+  EXPECT_EQ(expected, search(vIndex, 4.2));
+
+  index.sync();
+  vIndex->vcompact();
+  EXPECT_EQ(0, vIndex->deletedCount());
+  EXPECT_EQ(5, get(pl)->size());
+  EXPECT_EQ(4, vIndex->idToLabel(15));
+  EXPECT_EQ(15, vIndex->labelToId(4));
+  EXPECT_EQ(expected, search(vIndex, 4.2));
+  expected = {10, 11};
+  EXPECT_EQ(expected, search(vIndex, -1));
+}
+
+// larger similarity is nearer, for the flat index only
+TEST_F(IndexTest, cosine) {
+  IndexConfig faissConfig;
+  dynamic j = parseCson(conf);
+  j["index"][0]["metric"] = "COSINE";
+  EXPECT_FALSE(faissConfig.parse(j["index"][0], parseRecordConfig(j)));
+
+  IndexConfig config;
+  j["index"][0]["type"] = "Flat";
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  std::string cosinePath = path + "_cosine";
+  MemoryManager::remove(cosinePath);
+  MemoryManager manager(cosinePath.c_str(), false);
+
+  Index index(config);
+  EXPECT_TRUE(index.init(&manager));
+  auto vIndex = reinterpret_cast<VectorIndex*>(index.index());
+  EXPECT_FALSE(vIndex->ascending());
+
+  std::vector<float> x = {
+    1, 0, 0, 0,
+    3, 3, 0, 0,
+    0, 1, 0, 0,
+    -1, 0, 0, 0,
+  };
+  std::vector<uint64_t> ids = {10, 11, 12, 13};
+  EXPECT_TRUE(vIndex->vappend(x.data(), ids.data(), ids.size()));
+
+  std::vector<float> q = {1, 0.2, 0, 0};
+  std::vector<float> distances(2);
+  std::vector<int64_t> results(2);
+  vIndex->vsearch(1, q.data(), 2, distances.data(), results.data());
+  std::vector<int64_t> expected = {10, 11};
+  EXPECT_EQ(expected, results);
+  EXPECT_NEAR(1 / std::sqrt(1.04), distances[0], 1e-6);
+  EXPECT_NEAR(1.2 / std::sqrt(1.04 * 2), distances[1], 1e-6);
+}
+
+TEST(VectorResultsTest, reuse) {
+  // pools are per thread, start from an empty one
+  std::thread([]() {
+    VectorResults* p;
+    {
+      auto results = VectorResults::acquire(1000);
+      EXPECT_EQ(1000, results->size());
+      p = results.get();
+    }
+    {
+      auto results = VectorResults::acquire(10);
+      EXPECT_EQ(p, results.get());
+      EXPECT_EQ(10, results->size());
+      auto other = VectorResults::acquire(10);
+      EXPECT_NE(p, other.get());
+    }
+    EXPECT_EQ(1010 * VectorResults::kEntryBytes,
+              VectorResults::pooledBytes());
+    // over the budget, not pooled after release
+    size_t size =
+      VectorResults::kMaxPooledBytes / VectorResults::kEntryBytes;
+    {
+      auto large = VectorResults::acquire(size + 1);
+      large->ids()[size] = -1;
+      EXPECT_EQ(size + 1, large->size());
+    }
+    EXPECT_EQ(10 * VectorResults::kEntryBytes, VectorResults::pooledBytes());
+    {
+      auto a = VectorResults::acquire(size / 2);
+      auto b = VectorResults::acquire(size / 2);
+      auto c = VectorResults::acquire(size / 2);
+    }
+    EXPECT_GE(VectorResults::kMaxPooledBytes, VectorResults::pooledBytes());
+  }).join();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/memory/test/MemoryManagerTest.h"
+#include "crystal/storage/index/PostingCache.h"
+#include "crystal/storage/index/bitmap/RoaringIndex.h"
+
+using namespace crystal;
+
+class PostingCacheTest : public MemoryManagerTest {
+ protected:
+  const char* conf = R"(
+      {
+        record=[
+          { tag=1, name="menuId", type="uint64" },
+          { tag=2, name="status", type="int32", bits=4, default=1 }
+        ],
+        index=[
+          {
+            type="roaring",
+            key="status"
+          }
+        ]
+      }
+      )";
+};
+
+TEST_F(PostingCacheTest, getAndPut) {
+  IndexConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j["index"][0], parseRecordConfig(j)));
+
+  MemoryManager manager(path.c_str(), false);
+
+  RoaringIndex index(&config);
+  EXPECT_TRUE(index.init(&manager));
+
+  index.createPostingList(100);
+  AnyPostingList pl = index.getPostingList(100);
+  BitmapPosting posting;
+  for (uint64_t id = 0; id < 1000; id += 2) {
+    posting.id = id;
+    EXPECT_EQ(0, get(pl)->add(posting));
+  }
+  auto decode = [&](std::vector<uint64_t>& ids) {
+    auto it = get(pl)->iterator();
+    for (; get(it)->isValid(); get(it)->next()) {
+      ids.push_back(get(it)->value()->id);
+    }
+  };
+
+  PostingCache cache;
+  EXPECT_EQ(nullptr, cache.get(0, 100));
+  const PostingIds* ids = cache.put(0, 100, &index, decode);
+  ASSERT_NE(nullptr, ids);
+  EXPECT_EQ(500, ids->ids.size());
+  EXPECT_EQ(998, ids->ids.back());
+  EXPECT_EQ(ids, cache.get(0, 100));
+  EXPECT_EQ(ids, cache.get(0, 100));
+  // same token of other index
+  EXPECT_EQ(nullptr, cache.get(1, 100));
+  EXPECT_EQ(2, cache.hits());
+  EXPECT_EQ(2, cache.misses());
+
+  // existing entry is returned without decoding
+  EXPECT_EQ(ids, cache.put(0, 100, &index, [](std::vector<uint64_t>&) {
+    FAIL() << "decoded again";
+  }));
+
+  // kept after other posting list changed
+  index.createPostingList(200);
+  AnyPostingList other = index.getPostingList(200);
+  EXPECT_EQ(0, get(other)->add(posting));
+  EXPECT_EQ(ids, cache.get(0, 100));
+
+  // stale after posting list changed
+  posting.id = 1001;
+  EXPECT_EQ(0, get(pl)->add(posting));
+  EXPECT_EQ(nullptr, cache.get(0, 100));
+  pl = index.getPostingList(100);
+  ids = cache.put(0, 100, &index, decode);
+  ASSERT_NE(nullptr, ids);
+  EXPECT_EQ(501, ids->ids.size());
+  EXPECT_EQ(ids, cache.get(0, 100));
+}
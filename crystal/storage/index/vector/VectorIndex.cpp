@@ -16,25 +16,169 @@
 
 #include "crystal/storage/index/vector/VectorIndex.h"
 
+#include <algorithm>
+#include <cstring>
+#include <exception>
+#include <functional>
+
+#include <faiss/clone_index.h>
 #include <faiss/Index.h>
+#include <faiss/IndexFlat.h>
+#include <faiss/IndexHNSW.h>
+#include <faiss/IndexIVF.h>
+#include <faiss/impl/FaissException.h>
+#include <faiss/impl/IDSelector.h>
 #include <faiss/index_factory.h>
 #include <faiss/index_io.h>
 #include <faiss/MetricType.h>
 
 #include "crystal/foundation/Logging.h"
+#include "crystal/foundation/ThreadName.h"
+#include "crystal/memory/FaissMemory.h"
+#include "crystal/storage/index/vector/VectorResults.h"
+#include "crystal/storage/index/vector/VectorScan.h"
 
 namespace crystal {
 
+namespace {
+
+// merge the top k of b into a, both sorted and padded with -1s
+void mergeTopK(int64_t n, int64_t k, int metric,
+               float* distances, int64_t* labels,
+               const float* bDistances, const int64_t* bLabels) {
+  bool similarity = isSimilarity(metric);
+  std::vector<float> d(k);
+  std::vector<int64_t> l(k);
+  for (int64_t q = 0; q < n; ++q) {
+    float* ad = distances + q * k;
+    int64_t* al = labels + q * k;
+    const float* bd = bDistances + q * k;
+    const int64_t* bl = bLabels + q * k;
+    int64_t i = 0, j = 0;
+    for (int64_t t = 0; t < k; ++t) {
+      bool aValid = i < k && al[i] != -1;
+      bool bValid = j < k && bl[j] != -1;
+      if (aValid &&
+          (!bValid || (similarity ? ad[i] >= bd[j] : ad[i] <= bd[j]))) {
+        d[t] = ad[i];
+        l[t] = al[i++];
+      } else if (bValid) {
+        d[t] = bd[j];
+        l[t] = bl[j++];
+      } else {
+        d[t] = farthestDistance(metric);
+        l[t] = -1;
+      }
+    }
+    std::copy(d.begin(), d.end(), ad);
+    std::copy(l.begin(), l.end(), al);
+  }
+}
+
+// search the members of sel only, if given. IVF and HNSW reject the
+// base parameters, they get their own type carrying the index settings.
+// Faiss errors are logged and give empty results
+void searchFaiss(const faiss::Index* index,
+                 int64_t n, const float* x, int64_t k,
+                 float* distances, int64_t* labels,
+                 faiss::IDSelector* sel) {
+  try {
+    if (!sel) {
+      index->search(n, x, k, distances, labels);
+    } else if (auto* ivf = dynamic_cast<const faiss::IndexIVF*>(index)) {
+      faiss::IVFSearchParameters params;
+      params.nprobe = ivf->nprobe;
+      params.max_codes = ivf->max_codes;
+      params.sel = sel;
+      index->search(n, x, k, distances, labels, &params);
+    } else if (auto* hnsw = dynamic_cast<const faiss::IndexHNSW*>(index)) {
+      faiss::SearchParametersHNSW params;
+      params.efSearch = hnsw->hnsw.efSearch;
+      params.sel = sel;
+      index->search(n, x, k, distances, labels, &params);
+    } else {
+      faiss::SearchParameters params;
+      params.sel = sel;
+      index->search(n, x, k, distances, labels, &params);
+    }
+  } catch (const faiss::FaissException& e) {
+    CRYSTAL_LOG(ERROR) << "faiss search failed: " << e.what();
+    std::fill(distances, distances + n * k,
+              farthestDistance(index->metric_type));
+    std::fill(labels, labels + n * k, -1);
+  }
+}
+
+// members are the labels not deleted, and in sel if given
+struct LiveSelector : faiss::IDSelector {
+  std::function<bool(int64_t)> isDeleted;
+  const faiss::IDSelector* sel{nullptr};
+
+  bool is_member(faiss::idx_t id) const override {
+    return !isDeleted(id) && (!sel || sel->is_member(id));
+  }
+};
+
+// members are the deleted labels
+struct DeletedSelector : faiss::IDSelector {
+  std::function<bool(int64_t)> isDeleted;
+
+  bool is_member(faiss::idx_t id) const override {
+    return isDeleted(id);
+  }
+};
+
+} // namespace
+
+VectorIndex::~VectorIndex() {
+  if (worker_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(workLock_);
+      stop_ = true;
+    }
+    workCond_.notify_all();
+    worker_.join();
+  }
+}
+
 bool VectorIndex::init(MemoryManager* memory) {
   auto& meta = config_->vectorMeta();
+  vectors_.dimension = meta.dimension;
+  vectors_.memory = memory->getMemory(MemoryType::kMemVector);
   switch (meta.type) {
     case VectorType::Faiss: {
       Memory* mem = memory->getMemory(MemoryType::kMemFaiss, &meta);
+      faissMemory_ = static_cast<FaissMemory*>(mem);
       index_ = reinterpret_cast<faiss::Index*>(mem->address(kMemStart));
+      vectors_.firstId = index_->ntotal;
+      metric_ = index_->metric_type;
+      trained_ = index_->is_trained;
       break;
     }
+    case VectorType::Flat:
+      // all vectors stay in the buffer and are scanned
+      metric_ = meta.metric;
+      trained_ = true;
+      break;
+  }
+  if (!labelIds_.init(memory->getMemory(MemoryType::kMemSimple))) {
+    CRYSTAL_LOG(ERROR) << "init label-id map failed";
+    return false;
+  }
+  if (!idLabels_.init(memory->getMemory(MemoryType::kMemHash))) {
+    CRYSTAL_LOG(ERROR) << "init id-label map failed";
+    return false;
+  }
+  if (!deleted_.init(memory->getMemory(MemoryType::kMemBit))) {
+    CRYSTAL_LOG(ERROR) << "init deleted bitmask failed";
+    return false;
+  }
+  size_t end = vectors_.firstId + vectors_.size();
+  for (size_t label = 0; label < end; ++label) {
+    if (isDeleted(label)) {
+      ++deletedCount_;
+    }
   }
-  vectors_.dimension = meta.dimension;
   return true;
 }
 
@@ -48,43 +192,405 @@ void VectorIndex::createPostingList(uint64_t) {
 void VectorIndex::updatePostingList(uint64_t, void*) {
 }
 
+bool VectorIndex::update(uint64_t key, const Record& record) {
+  return add(key, record);
+}
+
+bool VectorIndex::vappend(const float* x, const uint64_t* ids, size_t n) {
+  std::unique_lock<std::shared_mutex> deletedLock(deletedLock_);
+  std::unique_lock<std::shared_mutex> lock(pendingLock_);
+  int64_t label = vectors_.firstId + vectors_.size();
+  for (size_t i = 0; i < n; ++i) {
+    // replaced vector of the id
+    int64_t old = idToLabel(ids[i]);
+    if (old != -1 && !isDeleted(old)) {
+      if (!deleted_.set(old)) {
+        CRYSTAL_LOG(ERROR) << "set deleted bitmask failed, label=" << old;
+        return false;
+      }
+      ++deletedCount_;
+    }
+    if (!setLabelId(label + i, ids[i])) {
+      return false;
+    }
+  }
+  if (!vectors_.append(x, n)) {
+    CRYSTAL_LOG(ERROR) << "append pending vectors failed";
+    return false;
+  }
+  return true;
+}
+
 void VectorIndex::vadd(bool flush) {
-  const float* x = vectors_.data.data();
-  int64_t n = vectors_.data.size() / vectors_.dimension;
+  if (!index_) {
+    return;
+  }
   if (flush) {
-    if (!index_->is_trained) {
-      index_->train(n, x);
+    std::lock_guard<std::mutex> guard(flushLock_);
+    this->flush(true);
+    return;
+  }
+  auto& meta = config_->vectorMeta();
+  size_t n;
+  {
+    std::shared_lock<std::shared_mutex> lock(pendingLock_);
+    n = vectors_.size();
+  }
+  if (n >= size_t(trained_ ? meta.batchSize : meta.trainSize)) {
+    request();
+  }
+}
+
+bool VectorIndex::vremove(uint64_t id) {
+  size_t total;
+  {
+    std::unique_lock<std::shared_mutex> deletedLock(deletedLock_);
+    std::shared_lock<std::shared_mutex> lock(pendingLock_);
+    int64_t label = idToLabel(id);
+    if (label == -1 || isDeleted(label)) {
+      CRYSTAL_LOG(ERROR) << "vector not exist, id=" << id;
+      return false;
+    }
+    if (!deleted_.set(label)) {
+      CRYSTAL_LOG(ERROR) << "set deleted bitmask failed, label=" << label;
+      return false;
+    }
+    // the label may be taken by another vector on compaction
+    auto p = idLabels_.emplace(id, int64_t(-1));
+    p.first->second.data = -1;
+    ++deletedCount_;
+    total = vectors_.firstId + vectors_.size();
+  }
+  if (deletedCount_ >= std::max(size_t(1), size_t(total * kCompactRatio))) {
+    request();
+  }
+  return true;
+}
+
+void VectorIndex::vcompact() {
+  std::lock_guard<std::mutex> guard(flushLock_);
+  compact(true);
+}
+
+void VectorIndex::request() {
+  std::call_once(workerOnce_, [this]() {
+    worker_ = std::thread([this]() { work(); });
+  });
+  {
+    std::lock_guard<std::mutex> lock(workLock_);
+    ++requested_;
+  }
+  workCond_.notify_all();
+}
+
+void VectorIndex::sync() {
+  std::unique_lock<std::mutex> lock(workLock_);
+  workCond_.wait(lock, [this]() { return done_ == requested_ || stop_; });
+}
+
+void VectorIndex::work() {
+  setThreadName("VectorIndex");
+  std::unique_lock<std::mutex> lock(workLock_);
+  while (!stop_) {
+    if (done_ == requested_) {
+      workCond_.wait(lock);
+      continue;
     }
-    index_->add(n, x);
-    vectors_.data.clear();
+    uint64_t target = requested_;
+    lock.unlock();
+    {
+      std::lock_guard<std::mutex> guard(flushLock_);
+      flush(false);
+      compact(false);
+    }
+    lock.lock();
+    done_ = target;
+    workCond_.notify_all();
+  }
+}
+
+void VectorIndex::flush(bool force) {
+  if (!index_) {
+    return;
+  }
+  // the sealed pending prefix is only moved by flush, writers append
+  // behind it and the mapping does not move on expanding
+  size_t n;
+  const float* x;
+  {
+    std::shared_lock<std::shared_mutex> lock(pendingLock_);
+    n = vectors_.size();
+    x = vectors_.data();
+  }
+  if (n == 0) {
+    return;
+  }
+  auto& meta = config_->vectorMeta();
+  bool train = !trained_;
+  if (!force && n < size_t(train ? meta.trainSize : meta.batchSize)) {
+    return;
+  }
+  // train and add on a copy out of lock, searches go on with the old
+  // index and the batch still pending, then switch in one step
+  std::unique_ptr<faiss::Index> copy(faiss::clone_index(index_));
+  if (train) {
+    copy->train(n, x);
+  }
+  copy->add(n, x);
+  faiss::Index* old;
+  {
+    std::unique_lock<std::shared_mutex> indexLock(indexLock_);
+    std::unique_lock<std::shared_mutex> pendingLock(pendingLock_);
+    index_ = copy.release();
+    old = faissMemory_->exchange(index_);
+    vectors_.erase(n);
     vectors_.firstId = index_->ntotal;
-  } else {
-    if (!index_->is_trained) {
-      if (n >= config_->vectorMeta().trainSize) {
-        index_->train(n, x);
+    trained_ = true;
+  }
+  delete old;
+  if (train) {
+    CRYSTAL_LOG(INFO) << "switched to faiss index trained by " << n
+        << " vectors";
+  }
+}
+
+void VectorIndex::compact(bool force) {
+  if (!index_) {
+    compactVectors(force);
+    return;
+  }
+  size_t ntotal = index_->ntotal;
+  if (deletedCount_ == 0 ||
+      (!force && deletedCount_ < ntotal * kCompactRatio)) {
+    return;
+  }
+  // the pending ones are not in faiss yet
+  size_t indexed = 0;
+  {
+    std::shared_lock<std::shared_mutex> deletedLock(deletedLock_);
+    for (size_t label = 0; label < ntotal; ++label) {
+      indexed += isDeleted(label);
+    }
+  }
+  if (indexed == 0 || (!force && indexed < ntotal * kCompactRatio)) {
+    return;
+  }
+  // labels of the rest are kept in order only by flat indexes, others
+  // skip the tombstones on search until rebuilt
+  if (!dynamic_cast<faiss::IndexFlat*>(index_)) {
+    CRYSTAL_LOG(DEBUG) << "compact not support on the faiss index";
+    return;
+  }
+  std::unique_lock<std::shared_mutex> indexLock(indexLock_);
+  std::unique_lock<std::shared_mutex> deletedLock(deletedLock_);
+  std::unique_lock<std::shared_mutex> pendingLock(pendingLock_);
+  DeletedSelector sel;
+  sel.isDeleted = [this](int64_t label) { return isDeleted(label); };
+  size_t removed = index_->remove_ids(sel);
+  // shift the labels down over the removed, the deleted pending ones
+  // are kept until added
+  int64_t end = vectors_.firstId + vectors_.size();
+  int64_t to = 0;
+  std::vector<int64_t> pendingDeleted;
+  for (int64_t from = 0; from < end; ++from) {
+    bool deleted = isDeleted(from);
+    if (deleted && from < int64_t(vectors_.firstId)) {
+      continue;
+    }
+    uint64_t id = labelToId(from);
+    *reinterpret_cast<uint64_t*>(labelIds_.getChunk(to)) = id;
+    if (deleted) {
+      pendingDeleted.push_back(to);
+    } else {
+      auto p = idLabels_.emplace(id, std::forward<int64_t>(to));
+      if (!p.second) {
+        p.first->second.data = to;
       }
     }
-    if (index_->is_trained && n >= config_->vectorMeta().batchSize) {
-      index_->add(n, x);
-      vectors_.data.clear();
-      vectors_.firstId = index_->ntotal;
+    ++to;
+  }
+  deleted_.clear();
+  for (auto label : pendingDeleted) {
+    deleted_.set(label);
+  }
+  deletedCount_ = pendingDeleted.size();
+  vectors_.firstId = index_->ntotal;
+  CRYSTAL_LOG(INFO) << "compacted " << removed << " deleted vectors";
+}
+
+void VectorIndex::compactVectors(bool force) {
+  size_t total;
+  {
+    std::shared_lock<std::shared_mutex> lock(pendingLock_);
+    total = vectors_.size();
+  }
+  if (deletedCount_ == 0 ||
+      (!force && deletedCount_ < total * kCompactRatio)) {
+    return;
+  }
+  std::unique_lock<std::shared_mutex> indexLock(indexLock_);
+  std::unique_lock<std::shared_mutex> deletedLock(deletedLock_);
+  std::unique_lock<std::shared_mutex> pendingLock(pendingLock_);
+  // move the rest down in order, labels are their new positions
+  int64_t d = vectors_.dimension;
+  int64_t end = vectors_.size();
+  float* p = vectors_.data();
+  int64_t to = 0;
+  for (int64_t from = 0; from < end; ++from) {
+    if (isDeleted(from)) {
+      continue;
+    }
+    if (to != from) {
+      memcpy(p + to * d, p + from * d, d * sizeof(float));
+      uint64_t id = labelToId(from);
+      *reinterpret_cast<uint64_t*>(labelIds_.getChunk(to)) = id;
+      auto it = idLabels_.emplace(id, std::forward<int64_t>(to));
+      if (!it.second) {
+        it.first->second.data = to;
+      }
     }
+    ++to;
   }
+  vectors_.resize(to);
+  deleted_.clear();
+  deletedCount_ = 0;
+  CRYSTAL_LOG(INFO) << "compacted " << end - to << " deleted vectors";
 }
 
 void VectorIndex::vsearch(
     int64_t n, const float* x, int64_t k,
-    float* distances, int64_t* labels) const {
-  /** query n vectors of dimension d to the index.
-   *
-   * return at most k vectors. If there are not enough results for a
-   * query, the result array is padded with -1s.
-   *
-   * @param x           input vectors to search, size n * d
-   * @param labels      output labels of the NNs, size n*k
-   * @param distances   output pairwise distances, size n*k
-   */
-  index_->search(n, x, k, distances, labels);
+    float* distances, int64_t* ids) const {
+  std::shared_lock<std::shared_mutex> lock(indexLock_);
+  std::shared_lock<std::shared_mutex> deletedLock(deletedLock_);
+  if (!index_ || index_->ntotal == 0) {
+    std::fill(distances, distances + n * k, farthestDistance(metric_));
+    std::fill(ids, ids + n * k, -1);
+  } else if (deletedCount_ > 0) {
+    LiveSelector sel;
+    sel.isDeleted = [this](int64_t label) { return isDeleted(label); };
+    searchFaiss(index_, n, x, k, distances, ids, &sel);
+  } else {
+    searchFaiss(index_, n, x, k, distances, ids, nullptr);
+  }
+  searchPending(n, x, k, distances, ids, nullptr);
+  toIds(n * k, ids);
+}
+
+void VectorIndex::vsearch(
+    int64_t n, const float* x, int64_t k,
+    float* distances, int64_t* ids,
+    const std::vector<uint64_t>& candidates) const {
+  std::shared_lock<std::shared_mutex> lock(indexLock_);
+  std::shared_lock<std::shared_mutex> deletedLock(deletedLock_);
+  std::vector<int64_t> labels;
+  for (uint64_t id : candidates) {
+    int64_t label = idToLabel(id);
+    if (label != -1 && !isDeleted(label)) {
+      labels.push_back(label);
+    }
+  }
+  // the pending ones are not in faiss yet
+  std::sort(labels.begin(), labels.end());
+  auto mid = std::lower_bound(
+      labels.begin(), labels.end(), int64_t(vectors_.firstId));
+  std::vector<int64_t> indexed(labels.begin(), mid);
+  std::vector<int64_t> pending(mid, labels.end());
+  int64_t m = indexed.size();
+  bool searched = false;
+  if (m == 0) {
+    std::fill(distances, distances + n * k, farthestDistance(metric_));
+    std::fill(ids, ids + n * k, -1);
+    searched = true;
+  } else if (isScannable(metric_) &&
+             m <= std::max(k, int64_t(index_->ntotal * kBruteForceRatio)) &&
+             // IVF reconstructs only with a direct map
+             !dynamic_cast<const faiss::IndexIVF*>(index_)) {
+    int64_t d = vectors_.dimension;
+    std::vector<float> buf(m * d);
+    try {
+      for (int64_t i = 0; i < m; ++i) {
+        index_->reconstruct(indexed[i], &buf[i * d]);
+      }
+      scanTopK(n, x, d, metric_, m,
+               [&](int64_t i, int64_t* label) {
+                 *label = indexed[i];
+                 return &buf[i * d];
+               },
+               k, distances, ids);
+      searched = true;
+    } catch (const std::exception& e) {
+      CRYSTAL_LOG(DEBUG) << "reconstruct failed: " << e.what();
+    }
+  }
+  if (!searched) {
+    faiss::IDSelectorBatch sel(m, indexed.data());
+    searchFaiss(index_, n, x, k, distances, ids, &sel);
+  }
+  searchPending(n, x, k, distances, ids, &pending);
+  toIds(n * k, ids);
+}
+
+void VectorIndex::searchPending(
+    int64_t n, const float* x, int64_t k,
+    float* distances, int64_t* labels,
+    const std::vector<int64_t>* pending) const {
+  if (!isScannable(metric_) || (pending && pending->empty())) {
+    return;
+  }
+  int64_t d = vectors_.dimension;
+  VectorResults::Ptr results;
+  {
+    std::shared_lock<std::shared_mutex> lock(pendingLock_);
+    if (!pending && vectors_.size() == 0) {
+      return;
+    }
+    results = VectorResults::acquire(n * k);
+    const float* base = vectors_.data();
+    int64_t first = vectors_.firstId;
+    if (pending) {
+      scanTopK(n, x, d, metric_, pending->size(),
+               [&](int64_t i, int64_t* label) {
+                 *label = (*pending)[i];
+                 return base + (*label - first) * d;
+               },
+               k, results->distances(), results->ids());
+    } else {
+      scanTopK(n, x, d, metric_, vectors_.size(),
+               [&](int64_t i, int64_t* label) -> const float* {
+                 *label = first + i;
+                 return isDeleted(*label) ? nullptr : base + i * d;
+               },
+               k, results->distances(), results->ids());
+    }
+  }
+  mergeTopK(n, k, metric_, distances, labels,
+            results->distances(), results->ids());
+}
+
+void VectorIndex::toIds(int64_t n, int64_t* labels) const {
+  for (int64_t i = 0; i < n; ++i) {
+    if (labels[i] != -1) {
+      labels[i] = labelToId(labels[i]);
+    }
+  }
+}
+
+bool VectorIndex::setLabelId(int64_t label, uint64_t id) {
+  if (!labelIds_.expand(label + 1)) {
+    CRYSTAL_LOG(ERROR) << "expand label-id map size to " << label + 1
+        << " failed";
+    return false;
+  }
+  *reinterpret_cast<uint64_t*>(labelIds_.getChunk(label)) = id;
+  auto p = idLabels_.emplace(id, std::forward<int64_t>(label));
+  if (!p.second) {
+    p.first->second.data = label;
+  }
+  return true;
+}
+
+bool VectorIndex::ascending() const {
+  return !isSimilarity(metric_);
 }
 
 }  // namespace crystal
@@ -16,8 +16,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
 #include "crystal/storage/index/IndexBase.h"
 #include "crystal/storage/index/vector/VectorPostingList.h"
+#include "crystal/storage/kv/BitMaskMap.h"
+#include "crystal/storage/kv/FixedChunkMap.h"
+#include "crystal/storage/kv/HashMap.h"
 
 namespace faiss {
 struct Index;
@@ -25,12 +34,34 @@ struct Index;
 
 namespace crystal {
 
+class FaissMemory;
+
+/*
+ * Writers append vectors to the pending buffer, a background worker
+ * trains faiss (once) and adds the batch sealed at flush start on a
+ * copy, then switches to it, while writers keep appending behind it.
+ * Searches see faiss and the pending buffer as one consistent view.
+ *
+ * Removed vectors are tombstoned by label and skipped on search until
+ * the worker compacts them out of faiss. Adding an existing id replaces
+ * its vector: the old label is tombstoned and the id maps to the new one.
+ *
+ * The Flat type has no faiss index, all vectors stay in the buffer and
+ * searches scan them exactly, for small tables. Compaction moves the
+ * rest of the vectors down in the buffer.
+ */
 class VectorIndex : public IndexBase {
  public:
+  // filtered searches scan the candidates directly if they are fewer
+  // than this ratio of the index, else search the index with a selector
+  static constexpr double kBruteForceRatio = 0.02;
+  // compact once tombstones are over this ratio of the index
+  static constexpr double kCompactRatio = 0.1;
+
   explicit VectorIndex(const IndexConfig* config)
-      : IndexBase(config) {}
+      : IndexBase(config), idLabels_(config->bucket()) {}
 
-  virtual ~VectorIndex() {}
+  virtual ~VectorIndex();
 
   bool init(MemoryManager* memory) override;
 
@@ -38,13 +69,113 @@ class VectorIndex : public IndexBase {
   void createPostingList(uint64_t key) override;
   void updatePostingList(uint64_t key, void* meta) override;
 
+  // re-add as a new vector of the same id
+  bool update(uint64_t key, const Record& record) override;
+
+  // append n vectors of the ids to pending
+  bool vappend(const float* x, const uint64_t* ids, size_t n);
+  // flush pending to faiss now, or let the worker do it in batches
   void vadd(bool flush = false);
+  // tombstone the vector of id
+  bool vremove(uint64_t id);
+  // remove tombstoned vectors from faiss now
+  void vcompact();
+  // wait for the requested background work done
+  void sync() override;
+
+  // k nearest ids of each query, padded with -1s
   void vsearch(int64_t n, const float* x, int64_t k,
-               float* distances, int64_t* labels) const;
+               float* distances, int64_t* ids) const;
+  // search among the candidate ids only
+  void vsearch(int64_t n, const float* x, int64_t k,
+               float* distances, int64_t* ids,
+               const std::vector<uint64_t>& candidates) const;
+
+  // labels are segment-local sequence numbers of added vectors
+  bool setLabelId(int64_t label, uint64_t id);
+  uint64_t labelToId(int64_t label) const;
+  // -1 if the id is not in this index
+  int64_t idToLabel(uint64_t id) const;
+
+  size_t deletedCount() const;
+
+  // smaller distance is nearer, else larger (inner product, cosine)
+  bool ascending() const;
+  int metric() const;
 
  private:
+  void work();
+  void request();
+  // add pending to faiss if over the train/batch size, or force it
+  void flush(bool force);
+  // remove tombstones from faiss if over the ratio, or force it
+  void compact(bool force);
+  // remove tombstones from the buffer of the flat index
+  void compactVectors(bool force);
+
+  // scan the pending vectors of the labels, or all the live ones if
+  // null, and merge into the results
+  void searchPending(int64_t n, const float* x, int64_t k,
+                     float* distances, int64_t* labels,
+                     const std::vector<int64_t>* pending) const;
+  // translate result labels to ids
+  void toIds(int64_t n, int64_t* labels) const;
+  bool isDeleted(int64_t label) const;
+
   VectorData vectors_;
-  faiss::Index* index_;
+  FaissMemory* faissMemory_{nullptr};
+  // null for the flat index
+  faiss::Index* index_{nullptr};
+  int metric_{0};
+  std::atomic<bool> trained_{false};
+  // index_, firstId: searches shared, worker exclusive on switch
+  mutable std::shared_mutex indexLock_;
+  // deleted_: searches shared, tombstoning and compaction exclusive
+  mutable std::shared_mutex deletedLock_;
+  // pending buffer: searches shared, writers and compaction exclusive
+  mutable std::shared_mutex pendingLock_;
+  // one flush at a time
+  std::mutex flushLock_;
+
+  std::once_flag workerOnce_;
+  std::thread worker_;
+  std::mutex workLock_;
+  std::condition_variable workCond_;
+  uint64_t requested_{0};
+  uint64_t done_{0};
+  bool stop_{false};
+
+  FixedChunkMap labelIds_{sizeof(uint64_t)};
+  HashMap<uint64_t, int64_t> idLabels_;
+  BitMaskMap deleted_;
+  std::atomic<size_t> deletedCount_{0};
 };
 
+//////////////////////////////////////////////////////////////////////
+
+inline uint64_t VectorIndex::labelToId(int64_t label) const {
+  // label is the id itself on index built without the label map
+  if (uint64_t(label) >= labelIds_.size()) {
+    return label;
+  }
+  return *reinterpret_cast<const uint64_t*>(labelIds_.getChunk(label));
+}
+
+inline int64_t VectorIndex::idToLabel(uint64_t id) const {
+  auto it = idLabels_.find(id);
+  return it != idLabels_.cend() ? it->second.data : -1;
+}
+
+inline bool VectorIndex::isDeleted(int64_t label) const {
+  return uint64_t(label) < deleted_.slotCount() && deleted_.isSet(label);
+}
+
+inline size_t VectorIndex::deletedCount() const {
+  return deletedCount_;
+}
+
+inline int VectorIndex::metric() const {
+  return metric_;
+}
+
 }  // namespace crystal
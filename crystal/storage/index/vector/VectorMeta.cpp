@@ -73,4 +73,11 @@ int stringToFaissMetric(const char* str) {
   return -1;
 }
 
+int stringToVectorMetric(const char* str) {
+  if (strcasecmp(str, "COSINE") == 0) {
+    return kMetricCosine;
+  }
+  return stringToFaissMetric(str);
+}
+
 }  // namespace crystal
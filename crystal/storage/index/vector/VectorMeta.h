@@ -22,7 +22,8 @@
 namespace crystal {
 
 #define CRYSTAL_VECTOR_TYPE_GEN(x)  \
-  x(Faiss)
+  x(Faiss),                         \
+  x(Flat)
 
 #define CRYSTAL_VECTOR_TYPE_ENUM(type) type
 
@@ -34,7 +35,12 @@ enum class VectorType {
 
 const char* vectorTypeToString(VectorType type);
 
+// not a faiss metric, for the flat index only
+constexpr int kMetricCosine = 100;
+
 int stringToFaissMetric(const char* str);
+// faiss metrics and COSINE, -1 if unknown
+int stringToVectorMetric(const char* str);
 
 struct VectorMeta {
   VectorType type;
@@ -15,6 +15,7 @@
  */
 
 #include "crystal/storage/index/vector/VectorPosting.h"
+#include "crystal/math/Quantize.h"
 #include "crystal/storage/index/IndexBase.h"
 
 namespace crystal {
@@ -37,6 +38,7 @@ VectorPosting::VectorPosting(VectorPosting&& other) {
 }
 
 VectorPosting& VectorPosting::operator=(VectorPosting&& other) {
+  std::swap(id, other.id);
   std::swap(postingList_, other.postingList_);
   std::swap(base_, other.base_);
   std::swap(ownMemory_, other.ownMemory_);
@@ -55,12 +57,47 @@ bool VectorPosting::parseFrom(const Record& record) {
     return false;
   }
   id = record.get<uint64_t>(*meta);
-  auto a = record.get<Array<float>>(postingList_->index()->keyMeta());
-  if (a.size() * sizeof(float) != size_) {
+  const FieldMeta& keyMeta = postingList_->index()->keyMeta();
+  float* x = reinterpret_cast<float*>(base_);
+  switch (keyMeta.type()) {
+    case DataType::FLOAT: {
+      auto a = record.get<Array<float>>(keyMeta);
+      if (!checkDimension(a.size())) {
+        return false;
+      }
+      memcpy(base_, a.data(), size_);
+      break;
+    }
+    case DataType::FLOAT16: {
+      auto a = record.get<Array<float16>>(keyMeta);
+      if (!checkDimension(a.size())) {
+        return false;
+      }
+      dequantizeHalf(reinterpret_cast<const Half*>(a.data()), a.size(), x);
+      break;
+    }
+    case DataType::INT8: {
+      auto a = record.get<Array<int8_t>>(keyMeta);
+      if (!checkDimension(a.size())) {
+        return false;
+      }
+      float scale = keyMeta.isQuantized() ? keyMeta.scale() : 1;
+      dequantizeInt8(a.data(), a.size(), scale, x);
+      break;
+    }
+    default:
+      CRYSTAL_LOG(ERROR) << "unsupport vector type: "
+          << dataTypeToString(keyMeta.type());
+      return false;
+  }
+  return true;
+}
+
+bool VectorPosting::checkDimension(size_t n) const {
+  if (n * sizeof(float) != size_) {
     CRYSTAL_LOG(ERROR) << "vector data unmatch dimension";
     return false;
   }
-  memcpy(base_, a.data(), size_);
   return true;
 }
 
@@ -44,6 +44,8 @@ class VectorPosting : public Posting {
   bool update(const Record& record) override;
 
  private:
+  bool checkDimension(size_t n) const;
+
   PostingList* postingList_{nullptr};
   char* base_{nullptr};
   bool ownMemory_{false};
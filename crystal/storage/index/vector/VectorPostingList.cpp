@@ -55,24 +55,34 @@ bool VectorPostingList::newPostings(std::vector<AnyPosting>& postings) {
 }
 
 int VectorPostingList::add(const Posting& posting) {
-  auto p = reinterpret_cast<const float*>(posting.data());
-  auto e = reinterpret_cast<const float*>(posting.data() + posting.size());
-  vectors_->data.insert(vectors_->data.end(), p, e);
-  reinterpret_cast<VectorIndex*>(index_)->vadd();
+  auto vIndex = reinterpret_cast<VectorIndex*>(index_);
+  if (!vIndex->vappend(
+          reinterpret_cast<const float*>(posting.data()), &posting.id, 1)) {
+    return -1;
+  }
+  vIndex->vadd();
   return 0;
 }
 
-int VectorPostingList::remove(uint64_t) {
-  CRYSTAL_LOG(ERROR) << "remove not support";
-  return -1;
+int VectorPostingList::remove(uint64_t id) {
+  auto vIndex = reinterpret_cast<VectorIndex*>(index_);
+  return vIndex->vremove(id) ? 0 : -1;
 }
 
 int VectorPostingList::bulkLoad(std::vector<AnyPosting>& postings) {
+  auto vIndex = reinterpret_cast<VectorIndex*>(index_);
+  std::vector<uint64_t> ids;
+  ids.reserve(postings.size());
+  for (auto& posting : postings) {
+    ids.push_back(get(posting)->id);
+  }
+  // postings are allocated contiguous by newPostings
   auto posting = get(postings[0]);
-  auto p = reinterpret_cast<const float*>(posting->data());
-  auto e = reinterpret_cast<const float*>(posting->data() + posting->size());
-  vectors_->data.insert(vectors_->data.end(), p, e);
-  reinterpret_cast<VectorIndex*>(index_)->vadd(true);
+  if (!vIndex->vappend(reinterpret_cast<const float*>(posting->data()),
+                       ids.data(), ids.size())) {
+    return -1;
+  }
+  vIndex->vadd(true);
   return 0;
 }
 
@@ -16,15 +16,29 @@
 
 #pragma once
 
+#include <cstring>
+
+#include "crystal/memory/Memory.h"
 #include "crystal/storage/index/PostingList.h"
 #include "crystal/storage/index/vector/VectorPosting.h"
 
 namespace crystal {
 
+// vectors not added to faiss yet, or all of the flat index, kept in
+// mmap memory over restarts, labeled from firstId on
 struct VectorData {
-  std::vector<float> data;
+  Memory* memory{nullptr};
   int64_t dimension;
   uint64_t firstId{0};
+
+  size_t size() const;
+  float* data() const;
+
+  bool append(const float* x, size_t n);
+  // drop the first n vectors
+  void erase(size_t n);
+  // keep the first n vectors
+  void resize(size_t n);
 };
 
 class VectorPostingList : public PostingList {
@@ -57,12 +71,47 @@ class VectorPostingList : public PostingList {
 
 //////////////////////////////////////////////////////////////////////
 
+inline size_t VectorData::size() const {
+  return memory->getAllocatedSize() / (dimension * sizeof(float));
+}
+
+inline float* VectorData::data() const {
+  return reinterpret_cast<float*>(memory->address(kMemStart));
+}
+
+inline bool VectorData::append(const float* x, size_t n) {
+  size_t size = n * dimension * sizeof(float);
+  int64_t offset = memory->allocate(size);
+  if (offset == 0) {
+    return false;
+  }
+  memcpy(memory->address(offset), x, size);
+  return true;
+}
+
+inline void VectorData::erase(size_t n) {
+  size_t rest = (size() - n) * dimension * sizeof(float);
+  float* p = data();
+  memmove(p, p + n * dimension, rest);
+  memory->reset();
+  if (rest > 0) {
+    memory->allocate(rest);
+  }
+}
+
+inline void VectorData::resize(size_t n) {
+  memory->reset();
+  if (n > 0) {
+    memory->allocate(n * dimension * sizeof(float));
+  }
+}
+
 inline AnyPosting VectorPostingList::getOnlinePosting(uint64_t) {
   return std::monostate();
 }
 
 inline size_t VectorPostingList::size() const {
-  return vectors_->data.size() / vectors_->dimension;
+  return vectors_->size();
 }
 
 inline bool VectorPostingList::exist(uint64_t id) const {
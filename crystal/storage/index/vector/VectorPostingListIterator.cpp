@@ -28,14 +28,14 @@ VectorPostingListIterator::VectorPostingListIterator(
 
 void VectorPostingListIterator::seekFirst() {
   i_ = 0;
-  float* addr = &vectors_->data[0];
+  float* addr = vectors_->data();
   curPosting_.setBase(reinterpret_cast<char*>(addr));
   curPosting_.id = vectors_->firstId;
 }
 
 void VectorPostingListIterator::seekLast() {
   i_ = postingList_->size() - 1;
-  float* addr = &vectors_->data[postingSize_ / sizeof(float) * i_];
+  float* addr = vectors_->data() + postingSize_ / sizeof(float) * i_;
   curPosting_.setBase(reinterpret_cast<char*>(addr));
   curPosting_.id = vectors_->firstId + i_;
 }
@@ -52,7 +52,7 @@ void VectorPostingListIterator::next() {
   if (i_ >= postingList_->size()) {
     return;
   }
-  float* addr = &vectors_->data[postingSize_ / sizeof(float) * i_];
+  float* addr = vectors_->data() + postingSize_ / sizeof(float) * i_;
   curPosting_.setBase(reinterpret_cast<char*>(addr));
   curPosting_.id = vectors_->firstId + i_;
 }
@@ -62,7 +62,7 @@ void VectorPostingListIterator::prev() {
   if (i_ >= postingList_->size()) {
     return;
   }
-  float* addr = &vectors_->data[postingSize_ / sizeof(float) * i_];
+  float* addr = vectors_->data() + postingSize_ / sizeof(float) * i_;
   curPosting_.setBase(reinterpret_cast<char*>(addr));
   curPosting_.id = vectors_->firstId + i_;
 }
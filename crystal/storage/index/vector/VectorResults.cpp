@@ -0,0 +1,66 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/vector/VectorResults.h"
+
+#include <vector>
+
+namespace crystal {
+
+namespace {
+
+thread_local std::vector<std::unique_ptr<VectorResults>> tFree;
+thread_local size_t tFreeBytes = 0;
+
+} // namespace
+
+void VectorResults::Release::operator()(VectorResults* results) const {
+  size_t bytes = results->capacity_ * kEntryBytes;
+  if (tFreeBytes + bytes <= kMaxPooledBytes) {
+    tFree.emplace_back(results);
+    tFreeBytes += bytes;
+  } else {
+    delete results;
+  }
+}
+
+VectorResults::Ptr VectorResults::acquire(size_t size) {
+  std::unique_ptr<VectorResults> results;
+  if (!tFree.empty()) {
+    results = std::move(tFree.back());
+    tFree.pop_back();
+    tFreeBytes -= results->capacity_ * kEntryBytes;
+  } else {
+    results = std::make_unique<VectorResults>();
+  }
+  results->reserve(size);
+  return Ptr(results.release());
+}
+
+size_t VectorResults::pooledBytes() {
+  return tFreeBytes;
+}
+
+void VectorResults::reserve(size_t size) {
+  if (size > capacity_) {
+    distances_.reset(new float[size]);
+    ids_.reset(new int64_t[size]);
+    capacity_ = size;
+  }
+  size_ = size;
+}
+
+}  // namespace crystal
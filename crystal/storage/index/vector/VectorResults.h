@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+namespace crystal {
+
+/*
+ * Distance and id buffers of a batched vector search, n * k each.
+ * Buffers are heap allocated (the size may go up to tens of millions
+ * for offline joins) and only grow, the contents are not initialized.
+ */
+class VectorResults {
+ public:
+  // bytes of free buffers kept by every thread, larger buffers (offline
+  // joins) are freed on release
+  static constexpr size_t kMaxPooledBytes = 4ul << 20;
+  static constexpr size_t kEntryBytes = sizeof(float) + sizeof(int64_t);
+
+  struct Release {
+    void operator()(VectorResults* results) const;
+  };
+
+  typedef std::unique_ptr<VectorResults, Release> Ptr;
+
+  // reuse a free buffer of the calling thread if any, buffers are put
+  // back to the free list of the releasing thread, so steady state
+  // searches do not allocate
+  static Ptr acquire(size_t size);
+
+  // bytes of free buffers kept by the calling thread
+  static size_t pooledBytes();
+
+  float* distances() const;
+  int64_t* ids() const;
+  size_t size() const;
+
+ private:
+  void reserve(size_t size);
+
+  std::unique_ptr<float[]> distances_;
+  std::unique_ptr<int64_t[]> ids_;
+  size_t size_{0};
+  size_t capacity_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline float* VectorResults::distances() const {
+  return distances_.get();
+}
+
+inline int64_t* VectorResults::ids() const {
+  return ids_.get();
+}
+
+inline size_t VectorResults::size() const {
+  return size_;
+}
+
+}  // namespace crystal
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/index/vector/VectorScan.h"
+
+namespace crystal {
+
+bool isSimilarity(int metric) {
+  return metric == faiss::METRIC_INNER_PRODUCT || metric == kMetricCosine;
+}
+
+bool isScannable(int metric) {
+  return isSimilarity(metric) || metric == faiss::METRIC_L2;
+}
+
+namespace detail {
+
+ScanScratch& acquireScanScratch(size_t n, size_t k) {
+  thread_local ScanScratch tScratch;
+  tScratch.heads.resize(n * k);
+  tScratch.sizes.assign(n, 0);
+  return tScratch;
+}
+
+void releaseScanScratch(ScanScratch& scratch) {
+  if (scratch.heads.capacity() * sizeof(ScanHead) +
+      scratch.sizes.capacity() * sizeof(int64_t) > ScanScratch::kMaxBytes) {
+    std::vector<ScanHead>().swap(scratch.heads);
+    std::vector<int64_t>().swap(scratch.sizes);
+  }
+}
+
+} // namespace detail
+
+namespace {
+
+template <class T>
+float vectorDistanceImpl(int metric, const float* a, const T* b, size_t d) {
+  switch (metric) {
+    case faiss::METRIC_INNER_PRODUCT:
+      return innerProduct(a, b, d);
+    case kMetricCosine:
+      return cosineSimilarity(a, b, d);
+    default:
+      return l2Sqr(a, b, d);
+  }
+}
+
+} // namespace
+
+float vectorDistance(int metric, const float* a, const float* b, size_t d) {
+  return vectorDistanceImpl(metric, a, b, d);
+}
+
+float vectorDistance(int metric, const float* a, const Half* b, size_t d) {
+  return vectorDistanceImpl(metric, a, b, d);
+}
+
+float vectorDistance(int metric, const int8_t* a, const int8_t* b, size_t d,
+                     float scale) {
+  switch (metric) {
+    case faiss::METRIC_INNER_PRODUCT:
+      return innerProduct(a, b, d) * scale * scale;
+    case kMetricCosine:
+      return cosineSimilarity(a, b, d);
+    default:
+      return l2Sqr(a, b, d) * scale * scale;
+  }
+}
+
+float farthestDistance(int metric) {
+  return isSimilarity(metric) ? -std::numeric_limits<float>::max()
+                              : std::numeric_limits<float>::max();
+}
+
+}  // namespace crystal
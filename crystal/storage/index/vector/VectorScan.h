@@ -0,0 +1,177 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include <faiss/MetricType.h>
+
+#include "crystal/math/Distance.h"
+#include "crystal/storage/index/vector/VectorMeta.h"
+
+namespace crystal {
+
+// larger is nearer (inner product, cosine), else smaller
+bool isSimilarity(int metric);
+
+// L2, inner product and cosine are supported by scan
+bool isScannable(int metric);
+
+float vectorDistance(int metric, const float* a, const float* b, size_t d);
+float vectorDistance(int metric, const float* a, const Half* b, size_t d);
+
+// a and b are int8 codes of the same scale, the distance is of the
+// vectors they encode
+float vectorDistance(int metric, const int8_t* a, const int8_t* b, size_t d,
+                     float scale);
+
+// the farthest distance of the metric, to pad results
+float farthestDistance(int metric);
+
+/*
+ * Exact k nearest search of n queries over m base vectors, nearest
+ * first and padded with -1s. The base is scanned in blocks that fit in
+ * L2 cache, every query is compared to the whole block before moving
+ * on and keeps a bounded heap of its k nearest.
+ *
+ * base(i, &label) returns the i-th vector and sets its label, or
+ * returns null to skip it.
+ */
+template <class Base>
+void scanTopK(int64_t n, const float* x, int64_t d, int metric,
+              int64_t m, Base&& base, int64_t k,
+              float* distances, int64_t* labels);
+
+//////////////////////////////////////////////////////////////////////
+
+namespace detail {
+
+constexpr size_t kScanBlockBytes = 256 << 10;
+
+// (key, label) of a scanned vector, similarities are negated as keys
+typedef std::pair<float, int64_t> ScanHead;
+
+/*
+ * Heaps of the queries of a scan, a slice of k heads each, kept by every
+ * thread so steady state scans do not allocate. Scratch larger than
+ * kMaxBytes (offline joins) is freed on release.
+ */
+struct ScanScratch {
+  static constexpr size_t kMaxBytes = 4ul << 20;
+
+  std::vector<ScanHead> heads;
+  std::vector<int64_t> sizes;
+};
+
+// the scratch of the calling thread, of n empty heaps of k
+ScanScratch& acquireScanScratch(size_t n, size_t k);
+void releaseScanScratch(ScanScratch& scratch);
+
+template <class Base, class Distance>
+void scanTopK(int64_t n, const float* x, int64_t d, bool similarity,
+              int64_t m, Base& base, Distance distance, int64_t k,
+              float* distances, int64_t* labels) {
+  // the farthest of each query on top, no more than m heads
+  int64_t h = std::min(k, m);
+  ScanScratch& scratch = acquireScanScratch(n, h);
+  int64_t block = std::max(int64_t(1),
+                           int64_t(kScanBlockBytes / (d * sizeof(float))));
+  for (int64_t begin = 0; begin < m; begin += block) {
+    int64_t end = std::min(m, begin + block);
+    for (int64_t q = 0; q < n; ++q) {
+      const float* a = x + q * d;
+      ScanHead* heap = scratch.heads.data() + q * h;
+      int64_t& size = scratch.sizes[q];
+      for (int64_t i = begin; i < end; ++i) {
+        int64_t label;
+        const float* b = base(i, &label);
+        if (!b) {
+          continue;
+        }
+        float key = distance(a, b, d);
+        if (similarity) {
+          key = -key;
+        }
+        if (size < h) {
+          heap[size++] = ScanHead(key, label);
+          std::push_heap(heap, heap + size);
+        } else if (key < heap[0].first) {
+          std::pop_heap(heap, heap + size);
+          heap[size - 1] = ScanHead(key, label);
+          std::push_heap(heap, heap + size);
+        }
+      }
+    }
+  }
+  float farthest = similarity ? -std::numeric_limits<float>::max()
+                              : std::numeric_limits<float>::max();
+  for (int64_t q = 0; q < n; ++q) {
+    ScanHead* heap = scratch.heads.data() + q * h;
+    int64_t size = scratch.sizes[q];
+    std::sort_heap(heap, heap + size);
+    for (int64_t j = 0; j < k; ++j) {
+      if (j < size) {
+        distances[q * k + j] = similarity ? -heap[j].first : heap[j].first;
+        labels[q * k + j] = heap[j].second;
+      } else {
+        distances[q * k + j] = farthest;
+        labels[q * k + j] = -1;
+      }
+    }
+  }
+  releaseScanScratch(scratch);
+}
+
+} // namespace detail
+
+template <class Base>
+void scanTopK(int64_t n, const float* x, int64_t d, int metric,
+              int64_t m, Base&& base, int64_t k,
+              float* distances, int64_t* labels) {
+  if (k <= 0) {
+    return;
+  }
+  switch (metric) {
+    case faiss::METRIC_INNER_PRODUCT:
+      detail::scanTopK(n, x, d, true, m, base,
+                       [](const float* a, const float* b, int64_t d) {
+                         return innerProduct(a, b, d);
+                       },
+                       k, distances, labels);
+      break;
+    case kMetricCosine:
+      detail::scanTopK(n, x, d, true, m, base,
+                       [](const float* a, const float* b, int64_t d) {
+                         return cosineSimilarity(a, b, d);
+                       },
+                       k, distances, labels);
+      break;
+    default:
+      detail::scanTopK(n, x, d, false, m, base,
+                       [](const float* a, const float* b, int64_t d) {
+                         return l2Sqr(a, b, d);
+                       },
+                       k, distances, labels);
+      break;
+  }
+}
+
+}  // namespace crystal
@@ -51,6 +51,7 @@ class HashMap {
   std::pair<const_iterator,bool> emplace(const K& key, V&& value);
 
   const_iterator find(const K& key) const;
+  void prefetch(const K& key) const;
   const_iterator cbegin() const;
   const_iterator cend() const;
 
@@ -86,6 +87,11 @@ HashMap<K, V>::find(const K& key) const {
   return map_->find(key);
 }
 
+template <class K, class V>
+inline void HashMap<K, V>::prefetch(const K& key) const {
+  map_->prefetch(key);
+}
+
 template <class K, class V>
 inline typename HashMap<K, V>::const_iterator
 HashMap<K, V>::cbegin() const {
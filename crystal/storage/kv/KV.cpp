@@ -16,7 +16,12 @@
 
 #include "crystal/storage/kv/KV.h"
 
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
 #include "crystal/foundation/Logging.h"
+#include "crystal/foundation/ScopeGuard.h"
 
 namespace crystal {
 
@@ -24,24 +29,74 @@ KV::KV(const KVConfig& config)
     : config_(&config),
       recordMeta_(buildRecordMeta(config.fields())),
       keyMeta_(config.keyConfig().toFieldMeta()),
+      storeType_(config.store()),
       accessor_(recordMeta_),
+      recordAccessor_(recordMeta_, storeType_ == RecordStoreType::kPacked),
+      keyMapType_(config.keyMap()),
       keyIdMap_(config.bucket()),
-      chunkMap_(accessor_.bufferSize()) {
+      swissMap_(config.bucket()),
+      chunkMap_(accessor_.bufferSize()),
+      versionMap_(sizeof(uint32_t)),
+      varChunkMap_(&alloc_),
+      fixedBuf_(accessor_.bufferSize() / sizeof(uint64_t)) {
 }
 
 bool KV::init(MemoryManager* memory) {
+  memory_ = memory;
   if (!alloc_.init(memory->getMemory(MemoryType::kMemRecyc))) {
     CRYSTAL_LOG(ERROR) << "init ml_allocator failed";
     return false;
   }
-  if (!keyIdMap_.init(memory->getMemory(MemoryType::kMemHash))) {
-    CRYSTAL_LOG(ERROR) << "init key-id map failed";
+  Memory* hashMemory = memory->getMemory(MemoryType::kMemHash);
+  readOnly_ = hashMemory->readOnly();
+  bool ok = keyMapType_ == KeyMapType::kSwiss
+    ? swissMap_.init(hashMemory)
+    : keyIdMap_.init(hashMemory);
+  if (!ok) {
+    CRYSTAL_LOG(ERROR) << "init key-id map failed, type="
+        << keyMapTypeToString(keyMapType_);
     return false;
   }
-  if (!chunkMap_.init(memory->getMemory(MemoryType::kMemSimple))) {
-    CRYSTAL_LOG(ERROR) << "init chunk map failed";
+  if (keyMapType_ == KeyMapType::kAtomic &&
+      (!readOnly_ || memory->exists(MemoryType::kMemLookup))) {
+    if (!lookupMap_.init(memory->getMemory(MemoryType::kMemLookup))) {
+      CRYSTAL_LOG(ERROR) << "init lookup map failed";
+      return false;
+    }
+    useLookup_ = readOnly_ && lookupMap_.built();
+  }
+  // frozen, kept so by sync
+  if (memory->exists(MemoryType::kMemPerfect)) {
+    if (!perfectMap_.init(memory->getMemory(MemoryType::kMemPerfect))) {
+      CRYSTAL_LOG(ERROR) << "init perfect hash map failed";
+      return false;
+    }
+    frozen_ = true;
+    usePerfect_ = readOnly_ && perfectMap_.built();
+  }
+  Memory* chunkMemory = memory->getMemory(MemoryType::kMemSimple);
+  ok = storeType_ == RecordStoreType::kPacked
+    ? varChunkMap_.init(chunkMemory)
+    : chunkMap_.init(chunkMemory);
+  if (!ok) {
+    CRYSTAL_LOG(ERROR) << "init chunk map failed, store="
+        << recordStoreTypeToString(storeType_);
     return false;
   }
+  // guard readers against writes of this process, none if read-only
+  if (storeType_ == RecordStoreType::kFixed && !readOnly_) {
+    if (!versionMap_.init(memory->getMemory(MemoryType::kMemVersion)) ||
+        !versionMap_.expand(chunkMap_.size())) {
+      CRYSTAL_LOG(ERROR) << "init version map failed";
+      return false;
+    }
+    // left odd by a write interrupted
+    for (size_t i = 0; i < versionMap_.size(); ++i) {
+      uint32_t* version = reinterpret_cast<uint32_t*>(versionMap_.getChunk(i));
+      *version += *version & 1;
+    }
+    useVersion_ = true;
+  }
   if (!bitMaskMap_.init(memory->getMemory(MemoryType::kMemBit))) {
     CRYSTAL_LOG(ERROR) << "init bitmask map failed";
     return false;
@@ -49,10 +104,107 @@ bool KV::init(MemoryManager* memory) {
   return true;
 }
 
+void KV::sync() {
+  if (readOnly_) {
+    return;
+  }
+  if (keyMapType_ == KeyMapType::kAtomic && !buildLookupMap()) {
+    CRYSTAL_LOG(ERROR) << "build lookup map failed";
+  }
+  if (frozen_ && !buildPerfectMap()) {
+    CRYSTAL_LOG(ERROR) << "build perfect hash map failed";
+  }
+}
+
+bool KV::freeze() {
+  if (frozen_) {
+    return true;
+  }
+  if (readOnly_) {
+    CRYSTAL_LOG(ERROR) << "freeze read-only kv";
+    return false;
+  }
+  if (!perfectMap_.init(memory_->getMemory(MemoryType::kMemPerfect))) {
+    CRYSTAL_LOG(ERROR) << "init perfect hash map failed";
+    return false;
+  }
+  frozen_ = true;
+  return true;
+}
+
+template <class F>
+void KV::forEachKey(F&& f) {
+  if (keyMapType_ == KeyMapType::kSwiss) {
+    swissMap_.forEach(f);
+    return;
+  }
+  for (auto it = keyIdMap_.cbegin(); it != keyIdMap_.cend(); ++it) {
+    f(it->first, it->second.data);
+  }
+}
+
+bool KV::buildLookupMap() {
+  size_t n = 0;
+  for (auto it = keyIdMap_.cbegin(); it != keyIdMap_.cend(); ++it) {
+    ++n;
+  }
+  if (!lookupMap_.rebuild(n)) {
+    return false;
+  }
+  bool ok = true;
+  forEachKey([&](uint64_t key, uint32_t id) {
+    // erased keys
+    if (ok && id != uint32_t(-1)) {
+      ok = lookupMap_.insert(key, id);
+    }
+  });
+  return ok;
+}
+
+bool KV::buildPerfectMap() {
+  std::vector<std::pair<uint64_t, uint32_t>> entries;
+  forEachKey([&](uint64_t key, uint32_t id) {
+    if (id != uint32_t(-1)) {
+      entries.emplace_back(key, id);
+    }
+  });
+  return perfectMap_.build(std::move(entries));
+}
+
+bool KV::writePacked(uint32_t id) {
+  const void* fixedBuf = fixedBuf_.data();
+  return varChunkMap_.write(
+      id, recordAccessor_.packedSize(fixedBuf), [&](void* buf) {
+    recordAccessor_.pack(fixedBuf, buf);
+  });
+}
+
+void KV::beginWrite(uint32_t id) {
+  uint32_t* version = getVersion(id);
+  if (version) {
+    __atomic_store_n(version, *version + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+  }
+}
+
+void KV::endWrite(uint32_t id) {
+  uint32_t* version = getVersion(id);
+  if (version) {
+    __atomic_store_n(version, *version + 1, __ATOMIC_RELEASE);
+  }
+}
+
 bool KV::insert(uint64_t key, uint32_t id) {
-  auto p = keyIdMap_.emplace(key, std::forward<uint32_t>(id));
-  if (!p.second) {
-    p.first->second.data = id;
+  if (keyMapType_ == KeyMapType::kSwiss) {
+    if (!swissMap_.insert(key, id)) {
+      CRYSTAL_LOG(ERROR) << "insert key-id map failed, key=" << key;
+      return false;
+    }
+  } else {
+    auto p = keyIdMap_.emplace(key, std::forward<uint32_t>(id));
+    if (!p.second) {
+      p.first->second.data = id;
+    }
   }
   if (!bitMaskMap_.set(id)) {
     CRYSTAL_LOG(ERROR) << "set bitmask map failed, id=" << id;
@@ -61,7 +213,38 @@ bool KV::insert(uint64_t key, uint32_t id) {
   return true;
 }
 
+void KV::findBatch(const uint64_t* keys, size_t n, uint32_t* ids) {
+  auto prefetch = [&](uint64_t key) {
+    if (usePerfect_) {
+      perfectMap_.prefetch(key);
+    } else if (useLookup_) {
+      lookupMap_.prefetch(key);
+    } else if (keyMapType_ == KeyMapType::kSwiss) {
+      swissMap_.prefetch(key);
+    } else {
+      keyIdMap_.prefetch(key);
+    }
+  };
+  for (size_t i = 0; i < std::min(n, kPrefetchDistance); ++i) {
+    prefetch(keys[i]);
+  }
+  for (size_t i = 0; i < n; ++i) {
+    if (i + kPrefetchDistance < n) {
+      prefetch(keys[i + kPrefetchDistance]);
+    }
+    ids[i] = find(keys[i]);
+    // the record is read when documents are built from the ids
+    if (ids[i] != uint32_t(-1)) {
+      __builtin_prefetch(getRecordPtr(ids[i]));
+    }
+  }
+}
+
 void KV::erase(uint64_t key) {
+  if (keyMapType_ == KeyMapType::kSwiss) {
+    swissMap_.erase(key);
+    return;
+  }
   auto it = keyIdMap_.find(key);
   if (it != keyIdMap_.cend()) {
     it->second.data = -1;
@@ -73,16 +256,43 @@ bool KV::add(uint32_t id, const Record& newRecord) {
     CRYSTAL_LOG(ERROR) << "record id=" << id << " already exist";
     return false;
   }
-  if (id >= chunkMap_.size()) {
-    if (!chunkMap_.expand(id + 1)) {
+  if (storeType_ == RecordStoreType::kPacked) {
+    if (!varChunkMap_.expand(id + 1)) {
       CRYSTAL_LOG(ERROR) << "expand chunk map size to " << id + 1 << " failed";
       return false;
     }
-  }
-  Record record = createRecord(getRecordPtr(id));
-  if (!record.copy(newRecord)) {
-    CRYSTAL_LOG(ERROR) << "copy from newRecord failed, id=" << id;
-    return false;
+    memset(fixedBuf_.data(), 0, accessor_.bufferSize());
+    Record record(&recordMeta_, &accessor_, &alloc_, fixedBuf_.data());
+    if (!record.copy(newRecord)) {
+      CRYSTAL_LOG(ERROR) << "copy from newRecord failed, id=" << id;
+      return false;
+    }
+    if (!writePacked(id)) {
+      CRYSTAL_LOG(ERROR) << "write packed record failed, id=" << id;
+      return false;
+    }
+  } else {
+    if (id >= chunkMap_.size()) {
+      if (!chunkMap_.expand(id + 1)) {
+        CRYSTAL_LOG(ERROR)
+            << "expand chunk map size to " << id + 1 << " failed";
+        return false;
+      }
+    }
+    if (useVersion_ && !versionMap_.expand(chunkMap_.size())) {
+      CRYSTAL_LOG(ERROR)
+          << "expand version map size to " << chunkMap_.size() << " failed";
+      return false;
+    }
+    beginWrite(id);
+    CRYSTAL_SCOPE_EXIT {
+      endWrite(id);
+    };
+    Record record = createRecord(getRecordPtr(id));
+    if (!record.copy(newRecord)) {
+      CRYSTAL_LOG(ERROR) << "copy from newRecord failed, id=" << id;
+      return false;
+    }
   }
   if (!bitMaskMap_.unset(id)) {
     CRYSTAL_LOG(ERROR) << "unset bitmask map failed, id=" << id;
@@ -96,18 +306,28 @@ bool KV::update(uint32_t id, const Record& newRecord) {
     CRYSTAL_LOG(ERROR) << "record id=" << id << " not exist";
     return false;
   }
-  if (!bitMaskMap_.set(id)) {
-    CRYSTAL_LOG(ERROR) << "set bitmask map failed, id=" << id;
-    return false;
-  }
-  Record record = createRecord(getRecordPtr(id));
-  if (!record.merge(newRecord)) {
-    CRYSTAL_LOG(ERROR) << "merge from newRecord failed, id=" << id;
-    return false;
-  }
-  if (!bitMaskMap_.unset(id)) {
-    CRYSTAL_LOG(ERROR) << "unset bitmask map failed, id=" << id;
-    return false;
+  // the record stays existing to readers while updated
+  if (storeType_ == RecordStoreType::kPacked) {
+    recordAccessor_.unpack(getRecordPtr(id), fixedBuf_.data());
+    Record record(&recordMeta_, &accessor_, &alloc_, fixedBuf_.data());
+    if (!record.merge(newRecord)) {
+      CRYSTAL_LOG(ERROR) << "merge from newRecord failed, id=" << id;
+      return false;
+    }
+    if (!writePacked(id)) {
+      CRYSTAL_LOG(ERROR) << "write packed record failed, id=" << id;
+      return false;
+    }
+  } else {
+    beginWrite(id);
+    CRYSTAL_SCOPE_EXIT {
+      endWrite(id);
+    };
+    Record record = createRecord(getRecordPtr(id));
+    if (!record.merge(newRecord)) {
+      CRYSTAL_LOG(ERROR) << "merge from newRecord failed, id=" << id;
+      return false;
+    }
   }
   return true;
 }
@@ -120,25 +340,41 @@ bool KV::remove(uint32_t id) {
     CRYSTAL_LOG(ERROR) << "set bitmask map failed, id=" << id;
     return false;
   }
-  Record record = createRecord(getRecordPtr(id));
-  if (!record.reset()) {
-    CRYSTAL_LOG(ERROR) << "reset record failed, id=" << id;
-    return false;
+  if (storeType_ == RecordStoreType::kPacked) {
+    recordAccessor_.unpack(getRecordPtr(id), fixedBuf_.data());
+    Record record(&recordMeta_, &accessor_, &alloc_, fixedBuf_.data());
+    if (!record.reset()) {
+      CRYSTAL_LOG(ERROR) << "reset record failed, id=" << id;
+      return false;
+    }
+    if (!writePacked(id)) {
+      CRYSTAL_LOG(ERROR) << "write packed record failed, id=" << id;
+      return false;
+    }
+  } else {
+    beginWrite(id);
+    CRYSTAL_SCOPE_EXIT {
+      endWrite(id);
+    };
+    Record record = createRecord(getRecordPtr(id));
+    if (!record.reset()) {
+      CRYSTAL_LOG(ERROR) << "reset record failed, id=" << id;
+      return false;
+    }
   }
   return true;
 }
 
 dynamic KV::serialize() {
   dynamic j = dynamic::object;
-  auto it = keyIdMap_.cbegin();
-  while (it != keyIdMap_.cend()) {
+  auto add = [&](uint64_t key, uint32_t id) {
     Record record = createRecord();
-    getUnsafe(it->second.data, record);
-    j[it->first] = dynamic::object
-        ("id", it->second.data)
+    getUnsafe(id, record);
+    j[key] = dynamic::object
+        ("id", id)
         ("record", record.toDynamic());
-    ++it;
-  }
+  };
+  forEachKey(add);
   return j;
 }
 
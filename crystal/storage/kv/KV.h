@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <thread>
+#include <vector>
+
 #include "crystal/memory/MemoryManager.h"
 #include "crystal/memory/RecycledAllocator.h"
 #include "crystal/serializer/record/Record.h"
@@ -23,11 +26,18 @@
 #include "crystal/storage/kv/FixedChunkMap.h"
 #include "crystal/storage/kv/HashMap.h"
 #include "crystal/storage/kv/KVConfig.h"
+#include "crystal/storage/kv/LookupMap.h"
+#include "crystal/storage/kv/PerfectHashMap.h"
+#include "crystal/storage/kv/SwissMap.h"
+#include "crystal/storage/kv/VarChunkMap.h"
 
 namespace crystal {
 
 class KV {
  public:
+  // keys prefetched ahead of the one being resolved in findBatch
+  static constexpr size_t kPrefetchDistance = 8;
+
   explicit KV(const KVConfig& config);
   virtual ~KV() {}
 
@@ -35,6 +45,10 @@ class KV {
   KV& operator=(const KV&) = delete;
 
   bool init(MemoryManager* memory);
+  // rebuilds the lookup maps of keys, before the memory is dumped
+  void sync();
+  // index keys by a perfect hash map too, found by a read-only kv
+  bool freeze();
 
   const KVConfig& config() const;
   const RecordMeta& recordMeta() const;
@@ -45,7 +59,10 @@ class KV {
    */
 
   uint32_t find(uint64_t key);
+  // find n keys, prefetching hash slots and records of keys ahead
+  void findBatch(const uint64_t* keys, size_t n, uint32_t* ids);
   bool insert(uint64_t key, uint32_t id);
+  // the key is removed from a swiss map, else maps to -1
   void erase(uint64_t key);
 
   /*
@@ -56,9 +73,22 @@ class KV {
 
   Record createRecord(void* buf = nullptr) const;
   void* getRecordPtr(uint32_t id) const;
+  // the record is read in place, a fixed one may be torn by an update
+  // meanwhile: readers of a kv being updated use read()
   bool get(uint32_t id, Record& record) const;
   bool getUnsafe(uint32_t id, Record& record) const;
 
+  /*
+   * Calls f(record) of id while it is not being written, again if it is
+   * updated meanwhile, so f should only read. Records of a packed store
+   * are replaced by updates, not written in place, and are read once;
+   * the replaced ones are recycled after the allocator delay. Values
+   * pointing into a fixed record, as arrays, escape the check: stores
+   * with array fields updated live should be packed.
+   */
+  template <class F>
+  bool read(uint32_t id, F&& f) const;
+
   /*
    * modify
    */
@@ -74,13 +104,47 @@ class KV {
   dynamic serialize();
 
  private:
+  // calls f(key, id) of every key
+  template <class F>
+  void forEachKey(F&& f);
+
+  bool buildLookupMap();
+  bool buildPerfectMap();
+
+  // writes the fixed record of fixedBuf_ packed to id
+  bool writePacked(uint32_t id);
+
+  // seqlock of a fixed record, odd while it is written
+  uint32_t* getVersion(uint32_t id) const;
+  void beginWrite(uint32_t id);
+  void endWrite(uint32_t id);
+
+  MemoryManager* memory_{nullptr};
+  bool readOnly_{false};
   const KVConfig* config_{nullptr};
   RecordMeta recordMeta_;
   FieldMeta keyMeta_;
+  RecordStoreType storeType_;
+  // fixed, records are modified with it
   Accessor accessor_;
+  // of the stored records, packed or fixed
+  Accessor recordAccessor_;
   mutable RecycledAllocator alloc_;
+  KeyMapType keyMapType_;
   HashMap<uint64_t, uint32_t> keyIdMap_;
+  SwissMap<uint64_t, uint32_t> swissMap_;
+  // read-only copy of keyIdMap_, used when the kv is read-only
+  LookupMap<uint64_t, uint32_t> lookupMap_;
+  bool useLookup_{false};
+  PerfectHashMap perfectMap_;
+  bool frozen_{false};
+  bool usePerfect_{false};
   FixedChunkMap chunkMap_;
+  FixedChunkMap versionMap_;
+  bool useVersion_{false};
+  VarChunkMap varChunkMap_;
+  // a record of the fixed layout, packed records are modified in it
+  std::vector<uint64_t> fixedBuf_;
   BitMaskMap bitMaskMap_;
 };
 
@@ -99,19 +163,38 @@ inline const FieldMeta& KV::keyMeta() const {
 }
 
 inline uint32_t KV::find(uint64_t key) {
+  if (usePerfect_) {
+    uint32_t id;
+    return perfectMap_.find(key, &id) ? id : -1;
+  }
+  if (useLookup_) {
+    uint32_t id;
+    return lookupMap_.find(key, &id) ? id : -1;
+  }
+  if (keyMapType_ == KeyMapType::kSwiss) {
+    uint32_t id;
+    return swissMap_.find(key, &id) ? id : -1;
+  }
   auto it = keyIdMap_.find(key);
   return it != keyIdMap_.cend() ? it->second.data : -1;
 }
 
 inline bool KV::exist(uint32_t id) const {
-  return id < chunkMap_.size() && !bitMaskMap_.isSet(id);
+  size_t size = storeType_ == RecordStoreType::kPacked
+    ? varChunkMap_.size()
+    : chunkMap_.size();
+  return id < size && !bitMaskMap_.isSet(id);
 }
 
 inline Record KV::createRecord(void* buf) const {
-  return Record(&recordMeta_, &accessor_, &alloc_, buf);
+  return Record(&recordMeta_, &recordAccessor_, &alloc_, buf);
 }
 
 inline void* KV::getRecordPtr(uint32_t id) const {
+  if (storeType_ == RecordStoreType::kPacked) {
+    void* ptr = varChunkMap_.getChunk(id);
+    return ptr ? ptr : const_cast<void*>(recordAccessor_.defaultBuffer());
+  }
   return chunkMap_.getChunk(id);
 }
 
@@ -128,4 +211,37 @@ inline bool KV::getUnsafe(uint32_t id, Record& record) const {
   return true;
 }
 
+template <class F>
+bool KV::read(uint32_t id, F&& f) const {
+  if (!exist(id)) {
+    return false;
+  }
+  Record record = createRecord();
+  uint32_t* version = getVersion(id);
+  if (!version) {
+    record.setBuffer(getRecordPtr(id));
+    f(record);
+    return true;
+  }
+  while (true) {
+    uint32_t v = __atomic_load_n(version, __ATOMIC_ACQUIRE);
+    if (v & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    record.setBuffer(getRecordPtr(id));
+    f(record);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(version, __ATOMIC_RELAXED) == v) {
+      return true;
+    }
+  }
+}
+
+inline uint32_t* KV::getVersion(uint32_t id) const {
+  return useVersion_ && id < versionMap_.size()
+    ? reinterpret_cast<uint32_t*>(versionMap_.getChunk(id))
+    : nullptr;
+}
+
 }  // namespace crystal
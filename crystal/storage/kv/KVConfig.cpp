@@ -40,12 +40,16 @@ bool KVConfig::parse(
   }
   keyConfig_ = it->second;
   DataType keyType = it->second.type();
-  if (!isIntegral(keyType) && !isString(keyType)) {
+  if (!supportKeyType(keyType)) {
     CRYSTAL_LOG(ERROR) << "unsupport key type: " << dataTypeToString(keyType);
     return false;
   }
   strategy_ = stringToStrategyType(
       root.getDefault("strategy", "default").getString().c_str());
+  keyMap_ = stringToKeyMapType(
+      root.getDefault("map", "atomic").getString().c_str());
+  store_ = stringToRecordStoreType(
+      root.getDefault("store", "fixed").getString().c_str());
   bucket_ = root.getDefault("bucket", kBucketSize).getInt();
   segment_ = root.getDefault("segment", 1).getInt();
   auto value = root.getDefault(valueName);
@@ -96,10 +100,22 @@ const RecordConfig& KVConfig::fields() const {
   return fields_;
 }
 
+bool KVConfig::supportKeyType(DataType type) const {
+  return isIntegral(type) || isString(type);
+}
+
 StrategyType KVConfig::strategy() const {
   return strategy_;
 }
 
+KeyMapType KVConfig::keyMap() const {
+  return keyMap_;
+}
+
+RecordStoreType KVConfig::store() const {
+  return store_;
+}
+
 size_t KVConfig::bucket() const {
   return bucket_;
 }
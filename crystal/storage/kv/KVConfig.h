@@ -20,6 +20,8 @@
 #include <string>
 
 #include "crystal/serializer/record/RecordConfig.h"
+#include "crystal/storage/kv/KeyMapType.h"
+#include "crystal/storage/kv/RecordStoreType.h"
 #include "crystal/strategy/StrategyType.h"
 
 namespace crystal {
@@ -36,6 +38,8 @@ class KVConfig {
   const FieldConfig& keyConfig() const;
   const RecordConfig& fields() const;
   StrategyType strategy() const;
+  KeyMapType keyMap() const;
+  RecordStoreType store() const;
   size_t bucket() const;
   uint16_t segment() const;
 
@@ -45,6 +49,8 @@ class KVConfig {
              const std::string& valueName,
              bool valueIsOptional);
 
+  virtual bool supportKeyType(DataType type) const;
+
  private:
   static constexpr size_t kBucketSize = 1ul << 24;
 
@@ -53,6 +59,8 @@ class KVConfig {
   FieldConfig keyConfig_;
   RecordConfig fields_;
   StrategyType strategy_{StrategyType::kDefault};
+  KeyMapType keyMap_{KeyMapType::kAtomic};
+  RecordStoreType store_{RecordStoreType::kFixed};
   size_t bucket_{kBucketSize};
   uint16_t segment_{1};
 };
@@ -0,0 +1,46 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "crystal/storage/kv/KeyMapType.h"
+
+#include <iterator>
+#include <strings.h>
+
+namespace crystal {
+
+#define CRYSTAL_KEY_MAP_TYPE_STR(type) #type
+
+static const char* sKeyMapTypeStrings[] = {
+  CRYSTAL_KEY_MAP_TYPE_GEN(CRYSTAL_KEY_MAP_TYPE_STR)
+};
+
+#undef CRYSTAL_KEY_MAP_TYPE_STR
+
+const char* keyMapTypeToString(KeyMapType type) {
+  return sKeyMapTypeStrings[static_cast<int>(type)];
+}
+
+KeyMapType stringToKeyMapType(const char* str) {
+  size_t n = std::size(sKeyMapTypeStrings);
+  for (size_t i = 0; i < n; ++i) {
+    if (strcasecmp(str, sKeyMapTypeStrings[i]) == 0) {
+      return static_cast<KeyMapType>(i);
+    }
+  }
+  return KeyMapType::kAtomic;
+}
+
+} // namespace crystal
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstring>
+#include <functional>
+#include <type_traits>
+
+#include "crystal/foundation/Bits.h"
+#include "crystal/foundation/Hash.h"
+#include "crystal/foundation/Logging.h"
+#include "crystal/memory/Memory.h"
+#include "crystal/storage/kv/detail/GroupMatch.h"
+
+namespace crystal {
+
+/*
+ * Read-only hash map laid out for lookup, rebuilt from a writable map
+ * when it is dumped. Slots are grouped by 16 with their keys and values
+ * inline after the group's control bytes, which hold 7 bits of the key
+ * hash and are matched by one SIMD compare, so a lookup mostly reads
+ * the group head and the matched slot: one or two cache lines instead
+ * of a cache miss per chain hop.
+ */
+template <class K, class V>
+class LookupMap {
+  static_assert(std::is_trivially_copyable<K>::value &&
+                std::is_trivially_copyable<V>::value,
+                "LookupMap needs trivially copyable key and value");
+
+ public:
+  static constexpr size_t kGroupSize = detail::kGroupSize;
+
+  LookupMap() {}
+  virtual ~LookupMap() {}
+
+  LookupMap(const LookupMap&) = delete;
+  LookupMap& operator=(const LookupMap&) = delete;
+
+  bool init(Memory* memory);
+
+  // true if the memory holds a built map
+  bool built() const;
+
+  bool find(const K& key, V* value) const;
+  void prefetch(const K& key) const;
+
+  size_t size() const;
+
+  // drops the map and allocates an empty one for n keys
+  bool rebuild(size_t n);
+  // insert or assign, at most n keys after rebuild(n)
+  bool insert(const K& key, const V& value);
+
+ private:
+  static constexpr int8_t kEmpty = -128;
+  static constexpr uint64_t kMagic = 0x4c4f4f4b55504d50ull;
+
+  struct Slot {
+    K key;
+    V value;
+  };
+
+  struct Group {
+    int8_t ctrl[kGroupSize];
+    Slot slots[kGroupSize];
+  };
+
+  // takes a cache line, so groups start at one
+  struct alignas(64) Root {
+    uint64_t magic;
+    uint64_t groups;
+    uint64_t size;
+  };
+
+  static uint64_t hash(const K& key);
+
+  Group* group(uint64_t h) const;
+  Slot* lookup(const K& key, uint64_t h) const;
+
+  Memory* memory_{nullptr};
+  Root* root_{nullptr};
+  Group* groups_{nullptr};
+  uint64_t mask_{0};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+template <class K, class V>
+inline uint64_t LookupMap<K, V>::hash(const K& key) {
+  return hash_128_to_64(kMagic, std::hash<K>()(key));
+}
+
+template <class K, class V>
+bool LookupMap<K, V>::init(Memory* memory) {
+  memory_ = memory;
+  root_ = nullptr;
+  if (memory->getAllocatedSize() == 0) {
+    return true;
+  }
+  Root* root = reinterpret_cast<Root*>(memory->address(kMemStart));
+  if (root->magic != kMagic ||
+      memory->getAllocatedSize() <
+      sizeof(Root) + root->groups * sizeof(Group)) {
+    CRYSTAL_LOG(ERROR) << "invalid lookup map memory";
+    return false;
+  }
+  root_ = root;
+  groups_ = reinterpret_cast<Group*>(root_ + 1);
+  mask_ = root_->groups - 1;
+  return true;
+}
+
+template <class K, class V>
+inline bool LookupMap<K, V>::built() const {
+  return root_ != nullptr;
+}
+
+template <class K, class V>
+inline typename LookupMap<K, V>::Group*
+LookupMap<K, V>::group(uint64_t h) const {
+  return groups_ + ((h >> 7) & mask_);
+}
+
+template <class K, class V>
+inline typename LookupMap<K, V>::Slot*
+LookupMap<K, V>::lookup(const K& key, uint64_t h) const {
+  int8_t h2 = h & 0x7f;
+  uint64_t g = (h >> 7) & mask_;
+  for (uint64_t step = 1; step <= mask_ + 1; ++step) {
+    Group* group = groups_ + g;
+    uint32_t match = detail::matchGroup(group->ctrl, h2);
+    while (match) {
+      Slot* slot = &group->slots[__builtin_ctz(match)];
+      if (slot->key == key) {
+        return slot;
+      }
+      match &= match - 1;
+    }
+    if (detail::matchGroup(group->ctrl, kEmpty)) {
+      return nullptr;
+    }
+    g = (g + step) & mask_;
+  }
+  return nullptr;
+}
+
+template <class K, class V>
+inline bool LookupMap<K, V>::find(const K& key, V* value) const {
+  if (!root_) {
+    return false;
+  }
+  Slot* slot = lookup(key, hash(key));
+  if (!slot) {
+    return false;
+  }
+  *value = slot->value;
+  return true;
+}
+
+template <class K, class V>
+inline void LookupMap<K, V>::prefetch(const K& key) const {
+  if (root_) {
+    __builtin_prefetch(group(hash(key)));
+  }
+}
+
+template <class K, class V>
+inline size_t LookupMap<K, V>::size() const {
+  return root_ ? root_->size : 0;
+}
+
+template <class K, class V>
+bool LookupMap<K, V>::rebuild(size_t n) {
+  if (!memory_ || memory_->readOnly()) {
+    return false;
+  }
+  root_ = nullptr;
+  if (!memory_->reset()) {
+    return false;
+  }
+  // at most 7/8 full, so every probe ends at an empty slot
+  size_t groups = nextPowTwo(
+      std::max(size_t(1), (n * 8 / 7 + kGroupSize) / kGroupSize));
+  int64_t offset = memory_->allocate(sizeof(Root) + groups * sizeof(Group));
+  if (offset == 0) {
+    CRYSTAL_LOG(ERROR) << "allocate lookup map failed, groups=" << groups;
+    return false;
+  }
+  root_ = reinterpret_cast<Root*>(memory_->address(offset));
+  root_->magic = kMagic;
+  root_->groups = groups;
+  root_->size = 0;
+  groups_ = reinterpret_cast<Group*>(root_ + 1);
+  mask_ = groups - 1;
+  for (size_t i = 0; i < groups; ++i) {
+    memset(groups_[i].ctrl, kEmpty, kGroupSize);
+  }
+  return true;
+}
+
+template <class K, class V>
+bool LookupMap<K, V>::insert(const K& key, const V& value) {
+  if (!root_ || memory_->readOnly()) {
+    return false;
+  }
+  uint64_t h = hash(key);
+  Slot* slot = lookup(key, h);
+  if (slot) {
+    slot->value = value;
+    return true;
+  }
+  if ((root_->size + 1) * 8 > (mask_ + 1) * kGroupSize * 7) {
+    CRYSTAL_LOG(ERROR) << "lookup map is full, size=" << root_->size;
+    return false;
+  }
+  uint64_t g = (h >> 7) & mask_;
+  for (uint64_t step = 1; ; ++step) {
+    Group* group = groups_ + g;
+    uint32_t empty = detail::matchGroup(group->ctrl, kEmpty);
+    if (empty) {
+      size_t i = __builtin_ctz(empty);
+      group->slots[i].key = key;
+      group->slots[i].value = value;
+      group->ctrl[i] = h & 0x7f;
+      ++root_->size;
+      return true;
+    }
+    g = (g + step) & mask_;
+  }
+}
+
+} // namespace crystal
@@ -0,0 +1,155 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "crystal/storage/kv/PerfectHashMap.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "crystal/foundation/Logging.h"
+
+namespace crystal {
+
+bool PerfectHashMap::init(Memory* memory) {
+  memory_ = memory;
+  root_ = nullptr;
+  if (memory->getAllocatedSize() == 0) {
+    return true;
+  }
+  Root* root = reinterpret_cast<Root*>(memory->address(kMemStart));
+  if (root->magic != kMagic || root->levels > kMaxLevels) {
+    CRYSTAL_LOG(ERROR) << "invalid perfect hash map memory";
+    return false;
+  }
+  attach(root);
+  return true;
+}
+
+void PerfectHashMap::attach(Root* root) {
+  root_ = root;
+  blocks_ = reinterpret_cast<const Block*>(root + 1);
+  entries_ = reinterpret_cast<const Entry*>(
+      blocks_ + root->levelBlocks[root->levels]);
+  fallbacks_ = reinterpret_cast<const Fallback*>(
+      entries_ + (root->size - root->fallbacks));
+}
+
+bool PerfectHashMap::build(
+    std::vector<std::pair<uint64_t, uint32_t>> entries) {
+  if (!memory_ || memory_->readOnly()) {
+    return false;
+  }
+  std::sort(entries.begin(), entries.end());
+  entries.erase(
+      std::unique(entries.begin(), entries.end(),
+                  [](const auto& a, const auto& b) {
+                    return a.first == b.first;
+                  }),
+      entries.end());
+  size_t size = entries.size();
+
+  std::vector<Block> blocks;
+  std::vector<Entry> placed(size);
+  std::vector<uint64_t> levelBlocks = {0};
+  std::vector<std::pair<uint64_t, uint32_t>> next;
+  uint64_t rank = 0;
+  for (size_t level = 0; level < kMaxLevels && !entries.empty(); ++level) {
+    size_t n = (entries.size() * kGamma + kBlockBits - 1) / kBlockBits;
+    uint64_t bits = n * kBlockBits;
+    std::vector<uint64_t> seen(bits / 64), collided(bits / 64);
+    for (auto& e : entries) {
+      uint64_t p = position(e.first, level, bits);
+      uint64_t mask = uint64_t(1) << (p % 64);
+      if (seen[p / 64] & mask) {
+        collided[p / 64] |= mask;
+      } else {
+        seen[p / 64] |= mask;
+      }
+    }
+    size_t first = blocks.size();
+    blocks.resize(first + n);
+    for (size_t i = 0; i < n; ++i) {
+      Block& block = blocks[first + i];
+      block.rank = rank;
+      for (size_t j = 0; j < kBlockBits / 64; ++j) {
+        size_t w = i * (kBlockBits / 64) + j;
+        block.bits[j] = seen[w] & ~collided[w];
+        rank += popcount(block.bits[j]);
+      }
+    }
+    next.clear();
+    for (auto& e : entries) {
+      uint64_t p = position(e.first, level, bits);
+      uint64_t index;
+      if (testBit(blocks[first + p / kBlockBits], p % kBlockBits, &index)) {
+        placed[index] = Entry{e.second, fingerprint(e.first)};
+      } else {
+        next.push_back(e);
+      }
+    }
+    entries.swap(next);
+    levelBlocks.push_back(blocks.size());
+  }
+
+  // the keys left stay sorted
+  size_t bytes = sizeof(Root) + blocks.size() * sizeof(Block) +
+    rank * sizeof(Entry) + entries.size() * sizeof(Fallback);
+  root_ = nullptr;
+  if (!memory_->reset()) {
+    return false;
+  }
+  int64_t offset = memory_->allocate(bytes);
+  if (offset == 0) {
+    CRYSTAL_LOG(ERROR) << "allocate perfect hash map failed, size=" << bytes;
+    return false;
+  }
+  Root* root = reinterpret_cast<Root*>(memory_->address(offset));
+  memset(reinterpret_cast<void*>(root), 0, sizeof(Root));
+  root->magic = kMagic;
+  root->size = size;
+  root->levels = levelBlocks.size() - 1;
+  root->fallbacks = entries.size();
+  std::copy(levelBlocks.begin(), levelBlocks.end(), root->levelBlocks);
+  attach(root);
+  memcpy(const_cast<Block*>(blocks_), blocks.data(),
+         blocks.size() * sizeof(Block));
+  memcpy(const_cast<Entry*>(entries_), placed.data(), rank * sizeof(Entry));
+  Fallback* fallbacks = const_cast<Fallback*>(fallbacks_);
+  for (size_t i = 0; i < entries.size(); ++i) {
+    fallbacks[i] = Fallback{entries[i].first, entries[i].second};
+  }
+  if (!entries.empty()) {
+    CRYSTAL_LOG(WARN) << "perfect hash map keeps " << entries.size()
+        << " keys of " << size << " sorted";
+  }
+  return true;
+}
+
+bool PerfectHashMap::findFallback(uint64_t key, uint32_t* id) const {
+  const Fallback* begin = fallbacks_;
+  const Fallback* end = fallbacks_ + root_->fallbacks;
+  auto it = std::lower_bound(
+      begin, end, key,
+      [](const Fallback& f, uint64_t k) { return f.key < k; });
+  if (it == end || it->key != key) {
+    return false;
+  }
+  *id = it->id;
+  return true;
+}
+
+}  // namespace crystal
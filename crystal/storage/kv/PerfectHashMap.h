@@ -0,0 +1,171 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "crystal/foundation/Bits.h"
+#include "crystal/foundation/Hash.h"
+#include "crystal/memory/Memory.h"
+
+namespace crystal {
+
+/*
+ * Frozen key -> id map of a read-only KV, built offline.
+ *
+ * Keys are indexed by a minimal perfect hash (BBHash): each level is a
+ * bit array of kGamma bits per key left, where the keys alone on their
+ * bit set it and the colliding keys go to the next level. The index of
+ * a key is the rank of its bit, counted in 64 byte blocks holding the
+ * rank before them and 448 bits, so a level is resolved in one cache
+ * line. About 3.5 bits per key, plus an entry of the id and a 32-bit
+ * fingerprint of the key, which tells absent keys with a false positive
+ * rate of 2^-32. Keys left after kMaxLevels are kept sorted.
+ */
+class PerfectHashMap {
+ public:
+  static constexpr size_t kGamma = 2;
+  static constexpr size_t kMaxLevels = 32;
+
+  PerfectHashMap() {}
+  virtual ~PerfectHashMap() {}
+
+  PerfectHashMap(const PerfectHashMap&) = delete;
+  PerfectHashMap& operator=(const PerfectHashMap&) = delete;
+
+  bool init(Memory* memory);
+
+  // true if the memory holds a built map
+  bool built() const;
+
+  // replaces the map by one of the distinct keys of entries
+  bool build(std::vector<std::pair<uint64_t, uint32_t>> entries);
+
+  bool find(uint64_t key, uint32_t* id) const;
+  void prefetch(uint64_t key) const;
+
+  size_t size() const;
+
+ private:
+  static constexpr uint64_t kMagic = 0x5045524648415348ull;
+  static constexpr size_t kBlockBits = 448;
+
+  struct alignas(64) Block {
+    uint64_t rank;
+    uint64_t bits[kBlockBits / 64];
+  };
+
+  struct Entry {
+    uint32_t id;
+    uint32_t fingerprint;
+  };
+
+  struct Fallback {
+    uint64_t key;
+    uint32_t id;
+  };
+
+  struct alignas(64) Root {
+    uint64_t magic;
+    uint64_t size;
+    uint64_t levels;
+    uint64_t fallbacks;
+    // first block of every level, and the end of the last one
+    uint64_t levelBlocks[kMaxLevels + 1];
+  };
+
+  static uint64_t position(uint64_t key, size_t level, uint64_t bits);
+  static uint32_t fingerprint(uint64_t key);
+  // true if the bit is set, with the rank of set bits before it
+  static bool testBit(const Block& block, size_t bit, uint64_t* rank);
+
+  void attach(Root* root);
+  bool findFallback(uint64_t key, uint32_t* id) const;
+
+  Memory* memory_{nullptr};
+  Root* root_{nullptr};
+  const Block* blocks_{nullptr};
+  const Entry* entries_{nullptr};
+  const Fallback* fallbacks_{nullptr};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline uint64_t
+PerfectHashMap::position(uint64_t key, size_t level, uint64_t bits) {
+  uint64_t h = hash_128_to_64(kMagic + level, key);
+  return static_cast<uint64_t>((__uint128_t(h) * bits) >> 64);
+}
+
+inline uint32_t PerfectHashMap::fingerprint(uint64_t key) {
+  return hash_128_to_64(key, kMagic) >> 32;
+}
+
+inline bool
+PerfectHashMap::testBit(const Block& block, size_t bit, uint64_t* rank) {
+  size_t word = bit / 64;
+  uint64_t mask = uint64_t(1) << (bit % 64);
+  if (!(block.bits[word] & mask)) {
+    return false;
+  }
+  *rank = block.rank + popcount(block.bits[word] & (mask - 1));
+  for (size_t i = 0; i < word; ++i) {
+    *rank += popcount(block.bits[i]);
+  }
+  return true;
+}
+
+inline bool PerfectHashMap::built() const {
+  return root_ != nullptr;
+}
+
+inline size_t PerfectHashMap::size() const {
+  return root_ ? root_->size : 0;
+}
+
+inline bool PerfectHashMap::find(uint64_t key, uint32_t* id) const {
+  if (!root_) {
+    return false;
+  }
+  for (size_t level = 0; level < root_->levels; ++level) {
+    uint64_t first = root_->levelBlocks[level];
+    uint64_t bits = (root_->levelBlocks[level + 1] - first) * kBlockBits;
+    uint64_t p = position(key, level, bits);
+    uint64_t rank;
+    if (testBit(blocks_[first + p / kBlockBits], p % kBlockBits, &rank)) {
+      const Entry& entry = entries_[rank];
+      if (entry.fingerprint != fingerprint(key)) {
+        return false;
+      }
+      *id = entry.id;
+      return true;
+    }
+  }
+  return findFallback(key, id);
+}
+
+inline void PerfectHashMap::prefetch(uint64_t key) const {
+  if (root_ && root_->levels > 0) {
+    uint64_t bits = root_->levelBlocks[1] * kBlockBits;
+    __builtin_prefetch(&blocks_[position(key, 0, bits) / kBlockBits]);
+  }
+}
+
+}  // namespace crystal
@@ -0,0 +1,38 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+namespace crystal {
+
+// the storage of KV records
+#define CRYSTAL_RECORD_STORE_TYPE_GEN(x)  \
+  x(Fixed),                               \
+  x(Packed)
+
+#define CRYSTAL_RECORD_STORE_TYPE_ENUM(type) k##type
+
+enum class RecordStoreType {
+  CRYSTAL_RECORD_STORE_TYPE_GEN(CRYSTAL_RECORD_STORE_TYPE_ENUM)
+};
+
+#undef CRYSTAL_RECORD_STORE_TYPE_ENUM
+
+const char* recordStoreTypeToString(RecordStoreType type);
+
+RecordStoreType stringToRecordStoreType(const char* str);
+
+} // namespace crystal
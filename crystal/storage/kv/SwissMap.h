@@ -0,0 +1,508 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <type_traits>
+
+#include "crystal/foundation/Bits.h"
+#include "crystal/foundation/Hash.h"
+#include "crystal/foundation/Logging.h"
+#include "crystal/memory/Memory.h"
+#include "crystal/storage/kv/detail/GroupMatch.h"
+
+namespace crystal {
+
+/*
+ * Open addressing hash map resident in mmap memory, with SwissTable
+ * style control bytes: slots are probed in groups of 16 whose control
+ * bytes hold 7 bits of the hash, and are compared to the key hash by
+ * one SIMD compare.
+ *
+ * Single writer, lock-free readers. A slot is written once per table:
+ * the key and value are stored before its control byte is published,
+ * values are updated atomically and erased slots become tombstones.
+ * When the table is too full of keys or tombstones, a new table sized
+ * for the live keys is created and the old one is migrated a few
+ * groups per write, readers looking up both meanwhile. The tables are
+ * swapped under a seqlock and a retired table is not reused within
+ * kRetireDelay seconds, so readers never block nor see freed memory.
+ */
+template <class K, class V>
+class SwissMap {
+  static_assert(std::is_trivially_copyable<K>::value &&
+                std::is_trivially_copyable<V>::value,
+                "SwissMap needs trivially copyable key and value");
+
+ public:
+  static constexpr size_t kGroupSize = detail::kGroupSize;
+  // groups of the old table migrated by every write
+  static constexpr size_t kMigrateGroups = 4;
+  static constexpr uint32_t kRetireDelay = 10;
+
+  // the initial capacity is a hint, tables grow and shrink as needed
+  explicit SwissMap(size_t capacity = 0)
+      : minGroups_(groupsFor(capacity)) {}
+
+  virtual ~SwissMap() {}
+
+  SwissMap(const SwissMap&) = delete;
+  SwissMap& operator=(const SwissMap&) = delete;
+
+  bool init(Memory* memory);
+
+  bool find(const K& key, V* value) const;
+  void prefetch(const K& key) const;
+
+  // insert or assign, false if out of memory
+  bool insert(const K& key, const V& value);
+  bool erase(const K& key);
+
+  size_t size() const;
+  size_t capacity() const;
+  bool migrating() const;
+
+  // calls f(key, value) of every key, not safe with a concurrent writer
+  template <class F>
+  void forEach(F&& f) const;
+
+ private:
+  static constexpr int8_t kEmpty = -128;
+  static constexpr int8_t kDeleted = -2;
+  static constexpr uint64_t kMagic = 0x53574953534d4150ull;
+
+  struct Slot {
+    K key;
+    V value;
+  };
+
+  struct TableRef {
+    int64_t offset{0};
+    uint64_t groups{0};
+  };
+
+  struct Root {
+    uint64_t magic;
+    // odd while tables are being swapped
+    std::atomic<uint64_t> seq;
+    // current table, and the old one being migrated or none
+    TableRef tables[2];
+    // writer only
+    uint64_t cursor;
+    uint64_t size;
+    uint64_t used;
+    // retired tables by log2 of groups, linked by their Retired header
+    int64_t retired[64];
+  };
+
+  // heads every table, apart from the control bytes still probed by
+  // readers after the table is retired
+  struct Retired {
+    int64_t next;
+    uint32_t time;
+  };
+
+  struct Table {
+    int8_t* ctrl{nullptr};
+    Slot* slots{nullptr};
+    uint64_t mask{0};
+
+    explicit operator bool() const { return ctrl != nullptr; }
+    size_t capacity() const { return (mask + 1) * kGroupSize; }
+  };
+
+  static size_t groupsFor(size_t n);
+  static size_t tableBytes(size_t groups);
+  static uint64_t hash(const K& key);
+
+  Table table(const TableRef& ref) const;
+  void snapshot(Table* current, Table* old) const;
+
+  // index of the key in the table, or -1
+  int64_t lookup(const Table& t, const K& key, uint64_t h) const;
+  void place(const Table& t, const K& key, const V& value, uint64_t h);
+
+  // a table for the keys and the inserts while migrating to it
+  size_t groupsToMigrate(size_t keys) const;
+  bool startMigration(size_t keys);
+  void migrate(size_t groups);
+  void publish(TableRef current, TableRef old);
+
+  int64_t allocateTable(size_t groups);
+  void retireTable(const TableRef& ref);
+
+  Memory* memory_{nullptr};
+  Root* root_{nullptr};
+  size_t minGroups_;
+};
+
+//////////////////////////////////////////////////////////////////////
+
+template <class K, class V>
+inline size_t SwissMap<K, V>::groupsFor(size_t n) {
+  // at most half full after a resize
+  return nextPowTwo(std::max(size_t(1), (n * 2 + kGroupSize - 1) / kGroupSize));
+}
+
+template <class K, class V>
+inline size_t SwissMap<K, V>::tableBytes(size_t groups) {
+  return sizeof(Retired) + groups * kGroupSize * (1 + sizeof(Slot)) +
+    alignof(Slot);
+}
+
+template <class K, class V>
+inline uint64_t SwissMap<K, V>::hash(const K& key) {
+  return hash_128_to_64(kMagic, std::hash<K>()(key));
+}
+
+template <class K, class V>
+bool SwissMap<K, V>::init(Memory* memory) {
+  memory_ = memory;
+  if (memory->getAllocatedSize() == 0) {
+    if (memory->readOnly()) {
+      // nothing was written, an empty map
+      return true;
+    }
+    int64_t offset = memory->allocate(sizeof(Root));
+    if (offset == 0) {
+      return false;
+    }
+    root_ = reinterpret_cast<Root*>(memory->address(offset));
+    memset(reinterpret_cast<void*>(root_), 0, sizeof(Root));
+    root_->magic = kMagic;
+    TableRef ref;
+    ref.groups = minGroups_;
+    ref.offset = allocateTable(ref.groups);
+    if (ref.offset == 0) {
+      return false;
+    }
+    publish(ref, TableRef());
+    return true;
+  }
+  root_ = reinterpret_cast<Root*>(memory->address(kMemStart));
+  if (root_->magic != kMagic) {
+    CRYSTAL_LOG(ERROR) << "invalid swiss map memory";
+    root_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+template <class K, class V>
+inline typename SwissMap<K, V>::Table
+SwissMap<K, V>::table(const TableRef& ref) const {
+  Table t;
+  if (ref.offset != 0) {
+    uint8_t* p = reinterpret_cast<uint8_t*>(memory_->address(ref.offset)) +
+      sizeof(Retired);
+    size_t n = ref.groups * kGroupSize;
+    t.ctrl = reinterpret_cast<int8_t*>(p);
+    uintptr_t slots = reinterpret_cast<uintptr_t>(p + n);
+    slots = (slots + alignof(Slot) - 1) & ~uintptr_t(alignof(Slot) - 1);
+    t.slots = reinterpret_cast<Slot*>(slots);
+    t.mask = ref.groups - 1;
+  }
+  return t;
+}
+
+template <class K, class V>
+inline void SwissMap<K, V>::snapshot(Table* current, Table* old) const {
+  TableRef refs[2];
+  uint64_t seq;
+  do {
+    seq = root_->seq.load(std::memory_order_acquire);
+    refs[0] = root_->tables[0];
+    refs[1] = root_->tables[1];
+    std::atomic_thread_fence(std::memory_order_acquire);
+  } while ((seq & 1) || seq != root_->seq.load(std::memory_order_relaxed));
+  *current = table(refs[0]);
+  *old = table(refs[1]);
+}
+
+template <class K, class V>
+void SwissMap<K, V>::publish(TableRef current, TableRef old) {
+  uint64_t seq = root_->seq.load(std::memory_order_relaxed);
+  root_->seq.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  root_->tables[0] = current;
+  root_->tables[1] = old;
+  root_->seq.store(seq + 2, std::memory_order_release);
+}
+
+template <class K, class V>
+int64_t SwissMap<K, V>::lookup(
+    const Table& t, const K& key, uint64_t h) const {
+  int8_t h2 = h & 0x7f;
+  uint64_t g = (h >> 7) & t.mask;
+  for (uint64_t step = 1; step <= t.mask + 1; ++step) {
+    const int8_t* group = t.ctrl + g * kGroupSize;
+    uint32_t match = detail::matchGroup(group, h2);
+    // slots are read after their published control bytes
+    std::atomic_thread_fence(std::memory_order_acquire);
+    while (match) {
+      size_t i = g * kGroupSize + __builtin_ctz(match);
+      if (t.slots[i].key == key) {
+        return i;
+      }
+      match &= match - 1;
+    }
+    if (detail::matchGroup(group, kEmpty)) {
+      return -1;
+    }
+    // triangular probing visits every group of a power of 2 table
+    g = (g + step) & t.mask;
+  }
+  return -1;
+}
+
+template <class K, class V>
+void SwissMap<K, V>::place(
+    const Table& t, const K& key, const V& value, uint64_t h) {
+  uint64_t g = (h >> 7) & t.mask;
+  for (uint64_t step = 1; ; ++step) {
+    int8_t* group = t.ctrl + g * kGroupSize;
+    uint32_t empty = detail::matchGroup(group, kEmpty);
+    if (empty) {
+      size_t i = g * kGroupSize + __builtin_ctz(empty);
+      t.slots[i].key = key;
+      t.slots[i].value = value;
+      __atomic_store_n(&t.ctrl[i], int8_t(h & 0x7f), __ATOMIC_RELEASE);
+      return;
+    }
+    g = (g + step) & t.mask;
+  }
+}
+
+template <class K, class V>
+bool SwissMap<K, V>::find(const K& key, V* value) const {
+  if (!root_) {
+    return false;
+  }
+  Table current, old;
+  snapshot(&current, &old);
+  uint64_t h = hash(key);
+  for (const Table* t : {&current, &old}) {
+    if (*t) {
+      int64_t i = lookup(*t, key, h);
+      if (i >= 0) {
+        __atomic_load(&t->slots[i].value, value, __ATOMIC_ACQUIRE);
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+template <class K, class V>
+inline void SwissMap<K, V>::prefetch(const K& key) const {
+  if (root_) {
+    Table t = table(root_->tables[0]);
+    __builtin_prefetch(t.ctrl + ((hash(key) >> 7) & t.mask) * kGroupSize);
+  }
+}
+
+template <class K, class V>
+bool SwissMap<K, V>::insert(const K& key, const V& value) {
+  if (!root_ || memory_->readOnly()) {
+    return false;
+  }
+  migrate(kMigrateGroups);
+  Table current, old;
+  snapshot(&current, &old);
+  uint64_t h = hash(key);
+  int64_t i = lookup(current, key, h);
+  if (i >= 0) {
+    __atomic_store(&current.slots[i].value,
+                   const_cast<V*>(&value), __ATOMIC_RELEASE);
+    return true;
+  }
+  // updated keys of the old table are shadowed by the current one
+  if (!old || lookup(old, key, h) < 0) {
+    ++root_->size;
+  }
+  if ((root_->used + 1) * 8 > current.capacity() * 7) {
+    if (!startMigration(root_->size)) {
+      return false;
+    }
+    snapshot(&current, &old);
+  }
+  place(current, key, value, h);
+  ++root_->used;
+  return true;
+}
+
+template <class K, class V>
+bool SwissMap<K, V>::erase(const K& key) {
+  if (!root_ || memory_->readOnly()) {
+    return false;
+  }
+  migrate(kMigrateGroups);
+  Table current, old;
+  snapshot(&current, &old);
+  uint64_t h = hash(key);
+  bool erased = false;
+  for (const Table* t : {&current, &old}) {
+    if (*t) {
+      int64_t i = lookup(*t, key, h);
+      if (i >= 0) {
+        __atomic_store_n(&t->ctrl[i], kDeleted, __ATOMIC_RELEASE);
+        erased = true;
+      }
+    }
+  }
+  if (erased) {
+    --root_->size;
+    // shrink when mostly empty
+    if (!old && groupsToMigrate(root_->size) * 4 <= current.mask + 1) {
+      startMigration(root_->size);
+    }
+  }
+  return erased;
+}
+
+template <class K, class V>
+inline size_t SwissMap<K, V>::groupsToMigrate(size_t keys) const {
+  // at most one insert per kMigrateGroups groups of the current table,
+  // so the new table stays half full until the migration is done
+  size_t inserts = root_->tables[0].groups / kMigrateGroups + 1;
+  return std::max(groupsFor(keys + inserts), minGroups_);
+}
+
+template <class K, class V>
+bool SwissMap<K, V>::startMigration(size_t keys) {
+  // finish the running one first
+  migrate(size_t(-1));
+  TableRef ref;
+  ref.groups = groupsToMigrate(keys);
+  ref.offset = allocateTable(ref.groups);
+  if (ref.offset == 0) {
+    CRYSTAL_LOG(ERROR) << "allocate swiss map table failed, groups="
+        << ref.groups;
+    return false;
+  }
+  root_->cursor = 0;
+  root_->used = 0;
+  publish(ref, root_->tables[0]);
+  migrate(kMigrateGroups);
+  return true;
+}
+
+template <class K, class V>
+void SwissMap<K, V>::migrate(size_t groups) {
+  TableRef oldRef = root_->tables[1];
+  if (oldRef.offset == 0) {
+    return;
+  }
+  Table current = table(root_->tables[0]);
+  Table old = table(oldRef);
+  uint64_t end =
+      root_->cursor + std::min<uint64_t>(groups, oldRef.groups - root_->cursor);
+  for (; root_->cursor < end; ++root_->cursor) {
+    for (size_t j = 0; j < kGroupSize; ++j) {
+      size_t i = root_->cursor * kGroupSize + j;
+      if (old.ctrl[i] < 0) {
+        continue;
+      }
+      const Slot& slot = old.slots[i];
+      uint64_t h = hash(slot.key);
+      // assigned since the migration started
+      if (lookup(current, slot.key, h) < 0) {
+        place(current, slot.key, slot.value, h);
+        ++root_->used;
+      }
+    }
+  }
+  if (root_->cursor == oldRef.groups) {
+    publish(root_->tables[0], TableRef());
+    retireTable(oldRef);
+  }
+}
+
+template <class K, class V>
+int64_t SwissMap<K, V>::allocateTable(size_t groups) {
+  int level = findLastSet(groups) - 1;
+  int64_t offset = root_->retired[level];
+  if (offset != 0) {
+    Retired* r = reinterpret_cast<Retired*>(memory_->address(offset));
+    if (r->time + kRetireDelay < uint32_t(time(nullptr))) {
+      root_->retired[level] = r->next;
+    } else {
+      offset = 0;
+    }
+  }
+  if (offset == 0) {
+    offset = memory_->allocate(tableBytes(groups));
+    if (offset == 0) {
+      return 0;
+    }
+  }
+  memset(reinterpret_cast<uint8_t*>(memory_->address(offset)) +
+         sizeof(Retired), kEmpty, groups * kGroupSize);
+  return offset;
+}
+
+template <class K, class V>
+void SwissMap<K, V>::retireTable(const TableRef& ref) {
+  int level = findLastSet(ref.groups) - 1;
+  Retired* r = reinterpret_cast<Retired*>(memory_->address(ref.offset));
+  r->next = root_->retired[level];
+  r->time = uint32_t(time(nullptr));
+  root_->retired[level] = ref.offset;
+}
+
+template <class K, class V>
+inline size_t SwissMap<K, V>::size() const {
+  return root_ ? root_->size : 0;
+}
+
+template <class K, class V>
+inline size_t SwissMap<K, V>::capacity() const {
+  return root_ ? root_->tables[0].groups * kGroupSize : 0;
+}
+
+template <class K, class V>
+inline bool SwissMap<K, V>::migrating() const {
+  return root_ && root_->tables[1].offset != 0;
+}
+
+template <class K, class V>
+template <class F>
+void SwissMap<K, V>::forEach(F&& f) const {
+  if (!root_) {
+    return;
+  }
+  Table current, old;
+  snapshot(&current, &old);
+  for (size_t i = 0; i < current.capacity(); ++i) {
+    if (current.ctrl[i] >= 0) {
+      f(current.slots[i].key, current.slots[i].value);
+    }
+  }
+  if (old) {
+    for (size_t i = 0; i < old.capacity(); ++i) {
+      const Slot& slot = old.slots[i];
+      if (old.ctrl[i] >= 0 && lookup(current, slot.key, hash(slot.key)) < 0) {
+        f(slot.key, slot.value);
+      }
+    }
+  }
+}
+
+} // namespace crystal
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "crystal/storage/kv/VarChunkMap.h"
+
+#include <cstring>
+
+namespace crystal {
+
+bool VarChunkMap::init(Memory* memory) {
+  alloc_.init(memory);
+  if (memory->getAllocatedSize() == 0) {
+    if (alloc_.allocate(0) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool VarChunkMap::expand(size_t newSize) {
+  size_t oldSize = size();
+  if (newSize > oldSize) {
+    if (alloc_.allocate(newSize * sizeof(int64_t)) == 0) {
+      return false;
+    }
+    memset(offsets() + oldSize, 0, (newSize - oldSize) * sizeof(int64_t));
+  }
+  return true;
+}
+
+}  // namespace crystal
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "crystal/memory/RecycledAllocator.h"
+#include "crystal/memory/SimpleAllocator.h"
+
+namespace crystal {
+
+/*
+ * Chunks of variable size by id: a directory of chunk offsets, grown as
+ * FixedChunkMap, and chunks from a recycled allocator, so an id takes
+ * 8 bytes plus the size of its content. Chunks are not written in
+ * place: a replaced chunk is recycled after the allocator's delay, so
+ * readers of it are not disturbed.
+ */
+class VarChunkMap {
+ public:
+  explicit VarChunkMap(RecycledAllocator* chunkAlloc)
+      : chunkAlloc_(chunkAlloc) {}
+
+  virtual ~VarChunkMap() {}
+
+  bool init(Memory* memory);
+
+  // nullptr if there is none
+  void* getChunk(uint64_t id) const;
+  size_t getChunkSize(uint64_t id) const;
+
+  size_t size() const;
+
+  bool expand(size_t size);
+
+  /*
+   * fill(ptr) writes size bytes to a new chunk replacing the one of id,
+   * which is left to its readers until recycled by the allocator
+   */
+  template <class F>
+  bool write(uint64_t id, size_t size, F&& fill);
+
+ private:
+  int64_t* offsets() const;
+
+  RecycledAllocator* chunkAlloc_;
+  SimpleAllocator alloc_{true};
+};
+
+//////////////////////////////////////////////////////////////////////
+
+inline int64_t* VarChunkMap::offsets() const {
+  return reinterpret_cast<int64_t*>(alloc_.address(kMemStart));
+}
+
+inline void* VarChunkMap::getChunk(uint64_t id) const {
+  if (id >= size()) {
+    return nullptr;
+  }
+  int64_t offset = __atomic_load_n(&offsets()[id], __ATOMIC_ACQUIRE);
+  return offset != 0 ? chunkAlloc_->address(offset) : nullptr;
+}
+
+inline size_t VarChunkMap::getChunkSize(uint64_t id) const {
+  if (id >= size()) {
+    return 0;
+  }
+  int64_t offset = offsets()[id];
+  return offset != 0 ? chunkAlloc_->getSize(offset) : 0;
+}
+
+inline size_t VarChunkMap::size() const {
+  return alloc_.getSize(kMemStart) / sizeof(int64_t);
+}
+
+template <class F>
+bool VarChunkMap::write(uint64_t id, size_t size, F&& fill) {
+  if (id >= this->size()) {
+    return false;
+  }
+  int64_t& slot = offsets()[id];
+  int64_t offset = chunkAlloc_->allocate(size);
+  if (offset == 0) {
+    return false;
+  }
+  fill(chunkAlloc_->address(offset));
+  int64_t old = slot;
+  __atomic_store_n(&slot, offset, __ATOMIC_RELEASE);
+  if (old != 0) {
+    chunkAlloc_->deallocate(old);
+  }
+  return true;
+}
+
+}  // namespace crystal
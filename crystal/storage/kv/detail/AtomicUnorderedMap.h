@@ -218,6 +218,11 @@ struct AtomicUnorderedInsertMap {
     return ConstIterator(*this, find(key, keyToSlotIdx(key)));
   }
 
+  /// Prefetches the slot of key, the chain head usually links to it.
+  void prefetch(const Key& key) const {
+    __builtin_prefetch(&slots_[keyToSlotIdx(key)]);
+  }
+
   const_iterator cbegin() const {
     IndexType slot = numSlots_ - 1;
     while (slot > 0 && slots_[slot].state() != LINKED) {
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace crystal {
+namespace detail {
+
+// slots probed together, by one SSE2 compare of their control bytes
+constexpr size_t kGroupSize = 16;
+
+// bit i is set if group[i] == b
+inline uint32_t matchGroup(const int8_t* group, int8_t b) {
+#if defined(__SSE2__)
+  __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+  return _mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b)));
+#else
+  uint32_t mask = 0;
+  for (size_t i = 0; i < kGroupSize; ++i) {
+    mask |= uint32_t(group[i] == b) << i;
+  }
+  return mask;
+#endif
+}
+
+} // namespace detail
+} // namespace crystal
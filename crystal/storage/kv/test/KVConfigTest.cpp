@@ -43,4 +43,14 @@ TEST(KVConfig, all) {
   EXPECT_EQ(DataType::UINT64, config.keyConfig().type());
   EXPECT_EQ(4, config.fields().size());
   EXPECT_EQ(10000, config.bucket());
+  EXPECT_EQ(KeyMapType::kAtomic, config.keyMap());
+  EXPECT_EQ(RecordStoreType::kFixed, config.store());
+
+  j["map"] = "swiss";
+  config.parse(j, parseRecordConfig(j));
+  EXPECT_EQ(KeyMapType::kSwiss, config.keyMap());
+
+  j["store"] = "packed";
+  config.parse(j, parseRecordConfig(j));
+  EXPECT_EQ(RecordStoreType::kPacked, config.store());
 }
@@ -14,6 +14,9 @@
  * limitations under the License.
  */
 
+#include <atomic>
+#include <thread>
+
 #include "crystal/memory/SysAllocator.h"
 #include "crystal/memory/test/MemoryManagerTest.h"
 #include "crystal/storage/kv/KV.h"
@@ -53,6 +56,9 @@ TEST_F(KVTest, write) {
     EXPECT_TRUE(kv.insert(i, i));
     EXPECT_EQ(i, kv.find(i));
   }
+  EXPECT_TRUE(kv.insert(5, 5));
+  kv.erase(5);
+  EXPECT_EQ(-1, kv.find(5));
 
   Accessor accessor(kv.recordMeta());
   SysAllocator alloc;
@@ -75,9 +81,11 @@ TEST_F(KVTest, write) {
     }
   }
 
+  kv.sync();
   manager.dump();
 }
 
+// finds keys in the lookup map built by sync
 TEST_F(KVTest, read) {
   KVConfig config;
   dynamic j = parseCson(conf);
@@ -101,4 +109,242 @@ TEST_F(KVTest, read) {
               *record.recordMeta()->getMeta("status")));
     }
   }
+  EXPECT_EQ(-1, kv.find(5));
+
+  std::vector<uint64_t> keys = {1, 5, 100, 20000};
+  std::vector<uint32_t> ids(keys.size());
+  kv.findBatch(keys.data(), keys.size(), ids.data());
+  EXPECT_EQ(1, ids[0]);
+  EXPECT_EQ(-1, ids[1]);
+  EXPECT_EQ(100, ids[2]);
+  EXPECT_EQ(-1, ids[3]);
+}
+
+TEST_F(KVTest, swiss) {
+  KVConfig config;
+  dynamic j = parseCson(conf);
+  j["map"] = "swiss";
+  EXPECT_TRUE(config.parse(j, parseRecordConfig(j)));
+
+  std::string swissPath = path + "_swiss";
+  MemoryManager::remove(swissPath);
+  {
+    MemoryManager manager(swissPath.c_str(), false);
+    KV kv(config);
+    EXPECT_TRUE(kv.init(&manager));
+
+    for (uint64_t i = 1; i <= 10000; ++i) {
+      EXPECT_TRUE(kv.insert(i, i));
+    }
+    for (uint64_t i = 1; i <= 10000; i += 2) {
+      kv.erase(i);
+    }
+    EXPECT_EQ(-1, kv.find(1));
+    EXPECT_EQ(2, kv.find(2));
+
+    std::vector<uint64_t> keys = {2, 3, 4, 20000};
+    std::vector<uint32_t> ids(keys.size());
+    kv.findBatch(keys.data(), keys.size(), ids.data());
+    EXPECT_EQ(2, ids[0]);
+    EXPECT_EQ(-1, ids[1]);
+    EXPECT_EQ(4, ids[2]);
+    EXPECT_EQ(-1, ids[3]);
+
+    manager.dump();
+  }
+
+  MemoryManager manager(swissPath.c_str(), true);
+  KV kv(config);
+  EXPECT_TRUE(kv.init(&manager));
+  EXPECT_EQ(-1, kv.find(9999));
+  EXPECT_EQ(10000, kv.find(10000));
+}
+
+TEST_F(KVTest, freeze) {
+  KVConfig config;
+  dynamic j = parseCson(conf);
+  EXPECT_TRUE(config.parse(j, parseRecordConfig(j)));
+
+  std::string frozenPath = path + "_frozen";
+  MemoryManager::remove(frozenPath);
+  {
+    MemoryManager manager(frozenPath.c_str(), false);
+    KV kv(config);
+    EXPECT_TRUE(kv.init(&manager));
+    for (uint64_t i = 1; i <= 1000; ++i) {
+      EXPECT_TRUE(kv.insert(i, i));
+    }
+    kv.erase(5);
+    EXPECT_TRUE(kv.freeze());
+    kv.sync();
+    manager.dump();
+  }
+  {
+    MemoryManager manager(frozenPath.c_str(), true);
+    KV kv(config);
+    EXPECT_TRUE(kv.init(&manager));
+    EXPECT_EQ(1000, kv.find(1000));
+    EXPECT_EQ(-1, kv.find(5));
+
+    std::vector<uint64_t> keys = {1, 5, 100, 2000};
+    std::vector<uint32_t> ids(keys.size());
+    kv.findBatch(keys.data(), keys.size(), ids.data());
+    EXPECT_EQ(1, ids[0]);
+    EXPECT_EQ(-1, ids[1]);
+    EXPECT_EQ(100, ids[2]);
+    EXPECT_EQ(-1, ids[3]);
+  }
+  // stays frozen when updated
+  {
+    MemoryManager manager(frozenPath.c_str(), false);
+    KV kv(config);
+    EXPECT_TRUE(kv.init(&manager));
+    EXPECT_TRUE(kv.insert(2000, 2000));
+    kv.sync();
+    manager.dump();
+  }
+  MemoryManager manager(frozenPath.c_str(), true);
+  KV kv(config);
+  EXPECT_TRUE(kv.init(&manager));
+  EXPECT_EQ(2000, kv.find(2000));
+}
+
+TEST_F(KVTest, packed) {
+  KVConfig config;
+  dynamic j = parseCson(conf);
+  j["store"] = "packed";
+  EXPECT_TRUE(config.parse(j, parseRecordConfig(j)));
+
+  std::string packedPath = path + "_packed";
+  MemoryManager::remove(packedPath);
+  {
+    MemoryManager manager(packedPath.c_str(), false);
+    KV kv(config);
+    EXPECT_TRUE(kv.init(&manager));
+
+    Accessor accessor(kv.recordMeta());
+    SysAllocator alloc;
+    Record record;
+    record.init(&kv.recordMeta(), &accessor, &alloc);
+    void* buf = alloc.address(alloc.allocate(accessor.bufferSize()));
+    memset(buf, 0, accessor.bufferSize());
+    record.setBuffer(buf);
+    record.reset();
+    const FieldMeta& status = *record.recordMeta()->getMeta("status");
+    const FieldMeta& content = *record.recordMeta()->getMeta("content");
+
+    for (uint32_t i = 10; i <= 1000; i *= 10) {
+      EXPECT_TRUE(kv.insert(i, i));
+      EXPECT_TRUE(kv.add(i, record));
+      EXPECT_TRUE(kv.exist(i));
+    }
+
+    // unset fields read as default
+    Record r = kv.createRecord(kv.getRecordPtr(10));
+    EXPECT_EQ(1, r.get<int32_t>(status));
+    EXPECT_EQ("", r.get<std::string_view>(content));
+
+    // replaced, the former version is left to its readers
+    record.set<int32_t>(status, 3);
+    EXPECT_TRUE(kv.update(10, record));
+    EXPECT_EQ(1, r.get<int32_t>(status));
+    EXPECT_TRUE(kv.get(10, r));
+    EXPECT_EQ(3, r.get<int32_t>(status));
+
+    record.set<std::string_view>(content, "packed");
+    EXPECT_TRUE(kv.update(100, record));
+    EXPECT_TRUE(kv.get(100, r));
+    EXPECT_EQ(3, r.get<int32_t>(status));
+    EXPECT_EQ("packed", r.get<std::string_view>(content));
+
+    EXPECT_TRUE(kv.remove(1000));
+    EXPECT_FALSE(kv.exist(1000));
+
+    kv.sync();
+    manager.dump();
+  }
+  MemoryManager manager(packedPath.c_str(), true);
+  KV kv(config);
+  EXPECT_TRUE(kv.init(&manager));
+
+  Record r = kv.createRecord();
+  const FieldMeta& content = *r.recordMeta()->getMeta("content");
+  EXPECT_TRUE(kv.get(10, r));
+  EXPECT_EQ(3, r.get<int32_t>(*r.recordMeta()->getMeta("status")));
+  EXPECT_EQ("", r.get<std::string_view>(content));
+  EXPECT_TRUE(kv.get(100, r));
+  EXPECT_EQ("packed", r.get<std::string_view>(content));
+  EXPECT_FALSE(kv.exist(1000));
+  // no chunk
+  r.setBuffer(kv.getRecordPtr(50));
+  EXPECT_EQ(1, r.get<int32_t>(*r.recordMeta()->getMeta("status")));
+}
+
+// readers see menuId and status of the same update, and never a deleted
+// record, while a writer updates them
+TEST_F(KVTest, concurrent) {
+  for (auto store : {"fixed", "packed"}) {
+    KVConfig config;
+    dynamic j = parseCson(conf);
+    j["store"] = store;
+    EXPECT_TRUE(config.parse(j, parseRecordConfig(j)));
+
+    std::string concurrentPath = path + "_concurrent";
+    MemoryManager::remove(concurrentPath);
+    MemoryManager manager(concurrentPath.c_str(), false);
+    KV kv(config);
+    EXPECT_TRUE(kv.init(&manager));
+
+    Accessor accessor(kv.recordMeta());
+    SysAllocator alloc;
+    Record record;
+    record.init(&kv.recordMeta(), &accessor, &alloc);
+    void* buf = alloc.address(alloc.allocate(accessor.bufferSize()));
+    memset(buf, 0, accessor.bufferSize());
+    record.setBuffer(buf);
+    record.reset();
+    const FieldMeta& menuId = *kv.recordMeta().getMeta("menuId");
+    const FieldMeta& status = *kv.recordMeta().getMeta("status");
+    record.set<int32_t>(status, 0);
+
+    for (uint32_t i = 0; i < 4; ++i) {
+      EXPECT_TRUE(kv.insert(i, i));
+      EXPECT_TRUE(kv.add(i, record));
+    }
+
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> torn{0};
+    std::atomic<size_t> missing{0};
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+      readers.emplace_back([&]() {
+        while (!stop.load()) {
+          for (uint32_t i = 0; i < 4; ++i) {
+            uint64_t id;
+            int32_t s;
+            bool ok = kv.read(i, [&](const Record& r) {
+              id = r.get<uint64_t>(menuId);
+              s = r.get<int32_t>(status);
+            });
+            if (!ok) {
+              ++missing;
+            } else if (id % 8 != uint64_t(s)) {
+              ++torn;
+            }
+          }
+        }
+      });
+    }
+    for (uint64_t n = 1; n <= 100000; ++n) {
+      record.set<uint64_t>(menuId, n);
+      record.set<int32_t>(status, n % 8);
+      EXPECT_TRUE(kv.update(n % 4, record));
+    }
+    stop = true;
+    for (auto& reader : readers) {
+      reader.join();
+    }
+    EXPECT_EQ(0, missing.load());
+    EXPECT_EQ(0, torn.load());
+  }
 }
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "crystal/memory/test/MMapMemoryTest.h"
+#include "crystal/storage/kv/LookupMap.h"
+
+using namespace crystal;
+
+TEST_F(MMapMemoryTest, LookupMap_write) {
+  MMapMemory memory(path.c_str(), O_RDWR | O_CREAT, 100);
+  EXPECT_TRUE(memory.init());
+
+  LookupMap<uint64_t, uint32_t> map;
+  EXPECT_TRUE(map.init(&memory));
+  EXPECT_FALSE(map.built());
+
+  EXPECT_TRUE(map.rebuild(10000));
+  EXPECT_TRUE(map.built());
+  for (uint64_t i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(map.insert(i, i * 100));
+  }
+  EXPECT_TRUE(map.insert(1000, 1));
+  EXPECT_EQ(10000, map.size());
+
+  uint32_t value;
+  EXPECT_TRUE(map.find(1000, &value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(map.find(10000, &value));
+
+  // drops the former keys
+  EXPECT_TRUE(map.rebuild(10000));
+  EXPECT_FALSE(map.find(1000, &value));
+  for (uint64_t i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(map.insert(i, i * 100));
+  }
+
+  memory.dump();
+}
+
+TEST_F(MMapMemoryTest, LookupMap_read) {
+  MMapMemory memory(path.c_str(), O_RDONLY);
+  EXPECT_TRUE(memory.init());
+
+  LookupMap<uint64_t, uint32_t> map;
+  EXPECT_TRUE(map.init(&memory));
+  EXPECT_TRUE(map.built());
+  EXPECT_EQ(10000, map.size());
+
+  uint32_t value;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(map.find(i, &value));
+    EXPECT_EQ(i * 100, value);
+  }
+  EXPECT_FALSE(map.find(10000, &value));
+  EXPECT_FALSE(map.insert(10000, 0));
+  EXPECT_FALSE(map.rebuild(0));
+}
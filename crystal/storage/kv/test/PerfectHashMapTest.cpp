@@ -0,0 +1,93 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "crystal/memory/test/MMapMemoryTest.h"
+#include "crystal/storage/kv/PerfectHashMap.h"
+
+using namespace crystal;
+
+static uint64_t key(uint64_t i) {
+  return hash_128_to_64(i, 12345);
+}
+
+TEST_F(MMapMemoryTest, PerfectHashMap_write) {
+  MMapMemory memory(path.c_str(), O_RDWR | O_CREAT, 100);
+  EXPECT_TRUE(memory.init());
+
+  PerfectHashMap map;
+  EXPECT_TRUE(map.init(&memory));
+  EXPECT_FALSE(map.built());
+
+  std::vector<std::pair<uint64_t, uint32_t>> entries;
+  for (uint32_t i = 0; i < 100000; ++i) {
+    entries.emplace_back(key(i), i);
+  }
+  entries.emplace_back(key(0), 0);
+  EXPECT_TRUE(map.build(entries));
+  EXPECT_TRUE(map.built());
+  EXPECT_EQ(100000, map.size());
+
+  uint32_t id;
+  for (uint32_t i = 0; i < 100000; ++i) {
+    EXPECT_TRUE(map.find(key(i), &id));
+    EXPECT_EQ(i, id);
+  }
+  // absent keys are told by fingerprints
+  size_t found = 0;
+  for (uint32_t i = 100000; i < 200000; ++i) {
+    found += map.find(key(i), &id);
+  }
+  EXPECT_EQ(0, found);
+  // 3.5 bits per key in bit arrays
+  EXPECT_GT(100000 * 8 + 100000 * 4 / 8, memory.getAllocatedSize());
+
+  memory.dump();
+}
+
+TEST_F(MMapMemoryTest, PerfectHashMap_read) {
+  MMapMemory memory(path.c_str(), O_RDONLY);
+  EXPECT_TRUE(memory.init());
+
+  PerfectHashMap map;
+  EXPECT_TRUE(map.init(&memory));
+  EXPECT_TRUE(map.built());
+  EXPECT_EQ(100000, map.size());
+
+  uint32_t id;
+  for (uint32_t i = 0; i < 100000; ++i) {
+    EXPECT_TRUE(map.find(key(i), &id));
+    EXPECT_EQ(i, id);
+  }
+  EXPECT_FALSE(map.build({}));
+}
+
+TEST_F(MMapMemoryTest, PerfectHashMap_small) {
+  std::string smallPath = path + "_small";
+  MMapMemory::remove(smallPath);
+  MMapMemory memory(smallPath.c_str(), O_RDWR | O_CREAT);
+  EXPECT_TRUE(memory.init());
+
+  PerfectHashMap map;
+  EXPECT_TRUE(map.init(&memory));
+  uint32_t id;
+  EXPECT_TRUE(map.build({}));
+  EXPECT_FALSE(map.find(1, &id));
+
+  EXPECT_TRUE(map.build({{1, 10}, {2, 20}}));
+  EXPECT_TRUE(map.find(2, &id));
+  EXPECT_EQ(20, id);
+}
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <thread>
+
+#include "crystal/memory/test/MMapMemoryTest.h"
+#include "crystal/storage/kv/SwissMap.h"
+
+using namespace crystal;
+
+TEST_F(MMapMemoryTest, SwissMap_write) {
+  MMapMemory memory(path.c_str(), O_RDWR | O_CREAT, 100);
+  EXPECT_TRUE(memory.init());
+
+  // grows from a single group
+  SwissMap<uint64_t, uint32_t> map;
+  EXPECT_TRUE(map.init(&memory));
+  EXPECT_EQ(16, map.capacity());
+
+  uint32_t value;
+  for (uint64_t i = 0; i < 10000; ++i) {
+    EXPECT_FALSE(map.find(i, &value));
+    EXPECT_TRUE(map.insert(i, i * 100));
+    EXPECT_TRUE(map.find(i, &value));
+    EXPECT_EQ(i * 100, value);
+  }
+  EXPECT_EQ(10000, map.size());
+  for (uint64_t i = 0; i < 10000; ++i) {
+    EXPECT_TRUE(map.find(i, &value));
+    EXPECT_EQ(i * 100, value);
+  }
+
+  // assign and erase
+  EXPECT_TRUE(map.insert(1000, 1));
+  EXPECT_TRUE(map.find(1000, &value));
+  EXPECT_EQ(1, value);
+  EXPECT_TRUE(map.erase(1001));
+  EXPECT_FALSE(map.erase(1001));
+  EXPECT_FALSE(map.find(1001, &value));
+  EXPECT_EQ(9999, map.size());
+
+  size_t n = 0;
+  map.forEach([&](uint64_t, uint32_t) { ++n; });
+  EXPECT_EQ(9999, n);
+
+  memory.dump();
+}
+
+TEST_F(MMapMemoryTest, SwissMap_read) {
+  MMapMemory memory(path.c_str(), O_RDONLY);
+  EXPECT_TRUE(memory.init());
+
+  SwissMap<uint64_t, uint32_t> map;
+  EXPECT_TRUE(map.init(&memory));
+  EXPECT_EQ(9999, map.size());
+
+  uint32_t value;
+  EXPECT_TRUE(map.find(1000, &value));
+  EXPECT_EQ(1, value);
+  EXPECT_FALSE(map.find(1001, &value));
+  EXPECT_TRUE(map.find(9999, &value));
+  EXPECT_EQ(999900, value);
+  EXPECT_FALSE(map.insert(1001, 0));
+}
+
+// churned keys are reclaimed instead of growing the table
+TEST_F(MMapMemoryTest, SwissMap_churn) {
+  std::string churnPath = path + "_churn";
+  MMapMemory::remove(churnPath);
+  MMapMemory memory(churnPath.c_str(), O_RDWR | O_CREAT);
+  EXPECT_TRUE(memory.init());
+
+  SwissMap<uint64_t, uint32_t> map(1000);
+  EXPECT_TRUE(map.init(&memory));
+  size_t capacity = map.capacity();
+
+  uint32_t value;
+  for (uint64_t i = 0; i < 100000; ++i) {
+    EXPECT_TRUE(map.insert(i, i));
+    if (i >= 1000) {
+      EXPECT_TRUE(map.erase(i - 1000));
+    }
+  }
+  EXPECT_EQ(1000, map.size());
+  EXPECT_GE(2 * capacity, map.capacity());
+  for (uint64_t i = 99000; i < 100000; ++i) {
+    EXPECT_TRUE(map.find(i, &value));
+    EXPECT_EQ(i, value);
+  }
+  EXPECT_FALSE(map.find(98999, &value));
+
+  // shrinks back when mostly erased
+  for (uint64_t i = 0; i < 100000; ++i) {
+    EXPECT_TRUE(map.insert(i, i));
+  }
+  size_t large = map.capacity();
+  for (uint64_t i = 0; i < 99000; ++i) {
+    EXPECT_TRUE(map.erase(i));
+  }
+  EXPECT_GT(large, map.capacity());
+  for (uint64_t i = 99000; i < 100000; ++i) {
+    EXPECT_TRUE(map.find(i, &value));
+  }
+}
+
+// readers never miss a stable key while the writer resizes
+TEST_F(MMapMemoryTest, SwissMap_concurrent) {
+  std::string concurrentPath = path + "_concurrent";
+  MMapMemory::remove(concurrentPath);
+  MMapMemory memory(concurrentPath.c_str(), O_RDWR | O_CREAT);
+  EXPECT_TRUE(memory.init());
+
+  SwissMap<uint64_t, uint32_t> map;
+  EXPECT_TRUE(map.init(&memory));
+  for (uint64_t i = 0; i < 100; ++i) {
+    map.insert(i, i);
+  }
+
+  std::atomic<bool> done{false};
+  std::atomic<size_t> misses{0};
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&]() {
+      uint32_t value;
+      while (!done.load()) {
+        for (uint64_t i = 0; i < 100; ++i) {
+          if (!map.find(i, &value) || value != i) {
+            ++misses;
+          }
+        }
+      }
+    });
+  }
+  for (uint64_t i = 100; i < 200000; ++i) {
+    map.insert(i, i);
+    if (i % 3 == 0) {
+      map.erase(i);
+    }
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(0, misses.load());
+}
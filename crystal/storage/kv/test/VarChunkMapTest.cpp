@@ -0,0 +1,83 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstring>
+
+#include "crystal/memory/test/MemoryManagerTest.h"
+#include "crystal/storage/kv/VarChunkMap.h"
+
+using namespace crystal;
+
+TEST_F(MemoryManagerTest, VarChunkMap_write) {
+  MemoryManager manager(path.c_str(), false);
+  RecycledAllocator alloc;
+  EXPECT_TRUE(alloc.init(manager.getMemory(MemoryType::kMemRecyc)));
+
+  VarChunkMap chunkmap(&alloc);
+  EXPECT_TRUE(chunkmap.init(manager.getMemory(MemoryType::kMemSimple)));
+
+  EXPECT_EQ(0, chunkmap.size());
+  EXPECT_TRUE(chunkmap.expand(10));
+  EXPECT_EQ(10, chunkmap.size());
+  EXPECT_FALSE(chunkmap.write(10, 8, [](void*) {}));
+
+  for (size_t i = 0; i < 10; ++i) {
+    EXPECT_EQ(nullptr, chunkmap.getChunk(i));
+    EXPECT_EQ(0, chunkmap.getChunkSize(i));
+  }
+  for (size_t i = 0; i < 10; i += 2) {
+    EXPECT_TRUE(chunkmap.write(i, i + 1, [&](void* ptr) {
+      memset(ptr, int(i), i + 1);
+    }));
+    EXPECT_LE(i + 1, chunkmap.getChunkSize(i));
+  }
+
+  // replaced, the old chunk is left to its readers
+  uint8_t* ptr = reinterpret_cast<uint8_t*>(chunkmap.getChunk(8));
+  EXPECT_TRUE(chunkmap.write(8, 4, [](void* p) { memset(p, 8, 4); }));
+  EXPECT_NE(ptr, chunkmap.getChunk(8));
+  EXPECT_EQ(8, ptr[0]);
+  EXPECT_TRUE(chunkmap.write(0, 16, [](void* p) { memset(p, 0, 16); }));
+  EXPECT_LE(16, chunkmap.getChunkSize(0));
+
+  EXPECT_TRUE(chunkmap.expand(20));
+  EXPECT_EQ(20, chunkmap.size());
+  EXPECT_EQ(nullptr, chunkmap.getChunk(19));
+
+  manager.dump();
+}
+
+TEST_F(MemoryManagerTest, VarChunkMap_read) {
+  MemoryManager manager(path.c_str(), true);
+  RecycledAllocator alloc;
+  EXPECT_TRUE(alloc.init(manager.getMemory(MemoryType::kMemRecyc)));
+
+  VarChunkMap chunkmap(&alloc);
+  EXPECT_TRUE(chunkmap.init(manager.getMemory(MemoryType::kMemSimple)));
+
+  EXPECT_EQ(20, chunkmap.size());
+  EXPECT_LE(16, chunkmap.getChunkSize(0));
+  for (size_t i = 1; i < 20; ++i) {
+    uint8_t* ptr = reinterpret_cast<uint8_t*>(chunkmap.getChunk(i));
+    if (i % 2 || i >= 10) {
+      EXPECT_EQ(nullptr, ptr);
+    } else {
+      EXPECT_NE(nullptr, ptr);
+      EXPECT_EQ(i, ptr[0]);
+    }
+  }
+}
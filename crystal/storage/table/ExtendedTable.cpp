@@ -90,12 +90,17 @@ bool ExtendedTable::hasKV() const {
 }
 
 DataType ExtendedTable::getFieldType(const std::string& field) const {
+  const FieldMeta* meta = getFieldMeta(field);
+  return meta ? meta->type() : DataType::UNKNOWN;
+}
+
+const FieldMeta* ExtendedTable::getFieldMeta(const std::string& field) const {
   for (auto& fi : fieldInfos_) {
     if (field == fi.meta.name()) {
-      return fi.meta.type();
+      return &fi.meta;
     }
   }
-  return DataType::UNKNOWN;
+  return nullptr;
 }
 
 } // namespace crystal
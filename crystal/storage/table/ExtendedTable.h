@@ -43,6 +43,7 @@ class ExtendedTable {
 
   bool hasKV() const;
   DataType getFieldType(const std::string& field) const;
+  const FieldMeta* getFieldMeta(const std::string& field) const;
 
  private:
   void buildFieldInfo(const FieldMeta& meta,
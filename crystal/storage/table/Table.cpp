@@ -16,6 +16,7 @@
 
 #include "crystal/storage/table/Table.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <string>
 #include <string_view>
@@ -187,6 +188,16 @@ bool Table::initIndex() {
 }
 
 void Table::dump() {
+  for (auto& p : indexMap_) {
+    for (auto& index : p.second) {
+      index->sync();
+    }
+  }
+  for (auto& kv : kvs_) {
+    if (kv) {
+      kv->sync();
+    }
+  }
   for (auto& memory : memorys_) {
     memory->dump();
   }
@@ -216,6 +227,50 @@ uint64_t Table::find(uint64_t key) const {
   return (seg << 32) | segOffset;
 }
 
+void Table::findBatch(const uint64_t* keys, size_t n, uint64_t* ids) const {
+  if (kvs_.empty()) {
+    std::fill(ids, ids + n, uint64_t(-1));
+    return;
+  }
+  size_t segs = kvs_.size();
+  std::vector<uint32_t> found(n);
+  if (segs == 1) {
+    kvs_[0]->findBatch(keys, n, found.data());
+    for (size_t i = 0; i < n; ++i) {
+      ids[i] = found[i] == uint32_t(-1) ? uint64_t(-1) : found[i];
+    }
+    return;
+  }
+  // counting sort of keys by segment
+  std::vector<size_t> begin(segs + 1, 0);
+  for (size_t i = 0; i < n; ++i) {
+    ++begin[keys[i] % segs + 1];
+  }
+  for (size_t seg = 0; seg < segs; ++seg) {
+    begin[seg + 1] += begin[seg];
+  }
+  std::vector<size_t> pos(begin.begin(), begin.end() - 1);
+  std::vector<uint64_t> grouped(n);
+  std::vector<uint32_t> order(n);
+  for (size_t i = 0; i < n; ++i) {
+    size_t j = pos[keys[i] % segs]++;
+    grouped[j] = keys[i];
+    order[j] = i;
+  }
+  for (size_t seg = 0; seg < segs; ++seg) {
+    if (begin[seg + 1] == begin[seg]) {
+      continue;
+    }
+    kvs_[seg]->findBatch(grouped.data() + begin[seg],
+                         begin[seg + 1] - begin[seg],
+                         found.data() + begin[seg]);
+    for (size_t j = begin[seg]; j < begin[seg + 1]; ++j) {
+      ids[order[j]] = found[j] == uint32_t(-1)
+        ? uint64_t(-1) : (uint64_t(seg) << 32) | found[j];
+    }
+  }
+}
+
 bool Table::insert(uint64_t key, uint64_t id) {
   if (kvs_.empty()) {
     return false;
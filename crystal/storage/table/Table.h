@@ -22,6 +22,7 @@
 #include <vector>
 
 #include "crystal/storage/index/Index.h"
+#include "crystal/storage/index/PostingCache.h"
 #include "crystal/storage/kv/KV.h"
 #include "crystal/storage/table/TableConfig.h"
 
@@ -59,6 +60,9 @@ class Table {
   KV* getKVByKey(uint64_t key) const;
 
   uint64_t find(uint64_t key) const;
+  // same as find on each key, keys are grouped by segment and resolved
+  // with KV::findBatch
+  void findBatch(const uint64_t* keys, size_t n, uint64_t* ids) const;
   bool insert(uint64_t key, uint64_t id);
   bool erase(uint64_t key);
 
@@ -72,6 +76,9 @@ class Table {
 
   AnyPostingList getPostingList(const std::string& index, uint64_t token) const;
 
+  // decoded posting ids of hot tokens, shared by all index
+  PostingCache& postingCache() const;
+
  private:
   bool initKV();
   bool initIndex();
@@ -88,6 +95,7 @@ class Table {
   std::vector<std::unique_ptr<MemoryManager>> memorys_;
   std::vector<std::unique_ptr<KV>> kvs_;
   std::map<std::string, std::vector<std::unique_ptr<Index>>> indexMap_;
+  mutable PostingCache postingCache_;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -130,4 +138,8 @@ inline KV* Table::getKVByKey(uint64_t key) const {
   return !kvs_.empty() ? getKV(key % kvs_.size()) : nullptr;
 }
 
+inline PostingCache& Table::postingCache() const {
+  return postingCache_;
+}
+
 }  // namespace crystal
@@ -137,6 +137,15 @@ TEST_F(TableTest, read) {
     }
   }
 
+  std::vector<uint64_t> keys = {10000, 7, 1, 100, 12345, 10, 1000};
+  std::vector<uint64_t> ids(keys.size());
+  table.findBatch(keys.data(), keys.size(), ids.data());
+  for (size_t i = 0; i < keys.size(); ++i) {
+    EXPECT_EQ(table.find(keys[i]), ids[i]);
+  }
+  EXPECT_EQ(-1, ids[1]);
+  EXPECT_EQ(-1, ids[4]);
+
   Index* index = table.getIndexByToken("status", hashToken(2));
 
   AnyPostingList pl = index->getPostingList(hashToken(2));
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace crystal {
+
+/*
+ * Range keys are dyadic prefixes of an order preserving 60 bits code,
+ * every value is indexed under one key per level, level l holds the
+ * prefix code >> (4 * l).  A [lo, hi) predicate is decomposed into at
+ * most 2 * 15 keys per level (16 on the top level), whose posting lists
+ * are ORed.
+ *
+ * Signed integers are biased by 2^59, unsigned integers should be less
+ * than 2^60, strings are coded by their first 7 bytes (big endian), so
+ * string prefix up to 7 bytes is exact.
+ */
+constexpr size_t kRangeBits = 60;
+constexpr size_t kRangeLevelBits = 4;
+constexpr size_t kRangeLevels = kRangeBits / kRangeLevelBits;
+constexpr uint64_t kRangeMax = uint64_t(1) << kRangeBits;
+constexpr size_t kRangeStringBytes = 7;
+
+// level is kept in the low bits so that the key is never 0
+inline uint64_t rangeKey(uint64_t code, size_t level) {
+  return ((code >> (level * kRangeLevelBits)) << kRangeLevelBits) | (level + 1);
+}
+
+// return false if the value is out of the coding domain
+template <class T>
+inline typename std::enable_if<std::is_integral<T>::value, bool>::type
+rangeCode(T value, uint64_t& code) {
+  if (std::is_signed<T>::value) {
+    int64_t v = value;
+    if (v < -int64_t(kRangeMax / 2) || v >= int64_t(kRangeMax / 2)) {
+      return false;
+    }
+    code = uint64_t(v + int64_t(kRangeMax / 2));
+  } else {
+    if (uint64_t(value) >= kRangeMax) {
+      return false;
+    }
+    code = value;
+  }
+  return true;
+}
+
+inline bool rangeCode(std::string_view value, uint64_t& code) {
+  code = 0;
+  for (size_t i = 0; i < kRangeStringBytes; ++i) {
+    code = (code << 8) | (i < value.size() ? uint8_t(value[i]) : 0);
+  }
+  return true;
+}
+
+// [lo, hi) of the string codes starting with prefix
+inline bool rangePrefix(std::string_view prefix, uint64_t& lo, uint64_t& hi) {
+  if (prefix.size() > kRangeStringBytes) {
+    return false;
+  }
+  rangeCode(prefix, lo);
+  hi = lo + (uint64_t(1) << (8 * (kRangeStringBytes - prefix.size())));
+  return true;
+}
+
+inline std::vector<uint64_t> rangeIndexKeys(uint64_t code) {
+  std::vector<uint64_t> keys(kRangeLevels);
+  for (size_t l = 0; l < kRangeLevels; ++l) {
+    keys[l] = rangeKey(code, l);
+  }
+  return keys;
+}
+
+// decompose codes [lo, hi) into range keys, lo and hi are clamped
+inline std::vector<uint64_t> rangeTokens(uint64_t lo, uint64_t hi) {
+  std::vector<uint64_t> tokens;
+  hi = std::min(hi, kRangeMax);
+  constexpr uint64_t mask = (uint64_t(1) << kRangeLevelBits) - 1;
+  for (size_t l = 0; l < kRangeLevels && lo < hi; ++l) {
+    size_t shift = l * kRangeLevelBits;
+    if (l + 1 == kRangeLevels) {
+      for (; lo < hi; ++lo) {
+        tokens.push_back(rangeKey(lo << shift, l));
+      }
+      break;
+    }
+    while (lo < hi && (lo & mask)) {
+      tokens.push_back(rangeKey(lo++ << shift, l));
+    }
+    while (lo < hi && (hi & mask)) {
+      tokens.push_back(rangeKey(--hi << shift, l));
+    }
+    lo >>= kRangeLevelBits;
+    hi >>= kRangeLevelBits;
+  }
+  return tokens;
+}
+
+} // namespace crystal
@@ -0,0 +1,35 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/strategy/Strategy.h"
+
+namespace crystal {
+
+/*
+ * Index every value under its range keys (see Range.h), the index can
+ * then answer range and prefix predicates by RangeSearch.
+ */
+class RangeStrategy : public Strategy {
+ public:
+  RangeStrategy(const FieldMeta& keyMeta) : Strategy(keyMeta) {}
+  virtual ~RangeStrategy() {}
+
+  std::vector<uint64_t> getIndexKeys(const Record& record) override;
+};
+
+} // namespace crystal
@@ -17,6 +17,8 @@
 #include "crystal/strategy/Strategy.h"
 
 #include "crystal/strategy/DefaultStrategy.h"
+#include "crystal/strategy/IdStrategy.h"
+#include "crystal/strategy/RangeStrategy.h"
 
 namespace crystal {
 
@@ -25,6 +27,10 @@ createStrategy(StrategyType type, const FieldMeta& keyMeta) {
   switch (type) {
     case StrategyType::kDefault:
       return std::unique_ptr<Strategy>(new DefaultStrategy(keyMeta));
+    case StrategyType::kRange:
+      return std::unique_ptr<Strategy>(new RangeStrategy(keyMeta));
+    case StrategyType::kId:
+      return std::unique_ptr<Strategy>(new IdStrategy(keyMeta));
   }
   return nullptr;
 }
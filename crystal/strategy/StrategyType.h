@@ -19,7 +19,9 @@
 namespace crystal {
 
 #define CRYSTAL_STRATEGY_TYPE_GEN(x)  \
-  x(Default)
+  x(Default),                         \
+  x(Range),                           \
+  x(Id)
 
 #define CRYSTAL_STRATEGY_TYPE_ENUM(type) k##type
 
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <gflags/gflags.h>
+
+#include "crystal/foundation/SystemUtil.h"
+#include "crystal/storage/table/TableFactory.h"
+
+DEFINE_string(conf, "", "crystal conf");
+DEFINE_string(data, "", "crystal data");
+DEFINE_int32(loglevel, 2, "log level: 0~4 = DIWEF");
+
+using namespace crystal;
+
+int main(int argc, char** argv) {
+  gflags::SetUsageMessage(
+      "Usage: " + getProcessName() +
+      " -conf CONF -data DATA [-loglevel N]");
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+
+  FLAGS_loglevel = std::min(FLAGS_loglevel, 4);
+  FLAGS_loglevel = std::max(FLAGS_loglevel, -5);
+  Singleton<logging::Logger>::get().setLevel(FLAGS_loglevel);
+
+  if (FLAGS_conf.empty() || FLAGS_data.empty()) {
+    CRYSTAL_LOG(ERROR) << "conf & data needed, see -help";
+    return -1;
+  }
+
+  TableFactory factory;
+  if (!factory.load(FLAGS_conf.c_str(), FLAGS_data.c_str(), false)) {
+    CRYSTAL_LOG(ERROR) << "load data from '" << FLAGS_data
+        << "' with conf '" << FLAGS_conf << "' failed";
+    return -1;
+  }
+
+  // the perfect hash maps are built when dumped
+  auto& tables = factory.getTableGroup()->getTables();
+  for (auto& table : tables) {
+    uint16_t segCount = table.second->getKVSegmentCount();
+    for (uint16_t seg = 0; seg < segCount; ++seg) {
+      if (!table.second->getKV(seg)->freeze()) {
+        CRYSTAL_LOG(ERROR) << "freeze kv segment " << seg
+            << " of table '" << table.first << "' failed";
+        return -1;
+      }
+    }
+    CRYSTAL_RLOG(WARN) << "freeze table: " << table.first;
+  }
+  factory.dump();
+
+  return 0;
+}
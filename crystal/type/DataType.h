@@ -22,6 +22,7 @@
 
 #include "crystal/foundation/Exception.h"
 #include "crystal/math/Div.h"
+#include "crystal/type/Float16.h"
 
 namespace crystal {
 
@@ -39,7 +40,8 @@ namespace crystal {
   x(FLOAT),                       \
   x(DOUBLE),                      \
   x(STRING),                      \
-  x(TUPLE)
+  x(TUPLE),                       \
+  x(FLOAT16)
 
 #define CRYSTAL_DATA_TYPE_ENUM(type) type
 
@@ -87,6 +89,7 @@ CRYSTAL_DATA_TYPE_TRAITS(uint32_t, UINT32)
 CRYSTAL_DATA_TYPE_TRAITS(uint64_t, UINT64)
 CRYSTAL_DATA_TYPE_TRAITS(float, FLOAT)
 CRYSTAL_DATA_TYPE_TRAITS(double, DOUBLE)
+CRYSTAL_DATA_TYPE_TRAITS(float16, FLOAT16)
 CRYSTAL_DATA_TYPE_TRAITS(std::string, STRING)
 CRYSTAL_DATA_TYPE_TRAITS(std::string_view, STRING)
 
@@ -128,6 +131,7 @@ inline bool isFloat(DataType type) {
   switch (type) {
     case DataType::FLOAT:
     case DataType::DOUBLE:
+    case DataType::FLOAT16:
       return true;
     default:
       return false;
@@ -156,6 +160,7 @@ inline size_t sizeOf(DataType type) {
     case DataType::FLOAT: return sizeof(float);
     case DataType::DOUBLE: return sizeof(double);
     case DataType::STRING: return sizeof(void*);
+    case DataType::FLOAT16: return sizeof(float16);
     default:
       CRYSTAL_THROW(
           RuntimeError, "unsupport data type: ", dataTypeToString(type));
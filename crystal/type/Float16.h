@@ -0,0 +1,40 @@
+/*
+ * Copyright 2017-present Yeolar
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "crystal/math/Distance.h"
+
+namespace crystal {
+
+/*
+ * Half precision float stored in 2 bytes, computes as float. Arrays of
+ * float16 are laid out as Half codes for the distance kernels.
+ */
+struct float16 {
+  Half bits;
+
+  float16() {}
+  /* implicit */ float16(float f) : bits(floatToHalf(f)) {}
+
+  /* implicit */ operator float() const {
+    return halfToFloat(bits);
+  }
+};
+
+static_assert(sizeof(float16) == sizeof(Half), "float16 is not packed");
+
+}  // namespace crystal
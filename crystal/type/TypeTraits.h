@@ -27,6 +27,8 @@
 #include <unordered_set>
 #include <vector>
 
+#include "crystal/type/Float16.h"
+
 namespace crystal {
 
 template <class T>
@@ -54,6 +56,7 @@ struct IsFloat: std::false_type {};
 
 template <> struct IsFloat<float> : std::true_type {};
 template <> struct IsFloat<double> : std::true_type {};
+template <> struct IsFloat<float16> : std::true_type {};
 
 template <class T>
 struct IsString: std::false_type {};
@@ -25,11 +25,15 @@ TEST(DataType, all) {
   EXPECT_EQ(1, sizeOf(DataType::INT8));
   EXPECT_EQ(4, sizeOf(DataType::FLOAT));
   EXPECT_EQ(8, sizeOf(DataType::DOUBLE));
+  EXPECT_EQ(2, sizeOf(DataType::FLOAT16));
   EXPECT_EQ(8, sizeOf(DataType::STRING));
 
   EXPECT_TRUE(checkType<bool>(DataType::BOOL));
   EXPECT_TRUE(checkType<int8_t>(DataType::INT8));
   EXPECT_TRUE(checkType<float>(DataType::FLOAT));
   EXPECT_TRUE(checkType<double>(DataType::DOUBLE));
+  EXPECT_TRUE(checkType<float16>(DataType::FLOAT16));
+  EXPECT_TRUE(isFloat(DataType::FLOAT16));
+  EXPECT_EQ(DataType::FLOAT16, stringToDataType("float16"));
   EXPECT_TRUE(checkType<std::string_view>(DataType::STRING));
 }